@@ -108,6 +108,12 @@ for (prb_Iter iter = prb_createIter(); prb_iterNext(&iter) == prb_Success;) {
 #if prb_PLATFORM_WINDOWS
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <psapi.h>
+
+// NOTE(khvorov) WaitOnAddress and friends for the futex-like primitives
+#ifdef _MSC_VER
+#pragma comment(lib, "synchronization.lib")
+#endif
 
 #elif prb_PLATFORM_LINUX
 
@@ -116,6 +122,8 @@ for (prb_Iter iter = prb_createIter(); prb_iterNext(&iter) == prb_Success;) {
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <spawn.h>
 #include <dirent.h>
@@ -123,6 +131,11 @@ for (prb_Iter iter = prb_createIter(); prb_iterNext(&iter) == prb_Success;) {
 #include <time.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <errno.h>
+#include <linux/futex.h>
 
 #endif
 
@@ -317,6 +330,53 @@ typedef struct prb_Bytes {
     int32_t  len;
 } prb_Bytes;
 
+typedef struct prb_FileHash {
+    bool     valid;
+    uint64_t hash;
+} prb_FileHash;
+
+// NOTE(khvorov) Gives the same hash as prb_getFileHash would for the same bytes (on 64-bit platforms)
+typedef struct prb_HashStream {
+    uint64_t v0;
+    uint64_t v1;
+    uint64_t v2;
+    uint64_t v3;
+    // NOTE(khvorov) Short inputs are hashed differently, so the last word waits until more data comes in
+    uint8_t pending[8];
+    int32_t pendingLen;
+    int64_t len;
+} prb_HashStream;
+
+// NOTE(khvorov) Complete environment for child processes, built once and shared between launches
+typedef struct prb_Env {
+    bool valid;
+    // Null-terminated array of "name=value"
+    const char** entries;
+    int32_t      count;
+#if prb_PLATFORM_WINDOWS
+    // NOTE(khvorov) Same entries in the form CreateProcessW wants
+    LPWCH block;
+#endif
+} prb_Env;
+
+typedef enum prb_IoPriorityClass {
+    prb_IoPriorityClass_Inherit,
+    // NOTE(khvorov) Needs privileges
+    prb_IoPriorityClass_Realtime,
+    prb_IoPriorityClass_BestEffort,
+    // NOTE(khvorov) Only gets disk time when nobody else wants it
+    prb_IoPriorityClass_Idle,
+} prb_IoPriorityClass;
+
+typedef enum prb_SchedPolicy {
+    prb_SchedPolicy_Inherit,
+    // NOTE(khvorov) Cpu-bound work that doesn't care about latency, gets longer but rarer time slices
+    prb_SchedPolicy_Batch,
+    // NOTE(khvorov) Only runs when nothing else wants the cpu. On linux this is applied to the child just after it
+    // execs, so the very start of it may still run under the inherited policy
+    prb_SchedPolicy_Idle,
+} prb_SchedPolicy;
+
 typedef struct prb_ProcessSpec {
     bool    redirectStdout;
     prb_Str stdoutFilepath;
@@ -324,6 +384,35 @@ typedef struct prb_ProcessSpec {
     prb_Str stderrFilepath;
     // Additional environment variables that look like this "var1=val1 var2=val2"
     prb_Str addEnv;
+    // Used instead of the current environment, can't be combined with addEnv
+    prb_Env* env;
+    // Collect output in memory instead of writing it anywhere, takes precedence over redirect
+    bool       captureStdout;
+    bool       captureStderr;
+    prb_Arena* captureArena;
+    // Written to the process's stdin while it runs, stdin is closed once all of it is written
+    bool      feedStdin;
+    prb_Bytes stdinBytes;
+    // Hash stdout as it comes in instead of writing it anywhere, the result goes to prb_Process.stdoutHash
+    bool hashStdout;
+    // Collect stdout and stderr together while the process runs and write them to our stdout in one go
+    // once it completes (see prb_writeBufferedOutput), can't be combined with capturing or redirecting
+    bool bufferOutput;
+    // Killing the process also kills everything it launched (e.g. cc1 started by a compiler driver).
+    // Such processes don't get Ctrl-C from the terminal
+    bool ownProcessGroup;
+    // Killed once it runs for longer than this, 0 means no limit
+    float timeoutMs;
+    // Resource usage is recorded this often while the process runs (see prb_ProcessSample), 0 means never.
+    // Needs captureArena
+    float sampleIntervalMs;
+    // Priorities the child starts with. Niceness is added to ours like nice(1) does, negative needs privileges.
+    // Io priority level goes from 0 (highest) to 7 and is ignored for the idle class.
+    // The launch fails when a setting can't be applied
+    int32_t             niceIncrement;
+    prb_IoPriorityClass ioPriorityClass;
+    int32_t             ioPriorityLevel;
+    prb_SchedPolicy     schedPolicy;
 } prb_ProcessSpec;
 
 typedef enum prb_ProcessStatus {
@@ -333,18 +422,126 @@ typedef enum prb_ProcessStatus {
     prb_ProcessStatus_CompletedFailed,
 } prb_ProcessStatus;
 
+typedef struct prb_Argv {
+    // Null-terminated so that it can go to spawn as is
+    const char** args;
+    int32_t      len;
+} prb_Argv;
+
+typedef struct prb_ProcessUsage {
+    // Only wallMs is filled in while the process is running
+    float   wallMs;
+    float   userCpuMs;
+    float   sysCpuMs;
+    int64_t maxRssBytes;
+} prb_ProcessUsage;
+
+typedef struct prb_ProcessSample {
+    // Since launch
+    float timeMs;
+    // Cumulative cpu time and usage since the previous sample, 100% is one core busy the whole time
+    float   cpuMs;
+    float   cpuPercent;
+    int64_t rssBytes;
+    int64_t swapBytes;
+    // NOTE(khvorov) Same for the process and everything it launched. Descendants that exited only count
+    // once their parent waited on them.
+    float   treeCpuMs;
+    float   treeCpuPercent;
+    int64_t treeRssBytes;
+    int64_t treeSwapBytes;
+    int32_t treeProcessCount;
+} prb_ProcessSample;
+
+typedef struct prb_MemoryInfo {
+    bool valid;
+    // NOTE(khvorov) The tighter of the whole system and the cgroup (v2) limits we are under
+    int64_t totalBytes;
+    int64_t availableBytes;
+} prb_MemoryInfo;
+
+typedef struct prb_SystemLoad {
+    bool valid;
+    // NOTE(khvorov) One minute average of runnable processes from /proc/loadavg
+    float loadAverage;
+    // NOTE(khvorov) Percentage of the last 10 seconds some tasks were waiting for a cpu (PSI), not available everywhere
+    bool  cpuPressureValid;
+    float cpuPressure;
+} prb_SystemLoad;
+
+// NOTE(khvorov) Processes created from an argv launch it as is, cmd is not used
 typedef struct prb_Process {
     prb_Str           cmd;
+    prb_Argv          argv;
     prb_ProcessSpec   spec;
     prb_ProcessStatus status;
+    prb_TimeStart     launchTime;
+    prb_ProcessUsage  usage;
+    // How long a process pool held back the launch because of memory or system load
+    float heldBackMs;
+    // Same as prb_getFileHash of the output written to a file, set once the process completes
+    prb_FileHash stdoutHash;
+    // Killed because of spec.timeoutMs or a deadline, or its output was still open when spec.timeoutMs ran out
+    bool timedOut;
+    // Timeline of spec.sampleIntervalMs, grows while the process runs and moves to spec.captureArena once it completes
+    prb_ProcessSample* samples;
+    int32_t            sampleCount;
+    // Null-terminated, allocated in spec.captureArena once the process completes
+    prb_Str capturedStdout;
+    prb_Str capturedStderr;
 
 #if prb_PLATFORM_WINDOWS
     PROCESS_INFORMATION processInfo;
+    // NOTE(khvorov) Only used for processes with their own group, windows has no process groups to kill
+    HANDLE job;
 #elif prb_PLATFORM_LINUX
-    pid_t     pid;
+    pid_t          pid;
+    int            stdoutPipe;
+    int            stderrPipe;
+    uint8_t*       stdoutBuffer;
+    uint8_t*       stderrBuffer;
+    prb_HashStream stdoutHashStream;
+    int            stdinPipe;
+    int32_t        stdinWritten;
+    // NOTE(khvorov) Samples are in an stb ds array until the process completes
+    prb_ProcessSample* sampleBuffer;
+    // NOTE(khvorov) Ends of the pipes connecting pipeline stages. The fds are only looked at when the bools are set
+    // so that a zeroed process is not connected to fd 0.
+    bool hasPipelineStdin;
+    bool hasPipelineStdout;
+    int  pipelineStdin;
+    int  pipelineStdout;
 #endif
 } prb_Process;
 
+typedef struct prb_ProcessCompletionIter {
+    prb_Process* procs;
+    int32_t      procCount;
+    prb_Process* curProc;
+    int32_t      curProcIndex;
+    // Leave buffered output of completed processes for the caller to write with prb_writeBufferedOutput
+    bool holdBufferedOutput;
+    // Launched processes are killed once this much time passes since the iterator was created, 0 means no deadline
+    float         deadlineMs;
+    prb_TimeStart createTime;
+
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) -1 when pidfds are not available (kernels older than 5.3) and the iterator falls back to waitid
+    // and a signalfd for SIGCHLD. The signal can end up with any thread that doesn't block it, so the fallback
+    // still checks on its children every 100ms.
+    int  epollHandle;
+    int* pidfds;
+    // NOTE(khvorov) Pids the pidfds were opened for, a process could be reaped elsewhere and launched again
+    pid_t* pidfdPids;
+    // NOTE(khvorov) Capture and stdin pipes registered with epoll, 3 per process
+    int* pipeHandles;
+    // NOTE(khvorov) Processes seen exiting but not returned yet and how long they ran for, in the order they exited.
+    // They are reaped as they are returned so that they are still there for the next iterator if this one is destroyed
+    int32_t* exitedProcIndices;
+    float*   exitedWallMs;
+#endif
+} prb_ProcessCompletionIter;
+
 typedef enum prb_StrFindMode {
     prb_StrFindMode_Exact,
     prb_StrFindMode_AnyChar,
@@ -422,10 +619,14 @@ typedef struct prb_Multitime {
     uint64_t timeEarliest;
 } prb_Multitime;
 
-typedef struct prb_FileHash {
-    bool     valid;
-    uint64_t hash;
-} prb_FileHash;
+// NOTE(khvorov) Values are the gcc/clang __ATOMIC_* constants so they can be passed straight through
+typedef enum prb_MemoryOrder {
+    prb_MemoryOrder_Relaxed = 0,
+    prb_MemoryOrder_Acquire = 2,
+    prb_MemoryOrder_Release = 3,
+    prb_MemoryOrder_AcqRel = 4,
+    prb_MemoryOrder_SeqCst = 5,
+} prb_MemoryOrder;
 
 typedef enum prb_JobStatus {
     prb_JobStatus_NotLaunched,
@@ -435,12 +636,20 @@ typedef enum prb_JobStatus {
 
 typedef void (*prb_JobProc)(prb_Arena* arena, void* data);
 
+// NOTE(khvorov) Called for [from, to) ranges. Scratch is reset after every call
+typedef void (*prb_ParallelForProc)(prb_Arena* scratch, void* data, int32_t from, int32_t to);
+
 typedef struct prb_Job {
     prb_Arena     arena;
     prb_JobProc   proc;
     void*         data;
     prb_JobStatus status;
 
+    // NOTE(khvorov) When set, prb_launchJobs hands the job to the pool instead of creating a thread for it
+    struct prb_ThreadPool* pool;
+    struct prb_Job*        poolNext;
+    int32_t                poolCompleted;
+
 #if prb_PLATFORM_WINDOWS
     HANDLE threadhandle;
     DWORD  threadid;
@@ -451,11 +660,269 @@ typedef struct prb_Job {
 #endif
 } prb_Job;
 
+// NOTE(khvorov) Chase-Lev deque. Only the owning worker pushes and takes at the bottom,
+// other threads steal from the top
+typedef struct prb_ThreadPoolDeque {
+    alignas(64) int64_t top;
+    alignas(64) int64_t bottom;
+    prb_Job** buffer;
+    int64_t   capacity;
+} prb_ThreadPoolDeque;
+
+typedef struct prb_ThreadPoolWorker {
+    struct prb_ThreadPool* pool;
+    int32_t                index;
+    prb_ThreadPoolDeque    deque;
+    // NOTE(khvorov) Only touched from the worker's own thread, prb_parallelFor chunks run in it
+    prb_Arena scratch;
+
+#if prb_PLATFORM_WINDOWS
+    HANDLE threadhandle;
+    DWORD  threadid;
+#elif prb_PLATFORM_LINUX
+    pthread_t threadid;
+#else
+#error unimplemented
+#endif
+} prb_ThreadPoolWorker;
+
+typedef struct prb_ThreadPool {
+    bool                  valid;
+    prb_ThreadPoolWorker* workers;
+    int32_t               workerCount;
+
+    // NOTE(khvorov) Submitted jobs nobody has picked up yet, workers only go to sleep when this is 0
+    alignas(64) int32_t pendingJobCount;
+    alignas(64) int32_t sleeperCount;
+    int32_t waiterCount;
+
+    // NOTE(khvorov) Everything below is protected by the lock. The inject list holds jobs
+    // submitted from outside the pool and the ones that did not fit into a worker's deque
+    bool     shutdown;
+    prb_Job* injectHead;
+    prb_Job* injectTail;
+    int32_t  injectCount;
+
+#if prb_PLATFORM_WINDOWS
+    SRWLOCK            lock;
+    CONDITION_VARIABLE workCond;
+    CONDITION_VARIABLE doneCond;
+#elif prb_PLATFORM_LINUX
+    pthread_mutex_t lock;
+    pthread_cond_t  workCond;
+    pthread_cond_t  doneCond;
+#else
+#error unimplemented
+#endif
+} prb_ThreadPool;
+
+typedef enum prb_JobGraphNodeKind {
+    prb_JobGraphNodeKind_Job,
+    prb_JobGraphNodeKind_Process,
+} prb_JobGraphNodeKind;
+
+typedef enum prb_JobGraphNodeStatus {
+    prb_JobGraphNodeStatus_NotStarted,
+    prb_JobGraphNodeStatus_Running,
+    prb_JobGraphNodeStatus_Completed,
+    prb_JobGraphNodeStatus_Failed,
+    // One of the dependencies failed so this one never ran
+    prb_JobGraphNodeStatus_Skipped,
+} prb_JobGraphNodeStatus;
+
+typedef struct prb_JobGraphNode {
+    prb_JobGraphNodeKind kind;
+    prb_Job*             job;
+    prb_Process*         process;
+    // Expected run time in whatever units, only used to decide what to start first. 0 counts as 1
+    float cost;
+    // stb array of indices of nodes that have to complete before this one starts
+    int32_t*               deps;
+    prb_JobGraphNodeStatus status;
+    // Cost of this node plus the most expensive chain of nodes waiting on it
+    float criticalPathCost;
+} prb_JobGraphNode;
+
+typedef struct prb_JobGraph {
+    // stb array
+    prb_JobGraphNode* nodes;
+} prb_JobGraph;
+
+typedef struct prb_MpmcQueueCell {
+    int64_t sequence;
+    void*   value;
+} prb_MpmcQueueCell;
+
+// NOTE(khvorov) Dmitry Vyukov's bounded queue. Any number of threads can push and pop,
+// the two ends sit on their own cache lines so producers and consumers don't slow each other down
+typedef struct prb_MpmcQueue {
+    prb_MpmcQueueCell*  cells;
+    int64_t             mask;
+    alignas(64) int64_t pushPos;
+    alignas(64) int64_t popPos;
+} prb_MpmcQueue;
+
+typedef struct prb_MpmcQueuePopResult {
+    bool  success;
+    void* value;
+} prb_MpmcQueuePopResult;
+
+// NOTE(khvorov) Synchronization primitives below sit on a single futex word (WaitOnAddress on windows)
+// and never make a syscall when nobody has to wait. Zero initialized mutex and event are ready to use
+
+// NOTE(khvorov) 0 unlocked, 1 locked, 2 locked and somebody might be waiting
+typedef struct prb_Mutex {
+    int32_t state;
+} prb_Mutex;
+
+typedef struct prb_Semaphore {
+    int32_t count;
+    int32_t waiterCount;
+} prb_Semaphore;
+
+// NOTE(khvorov) Manual reset. 0 not set, 1 set, 2 not set and somebody might be waiting
+typedef struct prb_Event {
+    int32_t state;
+} prb_Event;
+
+// NOTE(khvorov) Waiters are released once the count gets to 0, can't be reused after that
+typedef struct prb_Latch {
+    int32_t count;
+} prb_Latch;
+
 typedef enum prb_Background {
     prb_Background_No,
     prb_Background_Yes,
 } prb_Background;
 
+typedef enum prb_JobserverKind {
+    prb_JobserverKind_Fifo,
+    prb_JobserverKind_Pipe,
+} prb_JobserverKind;
+
+// NOTE(khvorov) GNU make jobserver. Every process owns one implicit token,
+// the rest are bytes in a fifo/pipe (a named semaphore on windows)
+typedef struct prb_Jobserver {
+    bool    valid;
+    bool    isServer;
+    bool    implicitTokenTaken;
+    int32_t heldTokenCount;
+    // What children need in MAKEFLAGS to find this jobserver, exported while the server exists
+    prb_Str makeflags;
+    bool    prevMakeflagsFound;
+    prb_Str prevMakeflags;
+
+    // NOTE(khvorov) Pools on different threads can share a jobserver, the lock is for the token bookkeeping
+#if prb_PLATFORM_WINDOWS
+    HANDLE  semaphore;
+    SRWLOCK lock;
+#elif prb_PLATFORM_LINUX
+    pthread_mutex_t lock;
+    // NOTE(khvorov) Our own non-blocking open of the read end so that reads in children stay blocking
+    int             readHandle;
+    int             writeHandle;
+    int             pipeHandles[2];
+    prb_Str         fifoPath;
+    uint8_t*        heldTokens;
+#endif
+} prb_Jobserver;
+
+typedef struct prb_ProcessPoolSpec {
+    // Maximum number of processes running at the same time, when 0 the allowed core count is used
+    // (or no limit other than the jobserver if there is one)
+    int32_t maxInFlight;
+    // Every process in the pool holds a token while running
+    prb_Jobserver* jobserver;
+    // Kill everything that's running and don't launch anything else after the first failure
+    bool failFast;
+    // Kill everything that's running and don't launch anything else once this much time passes, 0 means no deadline
+    float deadlineMs;
+    // NOTE(khvorov) With failFast or a deadline every process gets its own group (prb_ProcessSpec.ownProcessGroup)
+    // so that killing it doesn't leave behind whatever it launched
+    // Hold new launches while the memory they could take doesn't fit in what's available (see prb_getMemoryInfo).
+    // A process is expected to take as much as the largest peak seen in the pool so far, but at least memoryPerProcessBytes
+    bool    throttleOnMemory;
+    int64_t memoryPerProcessBytes;
+    // Hold new launches while the system is this loaded (see prb_getSystemLoad), 0 means no limit.
+    // Like make -l, processes launched during the last second count towards the load right away
+    float maxLoad;
+    float maxCpuPressure;
+    // Buffered output (prb_ProcessSpec.bufferOutput) is written in the order the processes are in
+    // rather than the order they complete
+    bool outputInLaunchOrder;
+} prb_ProcessPoolSpec;
+
+// NOTE(khvorov) Requests go to the worker's stdin and responses come back from its stdout. Every message is
+// a little-endian u32 length followed by that many bytes. A request is a u32 arg count, every arg as
+// a u32 length and its bytes, then a u32 input length and the input. A response is an i32 exit code
+// followed by the output, which takes up the rest of the message.
+typedef struct prb_WorkerRequest {
+    bool      valid;
+    prb_Str*  args;
+    int32_t   argCount;
+    prb_Bytes input;
+} prb_WorkerRequest;
+
+typedef struct prb_WorkerResponse {
+    bool      received;
+    int32_t   exitCode;
+    prb_Bytes output;
+} prb_WorkerResponse;
+
+typedef struct prb_WorkerJob {
+    prb_WorkerRequest  request;
+    prb_WorkerResponse response;
+    // Index of the worker that was sent the request last, -1 if it was never sent
+    int32_t workerIndex;
+    // How many workers started on the request, it's sent again when a worker crashes before responding
+    int32_t attempts;
+} prb_WorkerJob;
+
+typedef struct prb_WorkerPoolSpec {
+    // When 0 the allowed core count is used
+    int32_t workerCount;
+    // Requests a worker can be sent before it responds to the first one, 0 means 1.
+    // Workers respond to requests in the order they get them
+    int32_t maxInFlightPerWorker;
+    // Crashed workers are started again up to this many times over the life of the pool
+    int32_t maxRestarts;
+    // A request is sent again up to this many times when workers crash before responding to it
+    int32_t maxRetries;
+    // Stdin and stdout are taken by the protocol, so capturing, buffering, hashing and feeding are not allowed.
+    // Nothing reads stderr while jobs run either, so it can't be captured (a full pipe would stall the worker),
+    // redirect it to a file instead
+    prb_ProcessSpec processSpec;
+} prb_WorkerPoolSpec;
+
+typedef struct prb_Worker {
+    prb_Process process;
+    // How many times the worker was started, restarts included
+    int32_t startCount;
+
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) Our ends of the protocol pipes, -1 when the worker is not running
+    int      requestPipe;
+    int      responsePipe;
+    uint8_t* sendBuffer;
+    int32_t  sentBytes;
+    uint8_t* receiveBuffer;
+    // NOTE(khvorov) Job indices in the order the requests were sent
+    int32_t* inFlight;
+#endif
+} prb_Worker;
+
+// NOTE(khvorov) Long-lived helper processes that take requests one after the other instead of
+// paying for a launch every time (like bazel's persistent workers)
+typedef struct prb_WorkerPool {
+    bool               valid;
+    prb_Argv           argv;
+    prb_WorkerPoolSpec spec;
+    prb_Worker*        workers;
+    int32_t            workerCount;
+    int32_t            restartCount;
+    int32_t            nextWorkerIndex;
+} prb_WorkerPool;
+
 typedef struct prb_ParseUintResult {
     bool     success;
     uint64_t number;
@@ -488,6 +955,11 @@ typedef struct prb_ReadEntireFileResult {
     prb_Bytes content;
 } prb_ReadEntireFileResult;
 
+typedef struct prb_FindExecutableResult {
+    bool    found;
+    prb_Str path;
+} prb_FindExecutableResult;
+
 typedef struct prb_GetenvResult {
     bool    found;
     prb_Str str;
@@ -539,6 +1011,9 @@ prb_PUBLICDEC void                     prb_multitimeAdd(prb_Multitime* multitime
 prb_PUBLICDEC prb_ReadEntireFileResult prb_readEntireFile(prb_Arena* arena, prb_Str path);
 prb_PUBLICDEC prb_Status               prb_writeEntireFile(prb_Arena* arena, prb_Str path, const void* content, int32_t contentLen);
 prb_PUBLICDEC prb_FileHash             prb_getFileHash(prb_Arena* arena, prb_Str filepath);
+prb_PUBLICDEC prb_HashStream           prb_createHashStream(void);
+prb_PUBLICDEC void                     prb_hashStreamAdd(prb_HashStream* stream, const void* data, int32_t len);
+prb_PUBLICDEC uint64_t                 prb_hashStreamEnd(prb_HashStream* stream);
 
 // SECTION Strings
 prb_PUBLICDEC bool                prb_streq(prb_Str str1, prb_Str str2);
@@ -568,31 +1043,100 @@ prb_PUBLICDEC prb_ParsedNumber    prb_parseNumber(prb_Str str);
 prb_PUBLICDEC prb_Str             prb_binaryToCArray(prb_Arena* arena, prb_Str arrayName, void* data, int32_t dataLen);
 
 // SECTION Processes
-prb_PUBLICDEC void                prb_terminate(int32_t code);
-prb_PUBLICDEC prb_Str             prb_getCmdline(prb_Arena* arena);
-prb_PUBLICDEC prb_Str*            prb_getCmdArgs(prb_Arena* arena);
-prb_PUBLICDEC const char**        prb_getArgArrayFromStr(prb_Arena* arena, prb_Str str);
-prb_PUBLICDEC prb_CoreCountResult prb_getCoreCount(prb_Arena* arena);
-prb_PUBLICDEC prb_CoreCountResult prb_getAllowExecutionCoreCount(prb_Arena* arena);
-prb_PUBLICDEC prb_Status          prb_allowExecutionOnCores(prb_Arena* arena, int32_t coreCount);
-prb_PUBLICDEC prb_Process         prb_createProcess(prb_Str cmd, prb_ProcessSpec spec);
-prb_PUBLICDEC prb_Status          prb_launchProcesses(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_Background mode);
-prb_PUBLICDEC prb_Status          prb_waitForProcesses(prb_Process* handles, int32_t handleCount);
-prb_PUBLICDEC prb_Status          prb_killProcesses(prb_Process* handles, int32_t handleCount);
-prb_PUBLICDEC void                prb_sleep(float ms);
-prb_PUBLICDEC bool                prb_debuggerPresent(prb_Arena* arena);
-prb_PUBLICDEC prb_Status          prb_setenv(prb_Arena* arena, prb_Str name, prb_Str value);
-prb_PUBLICDEC prb_GetenvResult    prb_getenv(prb_Arena* arena, prb_Str name);
-prb_PUBLICDEC prb_Status          prb_unsetenv(prb_Arena* arena, prb_Str name);
+prb_PUBLICDEC void                      prb_terminate(int32_t code);
+prb_PUBLICDEC prb_Str                   prb_getCmdline(prb_Arena* arena);
+prb_PUBLICDEC prb_Str*                  prb_getCmdArgs(prb_Arena* arena);
+prb_PUBLICDEC const char**              prb_getArgArrayFromStr(prb_Arena* arena, prb_Str str);
+prb_PUBLICDEC prb_Argv                  prb_createArgv(prb_Arena* arena, prb_Str cmd);
+prb_PUBLICDEC prb_Argv                  prb_argvConcat(prb_Arena* arena, prb_Argv prefix, prb_Str* args, int32_t argCount);
+prb_PUBLICDEC prb_Str                   prb_argvToStr(prb_Arena* arena, prb_Argv argv);
+prb_PUBLICDEC prb_FindExecutableResult  prb_findExecutable(prb_Arena* arena, prb_Str name);
+prb_PUBLICDEC prb_CoreCountResult       prb_getCoreCount(prb_Arena* arena);
+prb_PUBLICDEC prb_CoreCountResult       prb_getAllowExecutionCoreCount(prb_Arena* arena);
+prb_PUBLICDEC prb_Status                prb_allowExecutionOnCores(prb_Arena* arena, int32_t coreCount);
+prb_PUBLICDEC prb_Process               prb_createProcess(prb_Str cmd, prb_ProcessSpec spec);
+prb_PUBLICDEC prb_Status                prb_launchProcesses(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_Background mode);
+prb_PUBLICDEC prb_Status                prb_waitForProcesses(prb_Process* handles, int32_t handleCount);
+prb_PUBLICDEC prb_Status                prb_killProcesses(prb_Process* handles, int32_t handleCount);
+prb_PUBLICDEC prb_Process               prb_createProcessArgv(prb_Argv argv, prb_ProcessSpec spec);
+prb_PUBLICDEC prb_ProcessUsage          prb_getProcessUsage(prb_Process* proc);
+prb_PUBLICDEC prb_MemoryInfo            prb_getMemoryInfo(prb_Arena* arena);
+prb_PUBLICDEC int64_t                   prb_getProcessMemory(prb_Arena* arena, prb_Process* proc);
+prb_PUBLICDEC prb_SystemLoad            prb_getSystemLoad(prb_Arena* arena);
+prb_PUBLICDEC prb_Status                prb_launchProcessPool(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_ProcessPoolSpec spec);
+prb_PUBLICDEC prb_Status                prb_launchPipeline(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_Background mode);
+prb_PUBLICDEC prb_Status                prb_launchProcessesOnThreads(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_ThreadPool* pool, prb_Background mode);
+prb_PUBLICDEC prb_ProcessCompletionIter prb_createProcessCompletionIter(prb_Process* procs, int32_t procCount);
+prb_PUBLICDEC prb_Status                prb_processCompletionIterNext(prb_ProcessCompletionIter* iter);
+prb_PUBLICDEC void                      prb_destroyProcessCompletionIter(prb_ProcessCompletionIter* iter);
+prb_PUBLICDEC int32_t                   prb_waitForAnyProcess(prb_Process* handles, int32_t handleCount);
+prb_PUBLICDEC prb_Status                prb_writeBufferedOutput(prb_Process* procs, int32_t procCount);
+prb_PUBLICDEC prb_WorkerPool            prb_createWorkerPool(prb_Arena* arena, prb_Argv argv, prb_WorkerPoolSpec spec);
+prb_PUBLICDEC prb_Status                prb_runWorkerJobs(prb_Arena* arena, prb_WorkerPool* pool, prb_WorkerJob* jobs, int32_t jobCount);
+prb_PUBLICDEC void                      prb_destroyWorkerPool(prb_WorkerPool* pool);
+prb_PUBLICDEC prb_WorkerRequest         prb_readWorkerRequest(prb_Arena* arena);
+prb_PUBLICDEC prb_Status                prb_writeWorkerResponse(int32_t exitCode, prb_Bytes output);
+prb_PUBLICDEC prb_Jobserver             prb_createJobserver(prb_Arena* arena, int32_t tokenCount, prb_JobserverKind kind);
+prb_PUBLICDEC prb_Jobserver             prb_connectJobserver(prb_Arena* arena);
+prb_PUBLICDEC prb_Status                prb_jobserverAcquire(prb_Jobserver* jobserver);
+prb_PUBLICDEC prb_Status                prb_jobserverTryAcquire(prb_Jobserver* jobserver);
+prb_PUBLICDEC prb_Status                prb_jobserverRelease(prb_Jobserver* jobserver);
+prb_PUBLICDEC void                      prb_destroyJobserver(prb_Arena* arena, prb_Jobserver* jobserver);
+prb_PUBLICDEC void                      prb_sleep(float ms);
+prb_PUBLICDEC bool                      prb_debuggerPresent(prb_Arena* arena);
+prb_PUBLICDEC prb_Status                prb_setenv(prb_Arena* arena, prb_Str name, prb_Str value);
+prb_PUBLICDEC prb_GetenvResult          prb_getenv(prb_Arena* arena, prb_Str name);
+prb_PUBLICDEC prb_Status                prb_unsetenv(prb_Arena* arena, prb_Str name);
+prb_PUBLICDEC prb_Env                   prb_createEnv(prb_Arena* arena, prb_Str addEnv);
 
 // SECTION Timing
 prb_PUBLICDEC prb_TimeStart prb_timeStart(void);
 prb_PUBLICDEC float         prb_getMsFrom(prb_TimeStart timeStart);
 
 // SECTION Multithreading
-prb_PUBLICDEC prb_Job    prb_createJob(prb_JobProc proc, void* data, prb_Arena* arena, int32_t arenaBytes);
-prb_PUBLICDEC prb_Status prb_launchJobs(prb_Job* jobs, int32_t jobsCount, prb_Background mode);
-prb_PUBLICDEC prb_Status prb_waitForJobs(prb_Job* jobs, int32_t jobsCount);
+prb_PUBLICDEC int32_t                prb_atomicLoadI32(int32_t* ptr, prb_MemoryOrder order);
+prb_PUBLICDEC void                   prb_atomicStoreI32(int32_t* ptr, int32_t value, prb_MemoryOrder order);
+prb_PUBLICDEC int32_t                prb_atomicExchangeI32(int32_t* ptr, int32_t value, prb_MemoryOrder order);
+prb_PUBLICDEC bool                   prb_atomicCasI32(int32_t* ptr, int32_t* expected, int32_t desired, prb_MemoryOrder order);
+prb_PUBLICDEC int32_t                prb_atomicFetchAddI32(int32_t* ptr, int32_t value, prb_MemoryOrder order);
+prb_PUBLICDEC int64_t                prb_atomicLoadI64(int64_t* ptr, prb_MemoryOrder order);
+prb_PUBLICDEC void                   prb_atomicStoreI64(int64_t* ptr, int64_t value, prb_MemoryOrder order);
+prb_PUBLICDEC int64_t                prb_atomicExchangeI64(int64_t* ptr, int64_t value, prb_MemoryOrder order);
+prb_PUBLICDEC bool                   prb_atomicCasI64(int64_t* ptr, int64_t* expected, int64_t desired, prb_MemoryOrder order);
+prb_PUBLICDEC int64_t                prb_atomicFetchAddI64(int64_t* ptr, int64_t value, prb_MemoryOrder order);
+prb_PUBLICDEC void*                  prb_atomicLoadPtr(void** ptr, prb_MemoryOrder order);
+prb_PUBLICDEC void                   prb_atomicStorePtr(void** ptr, void* value, prb_MemoryOrder order);
+prb_PUBLICDEC void*                  prb_atomicExchangePtr(void** ptr, void* value, prb_MemoryOrder order);
+prb_PUBLICDEC bool                   prb_atomicCasPtr(void** ptr, void** expected, void* desired, prb_MemoryOrder order);
+prb_PUBLICDEC void                   prb_atomicFence(prb_MemoryOrder order);
+prb_PUBLICDEC prb_Job                prb_createJob(prb_JobProc proc, void* data, prb_Arena* arena, int32_t arenaBytes);
+prb_PUBLICDEC prb_Status             prb_launchJobs(prb_Job* jobs, int32_t jobsCount, prb_Background mode);
+prb_PUBLICDEC prb_Status             prb_waitForJobs(prb_Job* jobs, int32_t jobsCount);
+prb_PUBLICDEC prb_ThreadPool*        prb_createThreadPool(prb_Arena* arena, int32_t threadCount, int32_t scratchBytes);
+prb_PUBLICDEC void                   prb_destroyThreadPool(prb_ThreadPool* pool);
+prb_PUBLICDEC int32_t                prb_jobGraphAddJob(prb_JobGraph* graph, prb_Job* job, float cost);
+prb_PUBLICDEC int32_t                prb_jobGraphAddProcess(prb_JobGraph* graph, prb_Process* proc, float cost);
+prb_PUBLICDEC void                   prb_jobGraphAddDep(prb_JobGraph* graph, int32_t nodeIndex, int32_t depIndex);
+prb_PUBLICDEC prb_Status             prb_runJobGraph(prb_Arena* arena, prb_JobGraph* graph, prb_ThreadPool* pool);
+prb_PUBLICDEC void                   prb_destroyJobGraph(prb_JobGraph* graph);
+prb_PUBLICDEC void                   prb_parallelFor(prb_Arena* arena, prb_ThreadPool* pool, int32_t count, int32_t grainSize, prb_ParallelForProc proc, void* data);
+prb_PUBLICDEC prb_MpmcQueue          prb_createMpmcQueue(prb_Arena* arena, int32_t capacity);
+prb_PUBLICDEC prb_Status             prb_mpmcQueuePush(prb_MpmcQueue* queue, void* value);
+prb_PUBLICDEC prb_MpmcQueuePopResult prb_mpmcQueuePop(prb_MpmcQueue* queue);
+prb_PUBLICDEC void                   prb_mutexLock(prb_Mutex* mutex);
+prb_PUBLICDEC prb_Status             prb_mutexTryLock(prb_Mutex* mutex);
+prb_PUBLICDEC void                   prb_mutexUnlock(prb_Mutex* mutex);
+prb_PUBLICDEC prb_Semaphore          prb_createSemaphore(int32_t count);
+prb_PUBLICDEC void                   prb_semaphoreWait(prb_Semaphore* sem);
+prb_PUBLICDEC prb_Status             prb_semaphoreTryWait(prb_Semaphore* sem);
+prb_PUBLICDEC void                   prb_semaphorePost(prb_Semaphore* sem, int32_t count);
+prb_PUBLICDEC void                   prb_eventSet(prb_Event* event);
+prb_PUBLICDEC void                   prb_eventReset(prb_Event* event);
+prb_PUBLICDEC void                   prb_eventWait(prb_Event* event);
+prb_PUBLICDEC bool                   prb_eventIsSet(prb_Event* event);
+prb_PUBLICDEC prb_Latch              prb_createLatch(int32_t count);
+prb_PUBLICDEC void                   prb_latchCountDown(prb_Latch* latch, int32_t count);
+prb_PUBLICDEC void                   prb_latchWait(prb_Latch* latch);
 
 // SECTION Random numbers
 prb_PUBLICDEC prb_Rng  prb_createRng(uint32_t seed);
@@ -1026,6 +1570,12 @@ prb_stbds_shmode_func_wrapper(T*, size_t elemsize, int mode) {
 
 #ifndef prb_NO_IMPLEMENTATION
 
+#ifdef _MSC_VER
+#define prb_THREAD_LOCAL __declspec(thread)
+#else
+#define prb_THREAD_LOCAL __thread
+#endif
+
 //
 // SECTION Memory (implementation)
 //
@@ -1286,7 +1836,7 @@ prb_linux_readFromHandle(prb_Arena* arena, int handle) {
     int32_t size = 0;
     for (;;) {
         int readRes = read(handle, prb_arenaFreePtr(arena), prb_arenaFreeSize(arena));
-        if (readRes == 0) {
+        if (readRes <= 0) {
             break;
         }
         size += readRes;
@@ -1967,6 +2517,120 @@ prb_getFileHash(prb_Arena* arena, prb_Str filepath) {
     return result;
 }
 
+// NOTE(khvorov) The hash stream is the siphash from stb ds done a bit at a time
+#ifdef prb_STBDS_SIPHASH_2_4
+#define prb_HASHSTREAM_C_ROUNDS 2
+#define prb_HASHSTREAM_D_ROUNDS 4
+#else
+#define prb_HASHSTREAM_C_ROUNDS 1
+#define prb_HASHSTREAM_D_ROUNDS 1
+#endif
+
+#define prb_HASHSTREAM_ROTATE_LEFT(val, n) (((val) << (n)) | ((val) >> (64 - (n))))
+
+static void
+prb_hashStreamRounds(prb_HashStream* stream, uint64_t data, int32_t rounds) {
+    stream->v3 ^= data;
+    for (int32_t roundIndex = 0; roundIndex < rounds; roundIndex++) {
+        stream->v0 += stream->v1;
+        stream->v1 = prb_HASHSTREAM_ROTATE_LEFT(stream->v1, 13);
+        stream->v1 ^= stream->v0;
+        stream->v0 = prb_HASHSTREAM_ROTATE_LEFT(stream->v0, 32);
+        stream->v2 += stream->v3;
+        stream->v3 = prb_HASHSTREAM_ROTATE_LEFT(stream->v3, 16);
+        stream->v3 ^= stream->v2;
+        stream->v2 += stream->v1;
+        stream->v1 = prb_HASHSTREAM_ROTATE_LEFT(stream->v1, 17);
+        stream->v1 ^= stream->v2;
+        stream->v2 = prb_HASHSTREAM_ROTATE_LEFT(stream->v2, 32);
+        stream->v0 += stream->v3;
+        stream->v3 = prb_HASHSTREAM_ROTATE_LEFT(stream->v3, 21);
+        stream->v3 ^= stream->v0;
+    }
+    stream->v0 ^= data;
+}
+
+static uint64_t
+prb_hashStreamReadWord(const uint8_t* d) {
+    uint64_t result = (uint64_t)d[0] | ((uint64_t)d[1] << 8) | ((uint64_t)d[2] << 16) | ((uint64_t)d[3] << 24)
+        | ((uint64_t)d[4] << 32) | ((uint64_t)d[5] << 40) | ((uint64_t)d[6] << 48) | ((uint64_t)d[7] << 56);
+    return result;
+}
+
+prb_PUBLICDEF prb_HashStream
+prb_createHashStream(void) {
+    // NOTE(khvorov) Seed is 1 like in prb_getFileHash
+    uint64_t       seed = 1;
+    prb_HashStream stream = {};
+    stream.v0 = 0x736f6d6570736575ull ^ seed;
+    stream.v1 = 0x646f72616e646f6dull ^ ~seed;
+    stream.v2 = 0x6c7967656e657261ull ^ seed;
+    stream.v3 = 0x7465646279746573ull ^ ~seed;
+    return stream;
+}
+
+prb_PUBLICDEF void
+prb_hashStreamAdd(prb_HashStream* stream, const void* data, int32_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    int32_t        offset = 0;
+    while (offset < len) {
+        if (stream->pendingLen == 8) {
+            prb_hashStreamRounds(stream, prb_hashStreamReadWord(stream->pending), prb_HASHSTREAM_C_ROUNDS);
+            stream->pendingLen = 0;
+        }
+        if (stream->pendingLen == 0) {
+            while (len - offset > 8) {
+                prb_hashStreamRounds(stream, prb_hashStreamReadWord(bytes + offset), prb_HASHSTREAM_C_ROUNDS);
+                offset += 8;
+            }
+        }
+        int32_t copyLen = prb_min(8 - stream->pendingLen, len - offset);
+        prb_memcpy(stream->pending + stream->pendingLen, bytes + offset, copyLen);
+        stream->pendingLen += copyLen;
+        offset += copyLen;
+    }
+    stream->len += len;
+}
+
+prb_PUBLICDEF uint64_t
+prb_hashStreamEnd(prb_HashStream* stream) {
+    uint64_t result = 0;
+    if (stream->len <= 8) {
+        result = prb_stbds_hash_bytes(stream->pending, (size_t)stream->len, (size_t)1);
+    } else {
+        if (stream->pendingLen == 8) {
+            prb_hashStreamRounds(stream, prb_hashStreamReadWord(stream->pending), prb_HASHSTREAM_C_ROUNDS);
+            stream->pendingLen = 0;
+        }
+
+        // NOTE(khvorov) stb ds sign-extends the 4th byte of the tail, has to be the same here
+        const uint8_t* d = stream->pending;
+        uint64_t       data = (uint64_t)stream->len << 56;
+        switch (stream->pendingLen) {
+            case 7: data |= (uint64_t)d[6] << 48; prb_FALLTHROUGH;  // fall through
+            case 6: data |= (uint64_t)d[5] << 40; prb_FALLTHROUGH;  // fall through
+            case 5: data |= (uint64_t)d[4] << 32; prb_FALLTHROUGH;  // fall through
+            case 4: data |= (uint64_t)(int64_t)(int32_t)((uint32_t)d[3] << 24); prb_FALLTHROUGH;  // fall through
+            case 3: data |= (uint64_t)d[2] << 16; prb_FALLTHROUGH;  // fall through
+            case 2: data |= (uint64_t)d[1] << 8; prb_FALLTHROUGH;  // fall through
+            case 1: data |= (uint64_t)d[0]; prb_FALLTHROUGH;  // fall through
+            case 0: break;
+        }
+        prb_hashStreamRounds(stream, data, prb_HASHSTREAM_C_ROUNDS);
+        stream->v2 ^= 0xff;
+        for (int32_t roundIndex = 0; roundIndex < prb_HASHSTREAM_D_ROUNDS; roundIndex++) {
+            prb_hashStreamRounds(stream, 0, 1);
+        }
+
+#ifdef prb_STBDS_SIPHASH_2_4
+        result = stream->v0 ^ stream->v1 ^ stream->v2 ^ stream->v3;
+#else
+        result = stream->v1 ^ stream->v2 ^ stream->v3;
+#endif
+    }
+    return result;
+}
+
 //
 // SECTION Strings (implementation)
 //
@@ -2659,9 +3323,30 @@ prb_binaryToCArray(prb_Arena* arena, prb_Str arrayName, void* data, int32_t data
 
 #if prb_PLATFORM_WINDOWS
 
+static bool
+prb_windows_sendKill(prb_Process* handle) {
+    bool result = false;
+    if (handle->job) {
+        result = TerminateJobObject(handle->job, 9);
+    } else {
+        result = TerminateProcess(handle->processInfo.hProcess, 9);
+    }
+    return result;
+}
+
 static void
 prb_windows_waitForProcess(prb_Process* handle) {
-    WaitForSingleObject(handle->processInfo.hProcess, INFINITE);
+    DWORD timeout = INFINITE;
+    if (handle->spec.timeoutMs > 0) {
+        float remainingMs = handle->spec.timeoutMs - prb_getMsFrom(handle->launchTime);
+        timeout = remainingMs > 0 ? (DWORD)remainingMs + 1 : 0;
+    }
+    if (WaitForSingleObject(handle->processInfo.hProcess, timeout) == WAIT_TIMEOUT) {
+        handle->timedOut = true;
+        prb_windows_sendKill(handle);
+        WaitForSingleObject(handle->processInfo.hProcess, INFINITE);
+    }
+    handle->usage.wallMs = prb_getMsFrom(handle->launchTime);
     handle->status = prb_ProcessStatus_CompletedFailed;
     DWORD exitCode = 0;
     if (GetExitCodeProcess(handle->processInfo.hProcess, &exitCode)) {
@@ -2669,8 +3354,26 @@ prb_windows_waitForProcess(prb_Process* handle) {
             handle->status = prb_ProcessStatus_CompletedSuccess;
         }
     }
+
+    // NOTE(khvorov) FILETIME durations are in 100ns units
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(handle->processInfo.hProcess, &creationTime, &exitTime, &kernelTime, &userTime)) {
+        uint64_t kernel100ns = ((uint64_t)kernelTime.dwHighDateTime << 32) | (uint64_t)kernelTime.dwLowDateTime;
+        uint64_t user100ns = ((uint64_t)userTime.dwHighDateTime << 32) | (uint64_t)userTime.dwLowDateTime;
+        handle->usage.sysCpuMs = (float)((double)kernel100ns / 10000.0);
+        handle->usage.userCpuMs = (float)((double)user100ns / 10000.0);
+    }
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    if (K32GetProcessMemoryInfo(handle->processInfo.hProcess, &memoryCounters, sizeof(memoryCounters))) {
+        handle->usage.maxRssBytes = (int64_t)memoryCounters.PeakWorkingSetSize;
+    }
+
     CloseHandle(handle->processInfo.hProcess);
     CloseHandle(handle->processInfo.hThread);
+    if (handle->job) {
+        CloseHandle(handle->job);
+        handle->job = 0;
+    }
 }
 
 typedef struct prb_windows_GetAffinityResult {
@@ -2708,945 +3411,5083 @@ prb_linux_readFromProc(prb_Arena* arena, prb_Str filename) {
     return content;
 }
 
-static void
-prb_linux_waitForProcess(prb_Process* handle) {
-    int32_t status = 0;
-    pid_t waitResult = waitpid(handle->pid, &status, 0);
-    handle->status = prb_ProcessStatus_CompletedFailed;
-    if (waitResult == handle->pid && status == 0) {
-        handle->status = prb_ProcessStatus_CompletedSuccess;
+// NOTE(khvorov) Empty when the file can't be opened, e.g. when the process it describes has exited
+static prb_Str
+prb_linux_readSmallFile(prb_Arena* arena, prb_Str path) {
+    prb_Str              result = {};
+    prb_linux_OpenResult handle = prb_linux_open(arena, path, O_RDONLY, 0);
+    if (handle.success) {
+        result = prb_strFromBytes(prb_linux_readFromHandle(arena, handle.handle));
+        close(handle.handle);
     }
+    return result;
 }
 
-typedef struct prb_linux_GetAffinityResult {
-    bool success;
-    uint8_t* affinity;
-    int32_t size;
-    int32_t setBits;
-} prb_linux_GetAffinityResult;
-
-static prb_linux_GetAffinityResult
-prb_linux_getAffinity(prb_Arena* arena) {
-    // NOTE(khvorov) The syscall is picky about alignment and can't handle buffers that are too big.
-    // I don't know how big is too big but a megabyte is apparently not too big.
-    prb_linux_GetAffinityResult result = {};
-    int32_t reqAlign = prb_alignof(unsigned long);
-    prb_arenaAlignFreePtr(arena, reqAlign);
-    result.affinity = (uint8_t*)prb_arenaFreePtr(arena);
-    int32_t arenaSize = (int32_t)prb_min(prb_arenaFreeSize(arena), INT32_MAX);
-    int32_t arenaSizeAligned = arenaSize & (~(reqAlign - 1));
-    int32_t sizeReduced = prb_min(arenaSizeAligned, prb_MEGABYTE);
-    result.size = syscall(SYS_sched_getaffinity, 0, sizeReduced, result.affinity);
-    if (result.size > 0) {
-        result.success = true;
-        for (int32_t byteIndex = 0; byteIndex < result.size; byteIndex++) {
-            uint8_t byte = ((uint8_t*)result.affinity)[byteIndex];
-            for (int32_t bitIndex = 0; bitIndex < 8; bitIndex++) {
-                uint8_t mask = 1 << bitIndex;
-                result.setBits += (byte & mask) != 0;
+static prb_ParseUintResult
+prb_linux_parseMeminfoField(prb_Str meminfo, prb_Str field) {
+    prb_ParseUintResult result = {};
+    prb_StrScanner      scanner = prb_createStrScanner(meminfo);
+    prb_StrFindSpec     lineBreakSpec = {};
+    lineBreakSpec.mode = prb_StrFindMode_LineBreak;
+    while (prb_strScannerMove(&scanner, lineBreakSpec, prb_StrScannerSide_AfterMatch)) {
+        prb_Str line = scanner.betweenLastMatches;
+        if (prb_strStartsWith(line, field) && line.len > field.len && line.ptr[field.len] == ':') {
+            // NOTE(khvorov) Values are in kilobytes: "MemAvailable:    5662176 kB"
+            prb_Str value = prb_strTrim(prb_strSlice(line, field.len + 1, line.len));
+            if (prb_strEndsWith(value, prb_STR(" kB"))) {
+                result = prb_parseUint(prb_strSlice(value, 0, value.len - 3), 10);
+                result.number *= 1024;
             }
+            break;
         }
     }
     return result;
 }
 
-#endif
-
-prb_PUBLICDEF void
-prb_terminate(int32_t code) {
-#if prb_PLATFORM_WINDOWS
-    ExitProcess((UINT)code);
-#elif prb_PLATFORM_LINUX
-    exit(code);
-#else
-#error unimplemented
-#endif
-}
-
-prb_PUBLICDEF prb_Str
-prb_getCmdline(prb_Arena* arena) {
-    prb_Str result = {.ptr = 0, .len = 0};
-
-#if prb_PLATFORM_WINDOWS
+// NOTE(khvorov) Resident memory of the process and everything it launched. Children are only
+// looked up for the main thread which is where compilers and the like launch from.
+static int64_t
+prb_linux_getProcessTreeRss(prb_Arena* arena, pid_t pid) {
+    int64_t        result = 0;
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        statm = prb_linux_readSmallFile(arena, prb_fmt(arena, "/proc/%d/statm", pid));
+    prb_StrScanner scanner = prb_createStrScanner(statm);
+    prb_StrFindSpec spaceSpec = {.mode = prb_StrFindMode_AnyChar, .direction = prb_StrDirection_FromStart, .pattern = prb_STR(" \n"), .alwaysMatchEnd = true};
+    if (prb_strScannerMove(&scanner, spaceSpec, prb_StrScannerSide_AfterMatch) && prb_strScannerMove(&scanner, spaceSpec, prb_StrScannerSide_AfterMatch)) {
+        prb_ParseUintResult residentPages = prb_parseUint(scanner.betweenLastMatches, 10);
+        if (residentPages.success) {
+            result += (int64_t)residentPages.number * (int64_t)sysconf(_SC_PAGESIZE);
+        }
+    }
 
-    LPWSTR  wstr = GetCommandLineW();
-    int32_t len = 0;
-    while (wstr[len]) {
-        len += 1;
+    prb_Str children = prb_linux_readSmallFile(arena, prb_fmt(arena, "/proc/%d/task/%d/children", pid, pid));
+    prb_StrScanner childScanner = prb_createStrScanner(children);
+    while (prb_strScannerMove(&childScanner, spaceSpec, prb_StrScannerSide_AfterMatch)) {
+        prb_ParseUintResult childPid = prb_parseUint(childScanner.betweenLastMatches, 10);
+        if (childPid.success) {
+            result += prb_linux_getProcessTreeRss(arena, (pid_t)childPid.number);
+        }
     }
-    result = prb_windows_strFromWideStr(arena, (prb_windows_WideStr) {wstr, len});
 
-#elif prb_PLATFORM_LINUX
+    prb_endTempMemory(temp);
+    return result;
+}
 
-    prb_Bytes procSelfContent = prb_linux_readFromProc(arena, prb_STR("self/cmdline"));
-    for (int32_t byteIndex = 0; byteIndex < procSelfContent.len - 1; byteIndex++) {
-        if (procSelfContent.data[byteIndex] == '\0') {
-            procSelfContent.data[byteIndex] = ' ';
+typedef struct prb_linux_ProcStats {
+    bool valid;
+    // NOTE(khvorov) Children's time only includes the ones that were waited on
+    float   cpuMs;
+    float   childrenCpuMs;
+    int64_t rssBytes;
+    int64_t swapBytes;
+} prb_linux_ProcStats;
+
+static prb_linux_ProcStats
+prb_linux_readProcStats(prb_Arena* arena, pid_t pid) {
+    prb_linux_ProcStats result = {};
+    prb_TempMemory      temp = prb_beginTempMemory(arena);
+
+    // NOTE(khvorov) The name in parens can have anything in it, fields are counted after the last paren.
+    // utime, stime, cutime and cstime are fields 14-17 (proc(5)), the state right after the paren is field 3
+    prb_Str         stat = prb_linux_readSmallFile(arena, prb_fmt(arena, "/proc/%d/stat", pid));
+    prb_StrFindSpec parenSpec = {};
+    parenSpec.pattern = prb_STR(")");
+    parenSpec.direction = prb_StrDirection_FromEnd;
+    prb_StrFindResult paren = prb_strFind(stat, parenSpec);
+    if (paren.found) {
+        float           msPerTick = 1000.0f / (float)sysconf(_SC_CLK_TCK);
+        prb_StrScanner  scanner = prb_createStrScanner(prb_strTrim(paren.afterMatch));
+        prb_StrFindSpec spaceSpec = {};
+        spaceSpec.pattern = prb_STR(" ");
+        spaceSpec.alwaysMatchEnd = true;
+        int32_t parsedCount = 0;
+        for (int32_t field = 3; field <= 17 && prb_strScannerMove(&scanner, spaceSpec, prb_StrScannerSide_AfterMatch); field++) {
+            if (field >= 14) {
+                prb_ParseUintResult ticks = prb_parseUint(scanner.betweenLastMatches, 10);
+                if (ticks.success) {
+                    parsedCount += 1;
+                    if (field <= 15) {
+                        result.cpuMs += (float)ticks.number * msPerTick;
+                    } else {
+                        result.childrenCpuMs += (float)ticks.number * msPerTick;
+                    }
+                }
+            }
         }
+        result.valid = parsedCount == 4;
     }
 
-    result = (prb_Str) {(const char*)procSelfContent.data, procSelfContent.len - 1};
-
-#elif
-#error unimplemented
-#endif
+    // NOTE(khvorov) Missing for zombies and kernel threads, which is the same as none
+    if (result.valid) {
+        prb_Str status = prb_linux_readSmallFile(arena, prb_fmt(arena, "/proc/%d/status", pid));
+        result.rssBytes = (int64_t)prb_linux_parseMeminfoField(status, prb_STR("VmRSS")).number;
+        result.swapBytes = (int64_t)prb_linux_parseMeminfoField(status, prb_STR("VmSwap")).number;
+    }
 
+    prb_endTempMemory(temp);
     return result;
 }
 
-prb_PUBLICDEF prb_Str*
-prb_getCmdArgs(prb_Arena* arena) {
-    prb_Str* result = 0;
-
-#if prb_PLATFORM_WINDOWS
-
-    prb_Str         str = prb_getCmdline(arena);
-    prb_StrFindSpec spec = {
-        .mode = prb_StrFindMode_AnyChar,
-        .direction = prb_StrDirection_FromStart,
-        .pattern = prb_STR(" "),
-        .alwaysMatchEnd = true,
-    };
-    prb_StrScanner scanner = prb_createStrScanner(str);
-    while (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
-        if (scanner.betweenLastMatches.len > 0) {
-            prb_stbds_arrput(result, scanner.betweenLastMatches);
+static void
+prb_linux_addProcessTreeToSample(prb_Arena* arena, pid_t pid, prb_ProcessSample* sample) {
+    prb_TempMemory      temp = prb_beginTempMemory(arena);
+    prb_linux_ProcStats stats = prb_linux_readProcStats(arena, pid);
+    if (stats.valid) {
+        sample->treeCpuMs += stats.cpuMs + stats.childrenCpuMs;
+        sample->treeRssBytes += stats.rssBytes;
+        sample->treeSwapBytes += stats.swapBytes;
+        sample->treeProcessCount += 1;
+
+        prb_Str         children = prb_linux_readSmallFile(arena, prb_fmt(arena, "/proc/%d/task/%d/children", pid, pid));
+        prb_StrScanner  scanner = prb_createStrScanner(children);
+        prb_StrFindSpec spaceSpec = {};
+        spaceSpec.mode = prb_StrFindMode_AnyChar;
+        spaceSpec.pattern = prb_STR(" \n");
+        spaceSpec.alwaysMatchEnd = true;
+        while (prb_strScannerMove(&scanner, spaceSpec, prb_StrScannerSide_AfterMatch)) {
+            prb_ParseUintResult childPid = prb_parseUint(scanner.betweenLastMatches, 10);
+            if (childPid.success) {
+                prb_linux_addProcessTreeToSample(arena, (pid_t)childPid.number, sample);
+            }
         }
     }
+    prb_endTempMemory(temp);
+}
 
-#elif prb_PLATFORM_LINUX
+// NOTE(khvorov) Returns how long until the next sample is due, -1 when the process is not sampled
+static float
+prb_linux_sampleProcessIfDue(prb_Process* handle) {
+    float result = -1;
+    if (handle->spec.sampleIntervalMs > 0 && handle->status == prb_ProcessStatus_Launched) {
+        prb_ProcessSample* prev = handle->sampleCount > 0 ? handle->sampleBuffer + handle->sampleCount - 1 : 0;
+        float              sinceLaunchMs = prb_getMsFrom(handle->launchTime);
+        float              prevMs = prev ? prev->timeMs : 0;
+        result = prevMs + handle->spec.sampleIntervalMs - sinceLaunchMs;
+        if (result <= 0) {
+            prb_Arena*          arena = handle->spec.captureArena;
+            prb_ProcessSample   sample = {};
+            prb_linux_ProcStats stats = prb_linux_readProcStats(arena, handle->pid);
+            sample.timeMs = sinceLaunchMs;
+            sample.cpuMs = stats.cpuMs;
+            sample.rssBytes = stats.rssBytes;
+            sample.swapBytes = stats.swapBytes;
+            prb_linux_addProcessTreeToSample(arena, handle->pid, &sample);
+
+            float elapsedMs = sinceLaunchMs - prevMs;
+            if (elapsedMs > 0) {
+                sample.cpuPercent = (sample.cpuMs - (prev ? prev->cpuMs : 0)) / elapsedMs * 100.0f;
+                sample.treeCpuPercent = (sample.treeCpuMs - (prev ? prev->treeCpuMs : 0)) / elapsedMs * 100.0f;
+            }
 
-    prb_Bytes procSelfContent = prb_linux_readFromProc(arena, prb_STR("self/cmdline"));
-    prb_Str procSelfContentLeft = {(const char*)procSelfContent.data, procSelfContent.len};
-    for (int32_t byteIndex = 0; byteIndex < procSelfContent.len; byteIndex++) {
-        if (procSelfContent.data[byteIndex] == '\0') {
-            int32_t processed = procSelfContent.len - procSelfContentLeft.len;
-            prb_Str arg = {procSelfContentLeft.ptr, byteIndex - processed};
-            prb_stbds_arrput(result, arg);
-            procSelfContentLeft = prb_strSlice(procSelfContentLeft, arg.len + 1, procSelfContentLeft.len);
+            prb_stbds_arrput(handle->sampleBuffer, sample);
+            handle->samples = handle->sampleBuffer;
+            handle->sampleCount = (int32_t)prb_stbds_arrlen(handle->sampleBuffer);
+            result = handle->spec.sampleIntervalMs;
         }
     }
+    return result;
+}
 
-#elif
-#error unimplemented
+#ifndef SYS_pipe2
+#define SYS_pipe2 293
 #endif
 
+// NOTE(khvorov) Pipes are close-on-exec so that other children don't hold on to the write ends.
+// Has to happen atomically since other threads could be launching processes at the same time.
+// Calling pipe2 through syscall because the wrapper needs _GNU_SOURCE
+static bool
+prb_linux_createCapturePipe(int* pipeEnds) {
+    bool result = syscall(SYS_pipe2, pipeEnds, O_CLOEXEC) == 0;
+    if (!result && errno == ENOSYS) {
+        result = pipe(pipeEnds) == 0;
+        if (result) {
+            fcntl(pipeEnds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(pipeEnds[1], F_SETFD, FD_CLOEXEC);
+        }
+    }
+    if (!result) {
+        pipeEnds[0] = -1;
+        pipeEnds[1] = -1;
+    }
     return result;
 }
 
-prb_PUBLICDEF const char**
-prb_getArgArrayFromStr(prb_Arena* arena, prb_Str str) {
-    const char** args = 0;
+static int
+prb_linux_takeCapturePipeReadEnd(int* pipeEnds) {
+    int result = pipeEnds[0];
+    if (result != -1) {
+        pipeEnds[0] = -1;
+        fcntl(result, F_SETFL, fcntl(result, F_GETFL) | O_NONBLOCK);
+    }
+    return result;
+}
 
-    {
-        prb_StrScanner  scanner = prb_createStrScanner(str);
-        prb_StrFindSpec space = {
-            .mode = prb_StrFindMode_AnyChar,
-            .direction = prb_StrDirection_FromStart,
-            .pattern = prb_STR(" "),
-            .alwaysMatchEnd = true,
-        };
-        while (prb_strScannerMove(&scanner, space, prb_StrScannerSide_AfterMatch)) {
-            if (scanner.betweenLastMatches.len > 0) {
-                const char* argNull = prb_fmt(arena, "%.*s", prb_LIT(scanner.betweenLastMatches)).ptr;
-                prb_stbds_arrput(args, argNull);
+// NOTE(khvorov) Reads whatever is available right now, closes the pipe once the writer is gone.
+// Output goes to the buffer and/or the hash stream, whichever is not null.
+static void
+prb_linux_drainCapturePipe(int* pipeHandle, uint8_t** buffer, prb_HashStream* hashStream) {
+    if (*pipeHandle != -1) {
+        for (;;) {
+            uint8_t chunk[4096];
+            ssize_t readResult = read(*pipeHandle, chunk, sizeof(chunk));
+            if (readResult > 0) {
+                if (buffer) {
+                    uint8_t* dest = prb_stbds_arraddnptr(*buffer, readResult);
+                    prb_memcpy(dest, chunk, readResult);
+                }
+                if (hashStream) {
+                    prb_hashStreamAdd(hashStream, chunk, (int32_t)readResult);
+                }
+            } else if (readResult == -1 && errno == EINTR) {
+                continue;
+            } else {
+                if (readResult == 0 || errno != EAGAIN) {
+                    close(*pipeHandle);
+                    *pipeHandle = -1;
+                }
+                break;
             }
         }
     }
-
-    // NOTE(khvorov) Arg array needs a null at the end
-    prb_stbds_arrsetcap(args, (size_t)(prb_stbds_arrlen(args) + 1));
-    args[prb_stbds_arrlen(args)] = 0;
-
-    return args;
+}
+
+// NOTE(khvorov) Writes whatever fits into a non-blocking pipe right now. Returns how much that was, -1 once the reader is gone.
+// Writing to a pipe without a reader raises SIGPIPE which would kill us, so it's blocked during the write
+// and taken off the pending set if the write raised it.
+static int32_t
+prb_linux_writeToPipe(int pipeHandle, const uint8_t* data, int32_t len) {
+    sigset_t pipeSignal;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    sigset_t prevMask;
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &prevMask);
+    sigset_t pendingBefore;
+    sigpending(&pendingBefore);
+
+    int32_t result = 0;
+    while (result < len) {
+        ssize_t writeResult = write(pipeHandle, data + result, len - result);
+        if (writeResult > 0) {
+            result += (int32_t)writeResult;
+        } else if (writeResult == -1 && errno == EINTR) {
+            continue;
+        } else if (writeResult == -1 && errno == EAGAIN) {
+            break;
+        } else {
+            if (errno == EPIPE && !sigismember(&pendingBefore, SIGPIPE)) {
+                struct timespec noWait = {.tv_sec = 0, .tv_nsec = 0};
+                sigtimedwait(&pipeSignal, 0, &noWait);
+            }
+            result = -1;
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &prevMask, 0);
+    return result;
+}
+
+// NOTE(khvorov) Closes the pipe once everything is written or the reader is gone
+static void
+prb_linux_feedStdinPipe(prb_Process* handle) {
+    if (handle->stdinPipe != -1) {
+        uint8_t* data = handle->spec.stdinBytes.data + handle->stdinWritten;
+        int32_t  written = prb_linux_writeToPipe(handle->stdinPipe, data, handle->spec.stdinBytes.len - handle->stdinWritten);
+        if (written > 0) {
+            handle->stdinWritten += written;
+        }
+        if (written == -1 || handle->stdinWritten >= handle->spec.stdinBytes.len) {
+            close(handle->stdinPipe);
+            handle->stdinPipe = -1;
+        }
+    }
+}
+
+static void
+prb_linux_drainStdoutPipe(prb_Process* handle) {
+    uint8_t**       buffer = handle->spec.captureStdout || handle->spec.bufferOutput ? &handle->stdoutBuffer : 0;
+    prb_HashStream* hashStream = handle->spec.hashStdout ? &handle->stdoutHashStream : 0;
+    prb_linux_drainCapturePipe(&handle->stdoutPipe, buffer, hashStream);
+}
+
+static void
+prb_linux_serviceProcessPipes(prb_Process* handle) {
+    prb_linux_drainStdoutPipe(handle);
+    prb_linux_drainCapturePipe(&handle->stderrPipe, &handle->stderrBuffer, 0);
+    prb_linux_feedStdinPipe(handle);
+}
+
+// NOTE(khvorov) Gives up once spec.timeoutMs runs out, returns false if it did
+static bool
+prb_linux_drainCapturePipesUntilClosed(prb_Process* handle) {
+    bool result = true;
+    while (result && (handle->stdoutPipe != -1 || handle->stderrPipe != -1 || handle->stdinPipe != -1)) {
+        int timeout = -1;
+        if (handle->spec.timeoutMs > 0) {
+            float remainingMs = handle->spec.timeoutMs - prb_getMsFrom(handle->launchTime);
+            result = remainingMs > 0;
+            timeout = (int)remainingMs + 1;
+        }
+        if (result) {
+            struct pollfd pollfds[3] = {
+                {.fd = handle->stdoutPipe, .events = POLLIN, .revents = 0},
+                {.fd = handle->stderrPipe, .events = POLLIN, .revents = 0},
+                {.fd = handle->stdinPipe, .events = POLLOUT, .revents = 0},
+            };
+            poll(pollfds, 3, timeout);
+            prb_linux_serviceProcessPipes(handle);
+        }
+    }
+    return result;
+}
+
+static prb_Str
+prb_linux_moveCaptureBufferToArena(prb_Arena* arena, uint8_t** buffer) {
+    int32_t len = (int32_t)prb_stbds_arrlen(*buffer);
+    char*   ptr = (char*)prb_arenaAllocAndZero(arena, len + 1, 1);
+    if (len > 0) {
+        prb_memcpy(ptr, *buffer, len);
+    }
+    prb_stbds_arrfree(*buffer);
+    prb_Str result = {ptr, len};
+    return result;
+}
+
+static void
+prb_linux_closeCapturePipeHandles(prb_Process* handle) {
+    if (handle->stdoutPipe != -1) {
+        close(handle->stdoutPipe);
+        handle->stdoutPipe = -1;
+    }
+    if (handle->stderrPipe != -1) {
+        close(handle->stderrPipe);
+        handle->stderrPipe = -1;
+    }
+    if (handle->stdinPipe != -1) {
+        close(handle->stdinPipe);
+        handle->stdinPipe = -1;
+    }
+}
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// NOTE(khvorov) Returns -1 when pidfds are not supported (kernels older than 5.3)
+static int
+prb_linux_pidfdOpen(pid_t pid) {
+    int result = (int)syscall(SYS_pidfd_open, pid, 0);
+    return result;
+}
+
+#ifndef SCHED_BATCH
+#define SCHED_BATCH 3
+#endif
+
+#ifndef SCHED_IDLE
+#define SCHED_IDLE 5
+#endif
+
+typedef struct prb_linux_SpawnArgs {
+    pid_t*                      pid;
+    prb_FindExecutableResult    exe;
+    const char**                args;
+    char**                      env;
+    posix_spawn_file_actions_t* fileActions;
+    posix_spawnattr_t*          attr;
+    int32_t                     niceIncrement;
+    // NOTE(khvorov) In the form ioprio_set takes, 0 means leave as is
+    int  ioPriority;
+    bool schedBatch;
+    int  result;
+} prb_linux_SpawnArgs;
+
+// NOTE(khvorov) Avoid searching PATH on every launch. Executables without a shebang are run through the shell
+// the way execvp does it, posix_spawnp stopped doing that in glibc 2.27.
+static void
+prb_linux_spawn(prb_linux_SpawnArgs* spawnArgs) {
+    spawnArgs->result = 0;
+    if (spawnArgs->exe.found) {
+        spawnArgs->result = posix_spawn(spawnArgs->pid, spawnArgs->exe.path.ptr, spawnArgs->fileActions, spawnArgs->attr, (char**)spawnArgs->args, spawnArgs->env);
+        if (spawnArgs->result == ENOEXEC) {
+            const char** shellArgs = 0;
+            prb_stbds_arrput(shellArgs, "/bin/sh");
+            prb_stbds_arrput(shellArgs, spawnArgs->exe.path.ptr);
+            for (int32_t argIndex = 1; spawnArgs->args[argIndex]; argIndex++) {
+                prb_stbds_arrput(shellArgs, spawnArgs->args[argIndex]);
+            }
+            prb_stbds_arrput(shellArgs, 0);
+            spawnArgs->result = posix_spawn(spawnArgs->pid, "/bin/sh", spawnArgs->fileActions, spawnArgs->attr, (char**)shellArgs, spawnArgs->env);
+            prb_stbds_arrfree(shellArgs);
+        }
+    } else {
+        spawnArgs->result = posix_spawnp(spawnArgs->pid, spawnArgs->args[0], spawnArgs->fileActions, spawnArgs->attr, (char**)spawnArgs->args, spawnArgs->env);
+    }
+}
+
+// NOTE(khvorov) Niceness, io priority and sched policy belong to threads on linux and the child gets them from the thread that
+// spawned it. posix_spawn can't set them and unprivileged threads can't lower their niceness back, so
+// children that need them are spawned from a helper thread that has them set. There is one helper per combination
+// of settings, started the first time it's needed and kept around until the process exits.
+typedef struct prb_linux_PrioritySpawner {
+    int32_t              niceIncrement;
+    int                  ioPriority;
+    bool                 schedBatch;
+    pthread_mutex_t      mutex;
+    pthread_cond_t       cond;
+    prb_linux_SpawnArgs* request;
+    sigset_t             requestSigmask;
+} prb_linux_PrioritySpawner;
+
+static pthread_mutex_t             prb_linux_prioritySpawnersMutex = PTHREAD_MUTEX_INITIALIZER;
+static prb_linux_PrioritySpawner** prb_linux_prioritySpawners = 0;
+
+static void*
+prb_linux_prioritySpawnerThreadProc(void* data) {
+    prb_linux_PrioritySpawner* spawner = (prb_linux_PrioritySpawner*)data;
+    bool                       prioritySet = true;
+    if (spawner->niceIncrement != 0) {
+        // NOTE(khvorov) -1 is a valid niceness so errors are only seen through errno
+        errno = 0;
+        int curNice = getpriority(PRIO_PROCESS, 0);
+        prioritySet = errno == 0 && setpriority(PRIO_PROCESS, 0, curNice + spawner->niceIncrement) == 0;
+    }
+    if (prioritySet && spawner->ioPriority != 0) {
+        // NOTE(khvorov) 1 is IOPRIO_WHO_PROCESS, which with id 0 is the calling thread
+        prioritySet = syscall(SYS_ioprio_set, 1, 0, spawner->ioPriority) == 0;
+    }
+    if (prioritySet && spawner->schedBatch) {
+        // NOTE(khvorov) Pid 0 is the calling thread here too
+        struct sched_param schedParam = {};
+        prioritySet = sched_setscheduler(0, SCHED_BATCH, &schedParam) == 0;
+    }
+    int prioritySetResult = prioritySet ? 0 : errno;
+
+    pthread_mutex_lock(&spawner->mutex);
+    for (;;) {
+        while (!spawner->request) {
+            pthread_cond_wait(&spawner->cond, &spawner->mutex);
+        }
+        if (prioritySetResult == 0) {
+            // NOTE(khvorov) The child starts with the signal mask of whoever asked for it, same as if they spawned it
+            pthread_sigmask(SIG_SETMASK, &spawner->requestSigmask, 0);
+            prb_linux_spawn(spawner->request);
+        } else {
+            spawner->request->result = prioritySetResult;
+        }
+        spawner->request = 0;
+        pthread_cond_broadcast(&spawner->cond);
+    }
+    return 0;
+}
+
+static void
+prb_linux_spawnWithPriority(prb_linux_SpawnArgs* spawnArgs) {
+    pthread_mutex_lock(&prb_linux_prioritySpawnersMutex);
+    prb_linux_PrioritySpawner* spawner = 0;
+    for (int32_t spawnerIndex = 0; spawnerIndex < prb_stbds_arrlen(prb_linux_prioritySpawners) && !spawner; spawnerIndex++) {
+        prb_linux_PrioritySpawner* candidate = prb_linux_prioritySpawners[spawnerIndex];
+        if (candidate->niceIncrement == spawnArgs->niceIncrement && candidate->ioPriority == spawnArgs->ioPriority && candidate->schedBatch == spawnArgs->schedBatch) {
+            spawner = candidate;
+        }
+    }
+    if (!spawner) {
+        spawner = (prb_linux_PrioritySpawner*)prb_malloc(sizeof(prb_linux_PrioritySpawner));
+        prb_memset(spawner, 0, sizeof(*spawner));
+        spawner->niceIncrement = spawnArgs->niceIncrement;
+        spawner->ioPriority = spawnArgs->ioPriority;
+        spawner->schedBatch = spawnArgs->schedBatch;
+        pthread_mutex_init(&spawner->mutex, 0);
+        pthread_cond_init(&spawner->cond, 0);
+        pthread_t thread;
+        int       createResult = pthread_create(&thread, 0, prb_linux_prioritySpawnerThreadProc, spawner);
+        if (createResult == 0) {
+            pthread_detach(thread);
+            prb_stbds_arrput(prb_linux_prioritySpawners, spawner);
+        } else {
+            pthread_cond_destroy(&spawner->cond);
+            pthread_mutex_destroy(&spawner->mutex);
+            prb_free(spawner);
+            spawner = 0;
+            spawnArgs->result = createResult;
+        }
+    }
+    pthread_mutex_unlock(&prb_linux_prioritySpawnersMutex);
+
+    if (spawner) {
+        sigset_t sigmask;
+        pthread_sigmask(SIG_SETMASK, 0, &sigmask);
+        pthread_mutex_lock(&spawner->mutex);
+        // NOTE(khvorov) Launches that need the same helper take turns
+        while (spawner->request) {
+            pthread_cond_wait(&spawner->cond, &spawner->mutex);
+        }
+        spawner->request = spawnArgs;
+        spawner->requestSigmask = sigmask;
+        pthread_cond_broadcast(&spawner->cond);
+        while (spawner->request == spawnArgs) {
+            pthread_cond_wait(&spawner->cond, &spawner->mutex);
+        }
+        pthread_mutex_unlock(&spawner->mutex);
+    }
+}
+
+static bool
+prb_linux_sendKill(prb_Process* handle) {
+    // NOTE(khvorov) Negative pid means the whole process group
+    pid_t target = handle->spec.ownProcessGroup ? -handle->pid : handle->pid;
+    bool  result = kill(target, SIGKILL) == 0;
+    return result;
+}
+
+// NOTE(khvorov) Returns once the process exits (without reaping it) or gets killed because it ran out of time.
+// Takes samples in the meantime.
+static void
+prb_linux_watchProcessUntilExit(prb_Process* handle) {
+    int pidfd = prb_linux_pidfdOpen(handle->pid);
+    for (;;) {
+        int timeout = -1;
+        if (handle->spec.timeoutMs > 0) {
+            float remainingMs = handle->spec.timeoutMs - prb_getMsFrom(handle->launchTime);
+            if (remainingMs <= 0) {
+                handle->timedOut = true;
+                prb_linux_sendKill(handle);
+                break;
+            }
+            timeout = (int)remainingMs + 1;
+        }
+        float untilSampleMs = prb_linux_sampleProcessIfDue(handle);
+        if (untilSampleMs >= 0 && (timeout < 0 || (int)untilSampleMs + 1 < timeout)) {
+            timeout = (int)untilSampleMs + 1;
+        }
+
+        // NOTE(khvorov) Without a pidfd have to keep checking on the process. Poll ignores negative fds.
+        if (pidfd == -1) {
+            timeout = timeout < 0 ? 10 : prb_min(timeout, 10);
+        }
+        struct pollfd pollfds[4] = {
+            {.fd = pidfd, .events = POLLIN, .revents = 0},
+            {.fd = handle->stdoutPipe, .events = POLLIN, .revents = 0},
+            {.fd = handle->stderrPipe, .events = POLLIN, .revents = 0},
+            {.fd = handle->stdinPipe, .events = POLLOUT, .revents = 0},
+        };
+        poll(pollfds, 4, timeout);
+        prb_linux_serviceProcessPipes(handle);
+
+        bool exited = pollfds[0].revents != 0;
+        if (pidfd == -1) {
+            siginfo_t info = {};
+            exited = waitid(P_PID, (id_t)handle->pid, &info, WEXITED | WNOHANG | WNOWAIT) == -1 || info.si_pid == handle->pid;
+        }
+        if (exited) {
+            break;
+        }
+    }
+    if (pidfd != -1) {
+        close(pidfd);
+    }
+}
+
+static void
+prb_linux_waitForProcess(prb_Process* handle) {
+    if (handle->spec.timeoutMs > 0 || handle->spec.sampleIntervalMs > 0) {
+        prb_linux_watchProcessUntilExit(handle);
+    }
+
+    // NOTE(khvorov) Have to read the output before waiting or the child blocks on a full pipe.
+    // A killed child can't block on anything anymore. The child could also be gone already and
+    // whatever it left running in the background is still holding the pipes past the timeout.
+    if (!handle->timedOut && !prb_linux_drainCapturePipesUntilClosed(handle)) {
+        handle->timedOut = true;
+        prb_linux_sendKill(handle);
+    }
+
+    int32_t       status = 0;
+    struct rusage usage = {};
+    pid_t waitResult = wait4(handle->pid, &status, 0, &usage);
+
+    // NOTE(khvorov) Whatever the child launched could still be holding the pipes and would keep us here past
+    // the timeout, so only what's already been written is kept
+    if (handle->timedOut) {
+        prb_linux_drainStdoutPipe(handle);
+        prb_linux_drainCapturePipe(&handle->stderrPipe, &handle->stderrBuffer, 0);
+        prb_linux_closeCapturePipeHandles(handle);
+    }
+    handle->usage.wallMs = prb_getMsFrom(handle->launchTime);
+    handle->status = prb_ProcessStatus_CompletedFailed;
+    if (waitResult == handle->pid) {
+        if (status == 0 && !handle->timedOut) {
+            handle->status = prb_ProcessStatus_CompletedSuccess;
+        }
+        handle->usage.userCpuMs = (float)usage.ru_utime.tv_sec * 1000.0f + (float)usage.ru_utime.tv_usec / 1000.0f;
+        handle->usage.sysCpuMs = (float)usage.ru_stime.tv_sec * 1000.0f + (float)usage.ru_stime.tv_usec / 1000.0f;
+        // NOTE(khvorov) ru_maxrss is in kilobytes
+        handle->usage.maxRssBytes = (int64_t)usage.ru_maxrss * 1024;
+    }
+
+    if (handle->spec.captureStdout) {
+        handle->capturedStdout = prb_linux_moveCaptureBufferToArena(handle->spec.captureArena, &handle->stdoutBuffer);
+    }
+    if (handle->spec.hashStdout) {
+        handle->stdoutHash.valid = true;
+        handle->stdoutHash.hash = prb_hashStreamEnd(&handle->stdoutHashStream);
+    }
+    if (handle->spec.captureStderr) {
+        handle->capturedStderr = prb_linux_moveCaptureBufferToArena(handle->spec.captureArena, &handle->stderrBuffer);
+    }
+    if (handle->spec.sampleIntervalMs > 0) {
+        handle->samples = prb_arenaAllocArray(handle->spec.captureArena, prb_ProcessSample, prb_max(handle->sampleCount, 1));
+        if (handle->sampleCount > 0) {
+            prb_memcpy(handle->samples, handle->sampleBuffer, handle->sampleCount * (int32_t)sizeof(prb_ProcessSample));
+        }
+        prb_stbds_arrfree(handle->sampleBuffer);
+    }
+}
+
+typedef struct prb_linux_GetAffinityResult {
+    bool success;
+    uint8_t* affinity;
+    int32_t size;
+    int32_t setBits;
+} prb_linux_GetAffinityResult;
+
+static prb_linux_GetAffinityResult
+prb_linux_getAffinity(prb_Arena* arena) {
+    // NOTE(khvorov) The syscall is picky about alignment and can't handle buffers that are too big.
+    // I don't know how big is too big but a megabyte is apparently not too big.
+    prb_linux_GetAffinityResult result = {};
+    int32_t reqAlign = prb_alignof(unsigned long);
+    prb_arenaAlignFreePtr(arena, reqAlign);
+    result.affinity = (uint8_t*)prb_arenaFreePtr(arena);
+    int32_t arenaSize = (int32_t)prb_min(prb_arenaFreeSize(arena), INT32_MAX);
+    int32_t arenaSizeAligned = arenaSize & (~(reqAlign - 1));
+    int32_t sizeReduced = prb_min(arenaSizeAligned, prb_MEGABYTE);
+    result.size = syscall(SYS_sched_getaffinity, 0, sizeReduced, result.affinity);
+    if (result.size > 0) {
+        result.success = true;
+        for (int32_t byteIndex = 0; byteIndex < result.size; byteIndex++) {
+            uint8_t byte = ((uint8_t*)result.affinity)[byteIndex];
+            for (int32_t bitIndex = 0; bitIndex < 8; bitIndex++) {
+                uint8_t mask = 1 << bitIndex;
+                result.setBits += (byte & mask) != 0;
+            }
+        }
+    }
+    return result;
+}
+
+#endif
+
+prb_PUBLICDEF void
+prb_terminate(int32_t code) {
+#if prb_PLATFORM_WINDOWS
+    ExitProcess((UINT)code);
+#elif prb_PLATFORM_LINUX
+    exit(code);
+#else
+#error unimplemented
+#endif
+}
+
+prb_PUBLICDEF prb_Str
+prb_getCmdline(prb_Arena* arena) {
+    prb_Str result = {.ptr = 0, .len = 0};
+
+#if prb_PLATFORM_WINDOWS
+
+    LPWSTR  wstr = GetCommandLineW();
+    int32_t len = 0;
+    while (wstr[len]) {
+        len += 1;
+    }
+    result = prb_windows_strFromWideStr(arena, (prb_windows_WideStr) {wstr, len});
+
+#elif prb_PLATFORM_LINUX
+
+    prb_Bytes procSelfContent = prb_linux_readFromProc(arena, prb_STR("self/cmdline"));
+    for (int32_t byteIndex = 0; byteIndex < procSelfContent.len - 1; byteIndex++) {
+        if (procSelfContent.data[byteIndex] == '\0') {
+            procSelfContent.data[byteIndex] = ' ';
+        }
+    }
+
+    result = (prb_Str) {(const char*)procSelfContent.data, procSelfContent.len - 1};
+
+#elif
+#error unimplemented
+#endif
+
+    return result;
+}
+
+prb_PUBLICDEF prb_Str*
+prb_getCmdArgs(prb_Arena* arena) {
+    prb_Str* result = 0;
+
+#if prb_PLATFORM_WINDOWS
+
+    prb_Str         str = prb_getCmdline(arena);
+    prb_StrFindSpec spec = {
+        .mode = prb_StrFindMode_AnyChar,
+        .direction = prb_StrDirection_FromStart,
+        .pattern = prb_STR(" "),
+        .alwaysMatchEnd = true,
+    };
+    prb_StrScanner scanner = prb_createStrScanner(str);
+    while (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
+        if (scanner.betweenLastMatches.len > 0) {
+            prb_stbds_arrput(result, scanner.betweenLastMatches);
+        }
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    prb_Bytes procSelfContent = prb_linux_readFromProc(arena, prb_STR("self/cmdline"));
+    prb_Str procSelfContentLeft = {(const char*)procSelfContent.data, procSelfContent.len};
+    for (int32_t byteIndex = 0; byteIndex < procSelfContent.len; byteIndex++) {
+        if (procSelfContent.data[byteIndex] == '\0') {
+            int32_t processed = procSelfContent.len - procSelfContentLeft.len;
+            prb_Str arg = {procSelfContentLeft.ptr, byteIndex - processed};
+            prb_stbds_arrput(result, arg);
+            procSelfContentLeft = prb_strSlice(procSelfContentLeft, arg.len + 1, procSelfContentLeft.len);
+        }
+    }
+
+#elif
+#error unimplemented
+#endif
+
+    return result;
+}
+
+prb_PUBLICDEF const char**
+prb_getArgArrayFromStr(prb_Arena* arena, prb_Str str) {
+    const char** args = 0;
+
+    {
+        prb_StrScanner  scanner = prb_createStrScanner(str);
+        prb_StrFindSpec space = {
+            .mode = prb_StrFindMode_AnyChar,
+            .direction = prb_StrDirection_FromStart,
+            .pattern = prb_STR(" "),
+            .alwaysMatchEnd = true,
+        };
+        while (prb_strScannerMove(&scanner, space, prb_StrScannerSide_AfterMatch)) {
+            if (scanner.betweenLastMatches.len > 0) {
+                const char* argNull = prb_fmt(arena, "%.*s", prb_LIT(scanner.betweenLastMatches)).ptr;
+                prb_stbds_arrput(args, argNull);
+            }
+        }
+    }
+
+    // NOTE(khvorov) Arg array needs a null at the end
+    prb_stbds_arrsetcap(args, (size_t)(prb_stbds_arrlen(args) + 1));
+    args[prb_stbds_arrlen(args)] = 0;
+
+    return args;
+}
+
+prb_PUBLICDEF prb_Argv
+prb_createArgv(prb_Arena* arena, prb_Str cmd) {
+    // NOTE(khvorov) Unquoting never makes an argument longer and every argument
+    // except the last one is followed by a separator that becomes its null terminator
+    char*        buf = (char*)prb_arenaAllocAndZero(arena, cmd.len + 1, 1);
+    int32_t      bufLen = 0;
+    const char** args = 0;
+    bool         inArg = false;
+    char         quote = 0;
+    for (int32_t chIndex = 0; chIndex < cmd.len; chIndex++) {
+        char ch = cmd.ptr[chIndex];
+        if (quote == '\'') {
+            if (ch == '\'') {
+                quote = 0;
+            } else {
+                buf[bufLen++] = ch;
+            }
+        } else if (quote == '"') {
+            // NOTE(khvorov) Backslash is only special before a quote or another backslash so that windows paths work
+            char nextCh = chIndex + 1 < cmd.len ? cmd.ptr[chIndex + 1] : 0;
+            if (ch == '"') {
+                quote = 0;
+            } else if (ch == '\\' && (nextCh == '"' || nextCh == '\\')) {
+                buf[bufLen++] = nextCh;
+                chIndex += 1;
+            } else {
+                buf[bufLen++] = ch;
+            }
+        } else if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+            if (inArg) {
+                buf[bufLen++] = '\0';
+                inArg = false;
+            }
+        } else {
+            if (!inArg) {
+                prb_stbds_arrput(args, buf + bufLen);
+                inArg = true;
+            }
+            if (ch == '"' || ch == '\'') {
+                quote = ch;
+            } else {
+                buf[bufLen++] = ch;
+            }
+        }
+    }
+
+    prb_Argv result = {prb_arenaAllocArray(arena, const char*, prb_stbds_arrlen(args) + 1), (int32_t)prb_stbds_arrlen(args)};
+    if (result.len > 0) {
+        prb_memcpy(result.args, args, result.len * sizeof(*args));
+    }
+    prb_stbds_arrfree(args);
+    return result;
+}
+
+prb_PUBLICDEF prb_Argv
+prb_argvConcat(prb_Arena* arena, prb_Argv prefix, prb_Str* args, int32_t argCount) {
+    // NOTE(khvorov) Prefix strings are shared, only the pointers are copied
+    prb_Argv result = {prb_arenaAllocArray(arena, const char*, prefix.len + argCount + 1), prefix.len + argCount};
+    if (prefix.len > 0) {
+        prb_memcpy(result.args, prefix.args, prefix.len * sizeof(*prefix.args));
+    }
+    for (int32_t argIndex = 0; argIndex < argCount; argIndex++) {
+        result.args[prefix.len + argIndex] = prb_strGetNullTerminated(arena, args[argIndex]);
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_Str
+prb_argvToStr(prb_Arena* arena, prb_Argv argv) {
+    prb_GrowingStr gstr = prb_beginStr(arena);
+    for (int32_t argIndex = 0; argIndex < argv.len; argIndex++) {
+        prb_Str arg = prb_STR(argv.args[argIndex]);
+        if (argIndex > 0) {
+            prb_addStrSegment(&gstr, " ");
+        }
+
+        bool needsQuotes = arg.len == 0;
+        for (int32_t chIndex = 0; chIndex < arg.len && !needsQuotes; chIndex++) {
+            char ch = arg.ptr[chIndex];
+            needsQuotes = ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '"' || ch == '\'';
+        }
+
+        if (needsQuotes) {
+            prb_addStrSegment(&gstr, "\"");
+            for (int32_t chIndex = 0; chIndex < arg.len; chIndex++) {
+                char ch = arg.ptr[chIndex];
+                if (ch == '"' || ch == '\\') {
+                    prb_addStrSegment(&gstr, "\\");
+                }
+                prb_addStrSegment(&gstr, "%c", ch);
+            }
+            prb_addStrSegment(&gstr, "\"");
+        } else {
+            prb_addStrSegment(&gstr, "%.*s", prb_LIT(arg));
+        }
+    }
+    prb_Str result = prb_endStr(&gstr);
+    return result;
+}
+
+#if prb_PLATFORM_LINUX
+
+typedef struct prb_linux_ExecutableCacheEntry {
+    char* key;
+    char* value;
+} prb_linux_ExecutableCacheEntry;
+
+// NOTE(khvorov) Resolved executable paths, thrown away whenever PATH changes
+static pthread_mutex_t                 prb_linux_executableCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static char*                           prb_linux_executableCachePATH = 0;
+static prb_linux_ExecutableCacheEntry* prb_linux_executableCache = 0;
+
+static char*
+prb_linux_mallocStrCopy(const char* str, size_t len) {
+    char* result = (char*)prb_malloc(len + 1);
+    prb_memcpy(result, str, len);
+    result[len] = '\0';
+    return result;
+}
+
+typedef struct prb_linux_SearchPATHResult {
+    // NOTE(khvorov) Results that depend on the working directory are not cacheable
+    bool  cacheable;
+    char* path;
+} prb_linux_SearchPATHResult;
+
+static prb_linux_SearchPATHResult
+prb_linux_searchPATH(const char* PATH, const char* name) {
+    prb_linux_SearchPATHResult result = {.cacheable = true, .path = 0};
+    size_t                     nameLen = prb_strlen(name);
+    for (const char* dir = PATH; dir && result.path == 0;) {
+        const char* dirEnd = dir;
+        while (*dirEnd != '\0' && *dirEnd != ':') {
+            dirEnd += 1;
+        }
+        size_t dirLen = (size_t)(dirEnd - dir);
+
+        // NOTE(khvorov) Empty entry means the current directory
+        const char* searchDir = dirLen > 0 ? dir : ".";
+        size_t      searchDirLen = dirLen > 0 ? dirLen : 1;
+        if (searchDir[0] != '/') {
+            result.cacheable = false;
+        }
+
+        char* candidate = (char*)prb_malloc(searchDirLen + 1 + nameLen + 1);
+        prb_memcpy(candidate, searchDir, searchDirLen);
+        candidate[searchDirLen] = '/';
+        prb_memcpy(candidate + searchDirLen + 1, name, nameLen + 1);
+
+        struct stat statBuf = {};
+        if (stat(candidate, &statBuf) == 0 && S_ISREG(statBuf.st_mode) && access(candidate, X_OK) == 0) {
+            result.path = candidate;
+        } else {
+            prb_free(candidate);
+        }
+
+        dir = *dirEnd == ':' ? dirEnd + 1 : 0;
+    }
+    return result;
+}
+
+#endif
+
+prb_PUBLICDEF prb_FindExecutableResult
+prb_findExecutable(prb_Arena* arena, prb_Str name) {
+    prb_FindExecutableResult result;
+    prb_memset(&result, 0, sizeof(result));
+
+#if prb_PLATFORM_WINDOWS
+
+    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
+    DWORD               requiredLen = SearchPathW(0, wname.ptr, L".exe", 0, 0, 0);
+    if (requiredLen > 0) {
+        LPWSTR buf = (LPWSTR)prb_arenaAllocArray(arena, uint16_t, (int32_t)requiredLen);
+        DWORD  written = SearchPathW(0, wname.ptr, L".exe", requiredLen, buf, 0);
+        if (written > 0 && written < requiredLen) {
+            result.path = prb_windows_strFromWideStr(arena, (prb_windows_WideStr) {buf, (int32_t)written});
+            result.found = true;
+        }
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    const char* nameNull = prb_strGetNullTerminated(arena, name);
+    bool        hasSlash = false;
+    for (int32_t chIndex = 0; chIndex < name.len && !hasSlash; chIndex++) {
+        hasSlash = name.ptr[chIndex] == '/';
+    }
+
+    if (hasSlash) {
+        result.found = access(nameNull, X_OK) == 0;
+        result.path = prb_STR(nameNull);
+    } else if (name.len > 0) {
+        const char* PATH = getenv("PATH");
+        if (PATH == 0) {
+            PATH = "/bin:/usr/bin";
+        }
+
+        pthread_mutex_lock(&prb_linux_executableCacheMutex);
+
+        if (prb_linux_executableCachePATH == 0 || prb_strcmp(prb_linux_executableCachePATH, PATH) != 0) {
+            for (ptrdiff_t entryIndex = 0; entryIndex < prb_stbds_shlen(prb_linux_executableCache); entryIndex++) {
+                prb_free(prb_linux_executableCache[entryIndex].value);
+            }
+            prb_stbds_shfree(prb_linux_executableCache);
+            prb_stbds_sh_new_strdup(prb_linux_executableCache);
+            prb_free(prb_linux_executableCachePATH);
+            prb_linux_executableCachePATH = prb_linux_mallocStrCopy(PATH, prb_strlen(PATH));
+        }
+
+        // NOTE(khvorov) Checking that the cached file is still there is a lot cheaper than a PATH search
+        ptrdiff_t entryIndex = prb_stbds_shgeti(prb_linux_executableCache, nameNull);
+        if (entryIndex >= 0) {
+            const char* cachedPath = prb_linux_executableCache[entryIndex].value;
+            if (access(cachedPath, X_OK) == 0) {
+                result.path = prb_fmt(arena, "%s", cachedPath);
+                result.found = true;
+            } else {
+                prb_free(prb_linux_executableCache[entryIndex].value);
+                (void)prb_stbds_shdel(prb_linux_executableCache, nameNull);
+            }
+        }
+
+        if (!result.found) {
+            prb_linux_SearchPATHResult searchResult = prb_linux_searchPATH(PATH, nameNull);
+            if (searchResult.path) {
+                result.path = prb_fmt(arena, "%s", searchResult.path);
+                result.found = true;
+                if (searchResult.cacheable) {
+                    prb_stbds_shput(prb_linux_executableCache, nameNull, searchResult.path);
+                } else {
+                    prb_free(searchResult.path);
+                }
+            }
+        }
+
+        pthread_mutex_unlock(&prb_linux_executableCacheMutex);
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return result;
+}
+
+prb_PUBLICDEF prb_CoreCountResult
+prb_getCoreCount(prb_Arena* arena) {
+    prb_TempMemory      temp = prb_beginTempMemory(arena);
+    prb_CoreCountResult result = {.success = false, .cores = 0};
+#if prb_PLATFORM_WINDOWS
+    SYSTEM_INFO sysinfo;
+    prb_memset(&sysinfo, 0, sizeof(sysinfo));
+    GetSystemInfo(&sysinfo);
+    result.success = true;
+    result.cores = (int32_t)sysinfo.dwNumberOfProcessors;
+#elif prb_PLATFORM_LINUX
+    prb_Str cpuinfo = prb_strFromBytes(prb_linux_readFromProc(arena, prb_STR("cpuinfo")));
+    prb_StrScanner scanner = prb_createStrScanner(cpuinfo);
+    prb_StrFindSpec spec = {};
+    spec.pattern = prb_STR("processor");
+    spec.direction = prb_StrDirection_FromEnd;
+    if (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
+        spec.pattern = prb_STR(":");
+        spec.direction = prb_StrDirection_FromStart;
+        if (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
+            spec.mode = prb_StrFindMode_LineBreak;
+            if (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
+                prb_Str coresStr = prb_strTrim(scanner.betweenLastMatches);
+                prb_ParseUintResult parse = prb_parseUint(coresStr, 10);
+                if (parse.success) {
+                    result.success = true;
+                    // NOTE(khvorov) This number is the last CPU index + 1
+                    // Sibling count is not accurate on boards with multiple sockets
+                    result.cores = parse.number + 1;
+                }
+            }
+        }
+    }
+#else
+#error unimplemented
+#endif
+    prb_endTempMemory(temp);
+    return result;
 }
 
 prb_PUBLICDEF prb_CoreCountResult
-prb_getCoreCount(prb_Arena* arena) {
+prb_getAllowExecutionCoreCount(prb_Arena* arena) {
+    prb_CoreCountResult result = {.success = false, .cores = 0};
+    prb_TempMemory      temp = prb_beginTempMemory(arena);
+
+#if prb_PLATFORM_WINDOWS
+    prb_windows_GetAffinityResult affinityRes = prb_windows_getAffinity();
+    if (affinityRes.success) {
+        result.success = true;
+        result.cores = affinityRes.setBits;
+    }
+#elif prb_PLATFORM_LINUX
+    prb_linux_GetAffinityResult affinityRes = prb_linux_getAffinity(arena);
+    if (affinityRes.success) {
+        result.success = true;
+        result.cores = affinityRes.setBits;
+    }
+#else
+#error unimplemented
+#endif
+
+    prb_endTempMemory(temp);
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_allowExecutionOnCores(prb_Arena* arena, int32_t coreCount) {
+    prb_Status     result = prb_Failure;
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    if (coreCount >= 1) {
+#if prb_PLATFORM_WINDOWS
+        prb_windows_GetAffinityResult affinityRes = prb_windows_getAffinity();
+        if (affinityRes.success) {
+            DWORD_PTR newAffinityMask = affinityRes.affinity;
+            int32_t   coreDelta = coreCount - affinityRes.setBits;
+            for (int32_t bitIndex = 0; bitIndex < (int32_t)sizeof(DWORD_PTR) * 8 && coreDelta != 0; bitIndex++) {
+                DWORD_PTR mask = ((DWORD_PTR)1) << bitIndex;
+                bool      coreIsScheduled = (newAffinityMask & mask) == mask;
+                if (coreIsScheduled) {
+                    if (coreDelta > 0) {
+                        newAffinityMask = newAffinityMask | mask;
+                        coreDelta -= 1;
+                    } else {
+                        newAffinityMask = newAffinityMask & (~mask);
+                        coreDelta += 1;
+                    }
+                }
+            }
+
+            if (coreCount != affinityRes.setBits) {
+                if (SetProcessAffinityMask(GetCurrentProcess(), newAffinityMask)) {
+                    result = prb_Success;
+                }
+            } else {
+                result = prb_Success;
+            }
+        }
+
+#elif prb_PLATFORM_LINUX
+
+        prb_linux_GetAffinityResult affinityRes = prb_linux_getAffinity(arena);
+        if (affinityRes.success) {
+            if (coreCount > affinityRes.setBits) {
+                int32_t coresToSchedule = coreCount - affinityRes.setBits;
+                for (int32_t byteIndex = 0; byteIndex < affinityRes.size && coresToSchedule > 0; byteIndex++) {
+                    uint8_t byte = affinityRes.affinity[byteIndex];
+                    for (int32_t bitIndex = 0; bitIndex < 8 && coresToSchedule > 0; bitIndex++) {
+                        uint8_t mask = 1 << bitIndex;
+                        bool coreIsScheduled = (byte & mask) != 0;
+                        if (!coreIsScheduled) {
+                            byte = byte | mask;
+                            affinityRes.affinity[byteIndex] = byte;
+                            coresToSchedule -= 1;
+                        }
+                    }
+                }
+            } else if (coreCount < affinityRes.setBits) {
+                int32_t coresToUnschedule = affinityRes.setBits - coreCount;
+                for (int32_t byteIndex = 0; byteIndex < affinityRes.size && coresToUnschedule > 0; byteIndex++) {
+                    uint8_t byte = affinityRes.affinity[byteIndex];
+                    for (int32_t bitIndex = 0; bitIndex < 8 && coresToUnschedule > 0; bitIndex++) {
+                        uint8_t mask = 1 << bitIndex;
+                        bool coreIsScheduled = (byte & mask) != 0;
+                        if (coreIsScheduled) {
+                            byte = byte & (~mask);
+                            affinityRes.affinity[byteIndex] = byte;
+                            coresToUnschedule -= 1;
+                        }
+                    }
+                }
+            }
+
+            if (coreCount != affinityRes.setBits) {
+                int setAffinityResult = syscall(SYS_sched_setaffinity, 0, affinityRes.size, affinityRes.affinity);
+                if (setAffinityResult == 0) {
+                    result = prb_Success;
+                }
+            } else {
+                result = prb_Success;
+            }
+        }
+#else
+#error unimplemented
+#endif
+    }
+    prb_endTempMemory(temp);
+    return result;
+}
+
+typedef struct prb_EnvNameEntry {
+    char* key;
+    bool  value;
+} prb_EnvNameEntry;
+
+// NOTE(khvorov) Envs made for a single launch are done with before anything can change the environment,
+// so they can point at the inherited strings instead of copying all of them
+static prb_Env
+prb_createEnvImpl(prb_Arena* arena, prb_Str addEnv, bool copyInherited) {
+    prb_Env result;
+    prb_memset(&result, 0, sizeof(result));
+    result.valid = true;
+
+    // NOTE(khvorov) New variables go first and hide the existing ones with the same name
+    const char**      entries = 0;
+    prb_EnvNameEntry* newNames = 0;
+    {
+        prb_StrFindSpec space = {};
+        space.pattern = prb_STR(" ");
+        space.alwaysMatchEnd = true;
+        prb_StrFindSpec equals = {};
+        equals.pattern = prb_STR("=");
+        prb_StrScanner scanner = prb_createStrScanner(addEnv);
+        while (result.valid && prb_strScannerMove(&scanner, space, prb_StrScannerSide_AfterMatch)) {
+            if (scanner.betweenLastMatches.len > 0) {
+                prb_StrFindResult nameFind = prb_strFind(scanner.betweenLastMatches, equals);
+                result.valid = nameFind.found && nameFind.beforeMatch.len > 0;
+                if (result.valid) {
+                    const char* entry = prb_strGetNullTerminated(arena, scanner.betweenLastMatches);
+                    prb_stbds_arrput(entries, entry);
+                    char* name = (char*)prb_strGetNullTerminated(arena, nameFind.beforeMatch);
+                    prb_stbds_shput(newNames, name, true);
+                }
+            }
+        }
+    }
+
+    if (result.valid) {
+        char* nameBuf = 0;
+
+#if prb_PLATFORM_WINDOWS
+
+        // NOTE(khvorov) Always a copy since the strings have to be converted anyway
+        prb_unused(copyInherited);
+        LPWCH existingEnv = GetEnvironmentStringsW();
+        for (LPWCH existingEntry = existingEnv; *existingEntry != 0;) {
+            int32_t wideLen = 0;
+            while (existingEntry[wideLen] != 0) {
+                wideLen += 1;
+            }
+            prb_Str entry = prb_windows_strFromWideStr(arena, (prb_windows_WideStr) {existingEntry, wideLen});
+            existingEntry += wideLen + 1;
+
+#elif prb_PLATFORM_LINUX
+
+        // NOTE(khvorov) Envs that outlive the launch get copies because a later setenv/unsetenv can free the strings
+        for (char** existingEntry = __environ; *existingEntry != 0; existingEntry++) {
+            prb_Str entry = copyInherited ? prb_fmt(arena, "%s", *existingEntry) : prb_STR(*existingEntry);
+
+#else
+#error unimplemented
+#endif
+
+            // NOTE(khvorov) Windows has hidden variables like =C: that start with =
+            int32_t nameLen = entry.len > 0 ? 1 : 0;
+            while (nameLen < entry.len && entry.ptr[nameLen] != '=') {
+                nameLen += 1;
+            }
+            prb_stbds_arrsetlen(nameBuf, nameLen + 1);
+            prb_memcpy(nameBuf, entry.ptr, nameLen);
+            nameBuf[nameLen] = '\0';
+
+            if (prb_stbds_shgeti(newNames, nameBuf) == -1) {
+                prb_stbds_arrput(entries, entry.ptr);
+            }
+        }
+
+#if prb_PLATFORM_WINDOWS
+        FreeEnvironmentStringsW(existingEnv);
+#endif
+
+        prb_stbds_arrfree(nameBuf);
+
+        result.count = (int32_t)prb_stbds_arrlen(entries);
+        result.entries = prb_arenaAllocArray(arena, const char*, result.count + 1);
+        prb_memcpy(result.entries, entries, result.count * sizeof(*entries));
+
+#if prb_PLATFORM_WINDOWS
+        {
+            int32_t blockLen = 1;
+            for (int32_t entryIndex = 0; entryIndex < result.count; entryIndex++) {
+                blockLen += prb_strlen(result.entries[entryIndex]) + 1;
+            }
+            char*   block = (char*)prb_arenaAllocAndZero(arena, blockLen, 1);
+            int32_t blockOffset = 0;
+            for (int32_t entryIndex = 0; entryIndex < result.count; entryIndex++) {
+                int32_t entryLen = prb_strlen(result.entries[entryIndex]);
+                prb_memcpy(block + blockOffset, result.entries[entryIndex], entryLen);
+                blockOffset += entryLen + 1;
+            }
+            result.block = prb_windows_getWideStr(arena, (prb_Str) {block, blockLen}).ptr;
+        }
+#endif
+    }
+
+    prb_stbds_arrfree(entries);
+    prb_stbds_shfree(newNames);
+    return result;
+}
+
+prb_PUBLICDEF prb_Process
+prb_createProcess(prb_Str cmd, prb_ProcessSpec spec) {
+    prb_Process proc;
+    prb_memset(&proc, 0, sizeof(proc));
+    proc.cmd = cmd;
+    proc.spec = spec;
+    return proc;
+}
+
+prb_PUBLICDEF prb_Status
+prb_launchProcesses(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_Background mode) {
+    prb_Status result = prb_Success;
+
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        prb_Process* proc = procs + procIndex;
+        if (proc->status == prb_ProcessStatus_NotLaunched) {
+            prb_TempMemory  temp = prb_beginTempMemory(arena);
+            prb_ProcessSpec spec = proc->spec;
+
+#if prb_PLATFORM_WINDOWS
+
+            STARTUPINFOW startupInfo;
+            prb_memset(&startupInfo, 0, sizeof(startupInfo));
+            startupInfo.cb = sizeof(STARTUPINFOW);
+
+            // NOTE(khvorov) Capturing, buffering and hashing output, feeding stdin, sampling and io priorities are not implemented on windows
+            bool    redirectSuccessful = !spec.captureStdout && !spec.captureStderr && !spec.bufferOutput && !spec.feedStdin && !spec.hashStdout && spec.sampleIntervalMs <= 0 && spec.ioPriorityClass == prb_IoPriorityClass_Inherit;
+            BOOL    inheritHandles = spec.redirectStdout || spec.redirectStderr;
+            HANDLE  handlesToClose[2] = {0, 0};
+            int32_t handlesToCloseCount = 0;
+
+            if (inheritHandles) {
+                startupInfo.dwFlags = STARTF_USESTDHANDLES;
+
+                SECURITY_ATTRIBUTES securityAttr = {
+                    .nLength = sizeof(securityAttr),
+                    .lpSecurityDescriptor = NULL,
+                    .bInheritHandle = TRUE,
+                };
+
+                prb_Str stdoutPath = spec.stdoutFilepath;
+                if (stdoutPath.ptr == 0 || stdoutPath.len == 0) {
+                    stdoutPath = prb_STR("NUL");
+                }
+
+                prb_Str stderrPath = spec.stderrFilepath;
+                if (stderrPath.ptr == 0 || stderrPath.len == 0) {
+                    stderrPath = prb_STR("NUL");
+                }
+
+                if (spec.redirectStdout && spec.redirectStderr && prb_streq(stdoutPath, stderrPath)) {
+                    prb_windows_OpenResult openRes = prb_windows_open(arena, stdoutPath, GENERIC_WRITE, FILE_SHARE_WRITE, CREATE_ALWAYS, &securityAttr);
+                    if (openRes.success) {
+                        startupInfo.hStdOutput = openRes.handle;
+                        startupInfo.hStdError = openRes.handle;
+                        handlesToClose[handlesToCloseCount++] = openRes.handle;
+                    } else {
+                        redirectSuccessful = false;
+                    }
+                } else {
+                    if (spec.redirectStdout) {
+                        prb_windows_OpenResult openRes = prb_windows_open(arena, stdoutPath, GENERIC_WRITE, 0, CREATE_ALWAYS, &securityAttr);
+                        if (openRes.success) {
+                            startupInfo.hStdOutput = openRes.handle;
+                            handlesToClose[handlesToCloseCount++] = openRes.handle;
+                        } else {
+                            redirectSuccessful = false;
+                        }
+                    }
+
+                    if (spec.redirectStderr) {
+                        prb_windows_OpenResult openRes = prb_windows_open(arena, stderrPath, GENERIC_WRITE, 0, CREATE_ALWAYS, &securityAttr);
+                        if (openRes.success) {
+                            startupInfo.hStdError = openRes.handle;
+                            handlesToClose[handlesToCloseCount++] = openRes.handle;
+                        } else {
+                            redirectSuccessful = false;
+                        }
+                    }
+                }
+            }
+
+            if (redirectSuccessful) {
+                prb_assert(!spec.env || spec.addEnv.len == 0);
+                prb_Env* env = spec.env;
+                prb_Env  addedEnv = {};
+                if (!env && spec.addEnv.ptr && spec.addEnv.len > 0) {
+                    addedEnv = prb_createEnvImpl(arena, spec.addEnv, false);
+                    env = &addedEnv;
+                }
+
+                prb_Str             cmd = proc->argv.args ? prb_argvToStr(arena, proc->argv) : proc->cmd;
+                prb_windows_WideStr wcmd = prb_windows_getWideStr(arena, cmd);
+                LPWCH               envBlock = env ? env->block : 0;
+                // NOTE(khvorov) The process starts suspended so that it can't launch anything before it's in the job
+                DWORD creationFlags = CREATE_UNICODE_ENVIRONMENT;
+                if (spec.ownProcessGroup) {
+                    creationFlags |= CREATE_NEW_PROCESS_GROUP | CREATE_SUSPENDED;
+                }
+                // NOTE(khvorov) Windows only has priority classes, niceness and sched policies map onto the closest one
+                if (spec.schedPolicy == prb_SchedPolicy_Idle) {
+                    creationFlags |= IDLE_PRIORITY_CLASS;
+                } else if (spec.niceIncrement > 0 || spec.schedPolicy == prb_SchedPolicy_Batch) {
+                    creationFlags |= BELOW_NORMAL_PRIORITY_CLASS;
+                } else if (spec.niceIncrement < 0) {
+                    creationFlags |= ABOVE_NORMAL_PRIORITY_CLASS;
+                }
+                if ((!env || env->valid) && CreateProcessW(0, wcmd.ptr, 0, 0, inheritHandles, creationFlags, envBlock, 0, &startupInfo, &proc->processInfo)) {
+                    proc->status = prb_ProcessStatus_Launched;
+                    proc->launchTime = prb_timeStart();
+                    if (spec.ownProcessGroup) {
+                        proc->job = CreateJobObjectW(0, 0);
+                        if (proc->job && !AssignProcessToJobObject(proc->job, proc->processInfo.hProcess)) {
+                            CloseHandle(proc->job);
+                            proc->job = 0;
+                        }
+                        ResumeThread(proc->processInfo.hThread);
+                    }
+                }
+            }
+
+            for (int32_t handleIndex = 0; handleIndex < handlesToCloseCount; handleIndex++) {
+                CloseHandle(handlesToClose[handleIndex]);
+            }
+
+#elif prb_PLATFORM_LINUX
+
+            proc->stdoutPipe = -1;
+            proc->stderrPipe = -1;
+            proc->stdinPipe = -1;
+            proc->stdinWritten = 0;
+            proc->stdoutHashStream = prb_createHashStream();
+            proc->sampleBuffer = 0;
+            proc->samples = 0;
+            proc->sampleCount = 0;
+            prb_assert(spec.sampleIntervalMs <= 0 || spec.captureArena);
+
+            // NOTE(khvorov) Capturing takes precedence over redirecting to a file
+            bool redirectStdout = spec.redirectStdout && !spec.captureStdout && !spec.hashStdout;
+            bool redirectStderr = spec.redirectStderr && !spec.captureStderr;
+
+            const char* stdoutPath = 0;
+            if (redirectStdout) {
+                if (spec.stdoutFilepath.ptr && spec.stdoutFilepath.len > 0) {
+                    stdoutPath = prb_strGetNullTerminated(arena, spec.stdoutFilepath);
+                } else {
+                    stdoutPath = "/dev/null";
+                }
+            }
+
+            const char* stderrPath = 0;
+            if (redirectStderr) {
+                if (spec.stderrFilepath.ptr && spec.stderrFilepath.len > 0) {
+                    stderrPath = prb_strGetNullTerminated(arena, spec.stderrFilepath);
+                } else {
+                    stderrPath = "/dev/null";
+                }
+            }
+
+            // NOTE(khvorov) Buffered output goes through the stdout capture pipe, stderr included
+            prb_assert(!spec.bufferOutput || (!spec.captureStdout && !spec.captureStderr && !spec.redirectStdout && !spec.redirectStderr && !spec.hashStdout));
+            int stdoutCapturePipe[2] = {-1, -1};
+            int stderrCapturePipe[2] = {-1, -1};
+            int stdinFeedPipe[2] = {-1, -1};
+            bool fileActionsSucceeded = true;
+            if (spec.feedStdin) {
+                prb_assert(!proc->hasPipelineStdin && spec.stdinBytes.len >= 0);
+                fileActionsSucceeded = prb_linux_createCapturePipe(stdinFeedPipe);
+            }
+            if (fileActionsSucceeded && spec.bufferOutput) {
+                fileActionsSucceeded = prb_linux_createCapturePipe(stdoutCapturePipe);
+            } else if (fileActionsSucceeded && (spec.captureStdout || spec.captureStderr || spec.hashStdout)) {
+                prb_assert(spec.captureArena || (!spec.captureStdout && !spec.captureStderr));
+                if (spec.captureStdout || spec.hashStdout) {
+                    fileActionsSucceeded = prb_linux_createCapturePipe(stdoutCapturePipe);
+                }
+                if (fileActionsSucceeded && spec.captureStderr) {
+                    fileActionsSucceeded = prb_linux_createCapturePipe(stderrCapturePipe);
+                }
+            }
+
+            bool fileActionsInited = false;
+            posix_spawn_file_actions_t* fileActionsPtr = 0;
+            posix_spawn_file_actions_t fileActions = {};
+            bool pipelined = proc->hasPipelineStdin || proc->hasPipelineStdout;
+            bool stdoutToPipe = spec.captureStdout || spec.bufferOutput || spec.hashStdout;
+            if (fileActionsSucceeded && (redirectStdout || redirectStderr || stdoutToPipe || spec.captureStderr || pipelined || spec.feedStdin)) {
+                fileActionsPtr = &fileActions;
+                int initResult = posix_spawn_file_actions_init(&fileActions);
+                fileActionsSucceeded = initResult == 0;
+                fileActionsInited = initResult == 0;
+                if (fileActionsSucceeded && proc->hasPipelineStdin) {
+                    int dupResult = posix_spawn_file_actions_adddup2(&fileActions, proc->pipelineStdin, STDIN_FILENO);
+                    fileActionsSucceeded = dupResult == 0;
+                } else if (fileActionsSucceeded && spec.feedStdin) {
+                    int dupResult = posix_spawn_file_actions_adddup2(&fileActions, stdinFeedPipe[0], STDIN_FILENO);
+                    fileActionsSucceeded = dupResult == 0;
+                }
+                if (fileActionsSucceeded) {
+                    // NOTE(khvorov) The next pipeline stage takes precedence over everything else
+                    if (proc->hasPipelineStdout) {
+                        int dupResult = posix_spawn_file_actions_adddup2(&fileActions, proc->pipelineStdout, STDOUT_FILENO);
+                        fileActionsSucceeded = dupResult == 0;
+                    } else if (stdoutToPipe) {
+                        int dupResult = posix_spawn_file_actions_adddup2(&fileActions, stdoutCapturePipe[1], STDOUT_FILENO);
+                        fileActionsSucceeded = dupResult == 0;
+                    } else if (redirectStdout) {
+                        int stdoutRedirectResult = posix_spawn_file_actions_addopen(
+                            &fileActions,
+                            STDOUT_FILENO,
+                            stdoutPath,
+                            O_WRONLY | O_CREAT | O_TRUNC,
+                            S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR
+                        );
+                        fileActionsSucceeded = stdoutRedirectResult == 0;
+                    }
+
+                    if (fileActionsSucceeded && spec.captureStderr) {
+                        int dupResult = posix_spawn_file_actions_adddup2(&fileActions, stderrCapturePipe[1], STDERR_FILENO);
+                        fileActionsSucceeded = dupResult == 0;
+                    } else if (fileActionsSucceeded && spec.bufferOutput) {
+                        int dupResult = posix_spawn_file_actions_adddup2(&fileActions, stdoutCapturePipe[1], STDERR_FILENO);
+                        fileActionsSucceeded = dupResult == 0;
+                    } else if (fileActionsSucceeded && redirectStderr) {
+                        if (redirectStdout && prb_streq(prb_STR(stdoutPath), prb_STR(stderrPath))) {
+                            int dupResult = posix_spawn_file_actions_adddup2(&fileActions, STDOUT_FILENO, STDERR_FILENO);
+                            fileActionsSucceeded = dupResult == 0;
+                        } else {
+                            int stderrRedirectResult = posix_spawn_file_actions_addopen(
+                                &fileActions,
+                                STDERR_FILENO,
+                                stderrPath,
+                                O_WRONLY | O_CREAT | O_TRUNC,
+                                S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR
+                            );
+                            fileActionsSucceeded = stderrRedirectResult == 0;
+                        }
+                    }
+                }
+            }
+
+            if (fileActionsSucceeded) {
+                prb_assert(!spec.env || spec.addEnv.len == 0);
+                bool   envSucceeded = true;
+                char** env = __environ;
+                if (spec.env) {
+                    envSucceeded = spec.env->valid;
+                    env = (char**)spec.env->entries;
+                } else if (spec.addEnv.ptr && spec.addEnv.len > 0) {
+                    prb_Env addedEnv = prb_createEnvImpl(arena, spec.addEnv, false);
+                    envSucceeded = addedEnv.valid;
+                    env = (char**)addedEnv.entries;
+                }
+
+                if (envSucceeded) {
+                    const char** args = proc->argv.args;
+                    if (!args) {
+                        args = prb_getArgArrayFromStr(arena, proc->cmd);
+                    }
+
+                    posix_spawnattr_t* attrPtr = 0;
+                    posix_spawnattr_t  attr = {};
+                    if (spec.ownProcessGroup && posix_spawnattr_init(&attr) == 0) {
+                        attrPtr = &attr;
+                        // NOTE(khvorov) Group id 0 means the group is the child's own pid
+                        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+                        posix_spawnattr_setpgroup(&attr, 0);
+                    }
+
+                    prb_linux_SpawnArgs spawnArgs = {};
+                    spawnArgs.pid = &proc->pid;
+                    spawnArgs.exe = prb_findExecutable(arena, prb_STR(args[0]));
+                    spawnArgs.args = args;
+                    spawnArgs.env = env;
+                    spawnArgs.fileActions = fileActionsPtr;
+                    spawnArgs.attr = attrPtr;
+                    spawnArgs.niceIncrement = spec.niceIncrement;
+                    if (spec.ioPriorityClass != prb_IoPriorityClass_Inherit) {
+                        // NOTE(khvorov) Class goes in the top 3 bits of 16, the classes are numbered the same way as in the kernel
+                        int level = spec.ioPriorityClass == prb_IoPriorityClass_Idle ? 0 : spec.ioPriorityLevel;
+                        prb_assert(level >= 0 && level <= 7);
+                        spawnArgs.ioPriority = ((int)spec.ioPriorityClass << 13) | level;
+                    }
+                    spawnArgs.schedBatch = spec.schedPolicy == prb_SchedPolicy_Batch;
+
+                    if (spawnArgs.niceIncrement != 0 || spawnArgs.ioPriority != 0 || spawnArgs.schedBatch) {
+                        prb_linux_spawnWithPriority(&spawnArgs);
+                    } else {
+                        prb_linux_spawn(&spawnArgs);
+                    }
+                    int spawnResult = spawnArgs.result;
+                    if (attrPtr) {
+                        posix_spawnattr_destroy(attrPtr);
+                    }
+
+                    // NOTE(khvorov) posix_spawnattr only takes the posix policies, and an idle spawning thread would be
+                    // left waiting for an idle cpu to launch on. So idle is set on the child after it has already exec'd,
+                    // which means it may have run for a bit under the old policy.
+                    if (spawnResult == 0 && spec.schedPolicy == prb_SchedPolicy_Idle) {
+                        struct sched_param schedParam = {};
+                        if (sched_setscheduler(proc->pid, SCHED_IDLE, &schedParam) != 0) {
+                            spawnResult = errno;
+                            kill(proc->pid, SIGKILL);
+                            waitpid(proc->pid, 0, 0);
+                        }
+                    }
+                    if (spawnResult == 0) {
+                        proc->status = prb_ProcessStatus_Launched;
+                        proc->launchTime = prb_timeStart();
+                        proc->stdoutPipe = prb_linux_takeCapturePipeReadEnd(stdoutCapturePipe);
+                        proc->stderrPipe = prb_linux_takeCapturePipeReadEnd(stderrCapturePipe);
+                        if (spec.feedStdin) {
+                            proc->stdinPipe = stdinFeedPipe[1];
+                            stdinFeedPipe[1] = -1;
+                            fcntl(proc->stdinPipe, F_SETFL, fcntl(proc->stdinPipe, F_GETFL) | O_NONBLOCK);
+                            prb_linux_feedStdinPipe(proc);
+                        }
+                    }
+                    if (!proc->argv.args) {
+                        prb_stbds_arrfree(args);
+                    }
+                }
+
+            }
+
+            if (fileActionsInited) {
+                posix_spawn_file_actions_destroy(fileActionsPtr);
+            }
+
+            for (int32_t pipeEndIndex = 0; pipeEndIndex < 2; pipeEndIndex++) {
+                if (stdoutCapturePipe[pipeEndIndex] != -1) {
+                    close(stdoutCapturePipe[pipeEndIndex]);
+                }
+                if (stderrCapturePipe[pipeEndIndex] != -1) {
+                    close(stderrCapturePipe[pipeEndIndex]);
+                }
+                if (stdinFeedPipe[pipeEndIndex] != -1) {
+                    close(stdinFeedPipe[pipeEndIndex]);
+                }
+            }
+
+#else
+#error unimplemented
+#endif
+
+            // NOTE(khvorov) Captured output may go to the same arena so the temp memory has to be released first
+            prb_endTempMemory(temp);
+            if (mode == prb_Background_No && proc->status == prb_ProcessStatus_Launched) {
+                prb_waitForProcesses(proc, 1);
+            }
+
+            prb_ProcessStatus reqStatus = prb_ProcessStatus_CompletedSuccess;
+            if (mode == prb_Background_Yes) {
+                reqStatus = prb_ProcessStatus_Launched;
+            }
+            if (proc->status != reqStatus) {
+                result = prb_Failure;
+            }
+        }
+    }
+
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_waitForProcesses(prb_Process* handles, int32_t handleCount) {
+    prb_Status result = prb_Success;
+    for (int32_t handleIndex = 0; handleIndex < handleCount; handleIndex++) {
+        prb_assert(handles[handleIndex].status != prb_ProcessStatus_NotLaunched);
+    }
+
+    // NOTE(khvorov) Waiting one by one would leave the others blocked on their captured output
+    // and reap them late
+    prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(handles, handleCount);
+    while (prb_processCompletionIterNext(&iter) == prb_Success) {
+        if (iter.curProc->status != prb_ProcessStatus_CompletedSuccess) {
+            result = prb_Failure;
+        }
+    }
+    prb_destroyProcessCompletionIter(&iter);
+
+    for (int32_t handleIndex = 0; handleIndex < handleCount; handleIndex++) {
+        if (handles[handleIndex].status == prb_ProcessStatus_Launched) {
+            result = prb_Failure;
+        }
+    }
+
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_killProcesses(prb_Process* handles, int32_t handleCount) {
+    prb_Status result = prb_Success;
+
+    for (int32_t handleIndex = 0; handleIndex < handleCount; handleIndex++) {
+        prb_Process* handle = handles + handleIndex;
+        prb_assert(handle->status != prb_ProcessStatus_NotLaunched);
+        if (handle->status == prb_ProcessStatus_Launched) {
+            // NOTE(khvorov) Reaping the process right away so that it doesn't linger as a zombie
+#if prb_PLATFORM_WINDOWS
+            if (prb_windows_sendKill(handle)) {
+                prb_windows_waitForProcess(handle);
+                handle->status = prb_ProcessStatus_CompletedFailed;
+            }
+#elif prb_PLATFORM_LINUX
+            if (prb_linux_sendKill(handle)) {
+                // NOTE(khvorov) Whatever the process inherited the pipes to could still be holding them,
+                // so only what's been written so far is kept
+                prb_linux_drainStdoutPipe(handle);
+                prb_linux_drainCapturePipe(&handle->stderrPipe, &handle->stderrBuffer, 0);
+                prb_linux_closeCapturePipeHandles(handle);
+                prb_linux_waitForProcess(handle);
+                handle->status = prb_ProcessStatus_CompletedFailed;
+            }
+#else
+#error unimplemented
+#endif
+
+            if (handle->status != prb_ProcessStatus_CompletedFailed) {
+                result = prb_Failure;
+            }
+        }
+    }
+
+    return result;
+}
+
+prb_PUBLICDEF prb_Process
+prb_createProcessArgv(prb_Argv argv, prb_ProcessSpec spec) {
+    prb_assert(argv.args && argv.len > 0 && argv.args[argv.len] == 0);
+    prb_Process proc;
+    prb_memset(&proc, 0, sizeof(proc));
+    proc.argv = argv;
+    proc.spec = spec;
+    return proc;
+}
+
+prb_PUBLICDEF prb_ProcessUsage
+prb_getProcessUsage(prb_Process* proc) {
+    prb_assert(proc->status != prb_ProcessStatus_NotLaunched);
+    prb_ProcessUsage result = proc->usage;
+    if (proc->status == prb_ProcessStatus_Launched) {
+        result.wallMs = prb_getMsFrom(proc->launchTime);
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_MemoryInfo
+prb_getMemoryInfo(prb_Arena* arena) {
+    prb_MemoryInfo result = {};
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+#if prb_PLATFORM_WINDOWS
+
+    MEMORYSTATUSEX status = {};
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        result.valid = true;
+        result.totalBytes = (int64_t)status.ullTotalPhys;
+        result.availableBytes = (int64_t)status.ullAvailPhys;
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    prb_Str             meminfo = prb_linux_readSmallFile(arena, prb_STR("/proc/meminfo"));
+    prb_ParseUintResult total = prb_linux_parseMeminfoField(meminfo, prb_STR("MemTotal"));
+    prb_ParseUintResult available = prb_linux_parseMeminfoField(meminfo, prb_STR("MemAvailable"));
+    if (total.success && available.success) {
+        result.valid = true;
+        result.totalBytes = (int64_t)total.number;
+        result.availableBytes = (int64_t)available.number;
+
+        // NOTE(khvorov) Every cgroup up the hierarchy can have its own limit. The v2 entry looks like "0::/path"
+        prb_Str cgroups = prb_linux_readSmallFile(arena, prb_STR("/proc/self/cgroup"));
+        prb_StrScanner  scanner = prb_createStrScanner(cgroups);
+        prb_StrFindSpec lineBreakSpec = {};
+        lineBreakSpec.mode = prb_StrFindMode_LineBreak;
+        while (prb_strScannerMove(&scanner, lineBreakSpec, prb_StrScannerSide_AfterMatch)) {
+            prb_Str line = scanner.betweenLastMatches;
+            if (prb_strStartsWith(line, prb_STR("0::/"))) {
+                prb_Str cgroupPath = prb_strSlice(line, 3, line.len);
+                for (;;) {
+                    prb_Str dir = prb_fmt(arena, "/sys/fs/cgroup%.*s", prb_LIT(cgroupPath));
+                    prb_Str maxStr = prb_strTrim(prb_linux_readSmallFile(arena, prb_fmt(arena, "%.*s/memory.max", prb_LIT(dir))));
+                    prb_Str currentStr = prb_strTrim(prb_linux_readSmallFile(arena, prb_fmt(arena, "%.*s/memory.current", prb_LIT(dir))));
+                    prb_ParseUintResult max = prb_parseUint(maxStr, 10);
+                    prb_ParseUintResult current = prb_parseUint(currentStr, 10);
+                    if (max.success && current.success) {
+                        int64_t cgroupAvailable = prb_max((int64_t)max.number - (int64_t)current.number, 0);
+                        result.totalBytes = prb_min(result.totalBytes, (int64_t)max.number);
+                        result.availableBytes = prb_min(result.availableBytes, cgroupAvailable);
+                    }
+
+                    if (cgroupPath.len <= 1) {
+                        break;
+                    }
+                    prb_StrFindSpec slashSpec = {.mode = prb_StrFindMode_Exact, .direction = prb_StrDirection_FromEnd, .pattern = prb_STR("/"), .alwaysMatchEnd = false};
+                    prb_StrFindResult parent = prb_strFind(cgroupPath, slashSpec);
+                    cgroupPath = parent.beforeMatch.len > 0 ? parent.beforeMatch : prb_STR("/");
+                }
+                break;
+            }
+        }
+    }
+
+#else
+#error unimplemented
+#endif
+
+    prb_endTempMemory(temp);
+    return result;
+}
+
+prb_PUBLICDEF int64_t
+prb_getProcessMemory(prb_Arena* arena, prb_Process* proc) {
+    int64_t result = 0;
+    if (proc->status == prb_ProcessStatus_Launched) {
+#if prb_PLATFORM_WINDOWS
+        // NOTE(khvorov) Only the process itself, not what it launched
+        prb_unused(arena);
+        PROCESS_MEMORY_COUNTERS memoryCounters;
+        if (K32GetProcessMemoryInfo(proc->processInfo.hProcess, &memoryCounters, sizeof(memoryCounters))) {
+            result = (int64_t)memoryCounters.WorkingSetSize;
+        }
+#elif prb_PLATFORM_LINUX
+        result = prb_linux_getProcessTreeRss(arena, proc->pid);
+#else
+#error unimplemented
+#endif
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_SystemLoad
+prb_getSystemLoad(prb_Arena* arena) {
+    prb_SystemLoad result = {};
+
+#if prb_PLATFORM_WINDOWS
+
+    // NOTE(khvorov) Windows doesn't keep a load average
+    prb_unused(arena);
+
+#elif prb_PLATFORM_LINUX
+
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    // NOTE(khvorov) Looks like "0.64 0.44 0.32 2/73 27332"
+    prb_Str          loadavg = prb_linux_readSmallFile(arena, prb_STR("/proc/loadavg"));
+    prb_StrFindSpec  spaceSpec = {.mode = prb_StrFindMode_Exact, .direction = prb_StrDirection_FromStart, .pattern = prb_STR(" "), .alwaysMatchEnd = false};
+    prb_StrFindResult firstField = prb_strFind(loadavg, spaceSpec);
+    if (firstField.found) {
+        prb_ParsedNumber number = prb_parseNumber(firstField.beforeMatch);
+        if (number.kind == prb_ParsedNumberKind_F64 || number.kind == prb_ParsedNumberKind_U64) {
+            result.valid = true;
+            result.loadAverage = number.kind == prb_ParsedNumberKind_F64 ? (float)number.parsedF64 : (float)number.parsedU64;
+        }
+    }
+
+    // NOTE(khvorov) Looks like "some avg10=2.13 avg60=6.91 avg300=5.09 total=88723964"
+    prb_Str           pressure = prb_linux_readSmallFile(arena, prb_STR("/proc/pressure/cpu"));
+    prb_StrFindSpec   avgSpec = {.mode = prb_StrFindMode_Exact, .direction = prb_StrDirection_FromStart, .pattern = prb_STR("some avg10="), .alwaysMatchEnd = false};
+    prb_StrFindResult avgField = prb_strFind(pressure, avgSpec);
+    if (avgField.found) {
+        prb_StrFindResult avgValue = prb_strFind(avgField.afterMatch, spaceSpec);
+        if (avgValue.found) {
+            prb_ParsedNumber number = prb_parseNumber(avgValue.beforeMatch);
+            if (number.kind == prb_ParsedNumberKind_F64 || number.kind == prb_ParsedNumberKind_U64) {
+                result.cpuPressureValid = true;
+                result.cpuPressure = number.kind == prb_ParsedNumberKind_F64 ? (float)number.parsedF64 : (float)number.parsedU64;
+            }
+        }
+    }
+
+    prb_endTempMemory(temp);
+
+#else
+#error unimplemented
+#endif
+
+    return result;
+}
+
+// NOTE(khvorov) Running processes that haven't grown to the expected size yet are likely to take more
+static bool
+prb_processPoolFitsInMemory(prb_Arena* arena, prb_Process* procs, int32_t procCount, int64_t expectedBytes) {
+    bool           result = true;
+    prb_MemoryInfo memory = prb_getMemoryInfo(arena);
+    if (memory.valid) {
+        int64_t projectedBytes = expectedBytes;
+        for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+            prb_Process* proc = procs + procIndex;
+            if (proc->status == prb_ProcessStatus_Launched) {
+                projectedBytes += prb_max(expectedBytes - prb_getProcessMemory(arena, proc), 0);
+            }
+        }
+        result = projectedBytes <= memory.availableBytes;
+    }
+    return result;
+}
+
+static bool
+prb_processPoolFitsInLoad(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_ProcessPoolSpec spec) {
+    bool           result = true;
+    prb_SystemLoad load = prb_getSystemLoad(arena);
+    if (load.valid && spec.maxLoad > 0) {
+        // NOTE(khvorov) The load average takes a while to notice new processes
+        float projectedLoad = load.loadAverage;
+        for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+            prb_Process* proc = procs + procIndex;
+            if (proc->status == prb_ProcessStatus_Launched && prb_getMsFrom(proc->launchTime) < 1000.0f) {
+                projectedLoad += 1.0f;
+            }
+        }
+        result = projectedLoad < spec.maxLoad;
+    }
+    if (result && load.cpuPressureValid && spec.maxCpuPressure > 0) {
+        result = load.cpuPressure < spec.maxCpuPressure;
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_launchProcessPool(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_ProcessPoolSpec spec) {
+    prb_Status result = prb_Success;
+
+    int32_t maxInFlight = spec.maxInFlight;
+    if (maxInFlight <= 0 && spec.jobserver) {
+        maxInFlight = INT32_MAX;
+    } else if (maxInFlight <= 0) {
+        prb_CoreCountResult cores = prb_getAllowExecutionCoreCount(arena);
+        maxInFlight = cores.success ? cores.cores : 1;
+    }
+    maxInFlight = prb_max(maxInFlight, 1);
+
+    // NOTE(khvorov) Processes that were launched before the call take up slots too
+    int32_t inFlightCount = 0;
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        if (procs[procIndex].status == prb_ProcessStatus_Launched) {
+            inFlightCount += 1;
+        }
+    }
+
+    prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(procs, procCount);
+    iter.deadlineMs = spec.deadlineMs;
+    iter.holdBufferedOutput = true;
+    int32_t nextOutputIndex = 0;
+    int32_t nextProcIndex = 0;
+    int32_t tokensHeld = 0;
+    bool    stopLaunching = false;
+    int64_t expectedMemoryBytes = spec.memoryPerProcessBytes;
+    bool          holdingBack = false;
+    prb_TimeStart holdBackStart = {};
+    for (;;) {
+        if (spec.deadlineMs > 0 && prb_getMsFrom(iter.createTime) >= spec.deadlineMs) {
+            stopLaunching = true;
+        }
+
+        while (!stopLaunching && inFlightCount < maxInFlight && nextProcIndex < procCount) {
+            prb_Process* proc = procs + nextProcIndex;
+            if (proc->status == prb_ProcessStatus_NotLaunched) {
+                // NOTE(khvorov) Something has to run for the pool to make progress
+                bool holdBack = false;
+                if (inFlightCount > 0) {
+                    holdBack = spec.throttleOnMemory && !prb_processPoolFitsInMemory(arena, procs, procCount, expectedMemoryBytes);
+                    if (!holdBack && (spec.maxLoad > 0 || spec.maxCpuPressure > 0)) {
+                        holdBack = !prb_processPoolFitsInLoad(arena, procs, procCount, spec);
+                    }
+                }
+                if (holdBack) {
+                    if (!holdingBack) {
+                        holdingBack = true;
+                        holdBackStart = prb_timeStart();
+                    }
+                    break;
+                }
+                if (holdingBack) {
+                    proc->heldBackMs = prb_getMsFrom(holdBackStart);
+                    holdingBack = false;
+                }
+
+                bool gotToken = false;
+                if (spec.jobserver) {
+                    // NOTE(khvorov) Only block when nothing of ours is running, otherwise we could be
+                    // waiting for tokens held by our own children. With nothing running the implicit
+                    // token is free so this only fails when the jobserver is broken.
+                    if (inFlightCount == 0) {
+                        gotToken = prb_jobserverAcquire(spec.jobserver) == prb_Success;
+                    } else if (prb_jobserverTryAcquire(spec.jobserver) == prb_Success) {
+                        gotToken = true;
+                    } else {
+                        break;
+                    }
+                }
+
+                if (spec.failFast || spec.deadlineMs > 0) {
+                    proc->spec.ownProcessGroup = true;
+                }
+                if (prb_launchProcesses(arena, proc, 1, prb_Background_Yes) == prb_Success) {
+                    inFlightCount += 1;
+                    tokensHeld += gotToken;
+                } else {
+                    result = prb_Failure;
+                    if (gotToken) {
+                        prb_jobserverRelease(spec.jobserver);
+                    }
+                }
+            }
+            nextProcIndex += 1;
+        }
+
+        // NOTE(khvorov) Whichever process finishes first frees up its slot right away
+        if (prb_processCompletionIterNext(&iter) == prb_Success) {
+            inFlightCount -= 1;
+            expectedMemoryBytes = prb_max(expectedMemoryBytes, iter.curProc->usage.maxRssBytes);
+            if (tokensHeld > 0) {
+                prb_jobserverRelease(spec.jobserver);
+                tokensHeld -= 1;
+            }
+            // NOTE(khvorov) Everything that completed before the first unfinished process goes out in one batch
+            if (spec.outputInLaunchOrder) {
+                int32_t readyEnd = nextOutputIndex;
+                while (readyEnd < procCount && (procs[readyEnd].status == prb_ProcessStatus_CompletedSuccess || procs[readyEnd].status == prb_ProcessStatus_CompletedFailed)) {
+                    readyEnd += 1;
+                }
+                prb_writeBufferedOutput(procs + nextOutputIndex, readyEnd - nextOutputIndex);
+                nextOutputIndex = readyEnd;
+            } else {
+                prb_writeBufferedOutput(iter.curProc, 1);
+            }
+
+            if (iter.curProc->status != prb_ProcessStatus_CompletedSuccess) {
+                result = prb_Failure;
+                if (spec.failFast && !stopLaunching) {
+                    stopLaunching = true;
+                    // NOTE(khvorov) Killed processes are reaped right away and won't come out of the iterator
+                    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+                        prb_Process* proc = procs + procIndex;
+                        if (proc->status == prb_ProcessStatus_Launched) {
+                            prb_killProcesses(proc, 1);
+                            inFlightCount -= 1;
+                            if (tokensHeld > 0) {
+                                prb_jobserverRelease(spec.jobserver);
+                                tokensHeld -= 1;
+                            }
+                        }
+                    }
+                }
+            }
+        } else {
+            // NOTE(khvorov) Waiting can give up while some are still running
+            for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+                if (procs[procIndex].status == prb_ProcessStatus_Launched) {
+                    result = prb_Failure;
+                }
+            }
+            break;
+        }
+    }
+    prb_destroyProcessCompletionIter(&iter);
+    prb_writeBufferedOutput(procs + nextOutputIndex, procCount - nextOutputIndex);
+
+    // NOTE(khvorov) Some processes were never launched because of a failure or the deadline
+    if (nextProcIndex < procCount) {
+        result = prb_Failure;
+    }
+
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_launchPipeline(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_Background mode) {
+    prb_Status result = prb_Success;
+
+#if prb_PLATFORM_WINDOWS
+
+    // NOTE(khvorov) Pipelines are not implemented on windows
+    prb_unused(arena);
+    prb_unused(procs);
+    prb_unused(procCount);
+    prb_unused(mode);
+    result = prb_Failure;
+
+#elif prb_PLATFORM_LINUX
+
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        prb_Process* proc = procs + procIndex;
+        prb_assert(proc->status == prb_ProcessStatus_NotLaunched);
+        // NOTE(khvorov) The pipes take over stdout of every stage but the last and stdin of every stage but the first
+        prb_assert(procIndex == procCount - 1 || (!proc->spec.captureStdout && !proc->spec.redirectStdout && !proc->spec.hashStdout && !proc->spec.bufferOutput));
+        prb_assert(procIndex == 0 || !proc->spec.feedStdin);
+    }
+
+    // NOTE(khvorov) All stages run at the same time, the data never touches the disk
+    for (int32_t procIndex = 0; procIndex < procCount - 1 && result == prb_Success; procIndex++) {
+        int pipeEnds[2] = {-1, -1};
+        if (prb_linux_createCapturePipe(pipeEnds)) {
+            procs[procIndex].hasPipelineStdout = true;
+            procs[procIndex].pipelineStdout = pipeEnds[1];
+            procs[procIndex + 1].hasPipelineStdin = true;
+            procs[procIndex + 1].pipelineStdin = pipeEnds[0];
+        } else {
+            result = prb_Failure;
+        }
+    }
+
+    if (result == prb_Success) {
+        result = prb_launchProcesses(arena, procs, procCount, prb_Background_Yes);
+    }
+
+    // NOTE(khvorov) Stages only see the end of their input once we let go of our copies of the pipes
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        prb_Process* proc = procs + procIndex;
+        if (proc->hasPipelineStdin) {
+            close(proc->pipelineStdin);
+            proc->hasPipelineStdin = false;
+        }
+        if (proc->hasPipelineStdout) {
+            close(proc->pipelineStdout);
+            proc->hasPipelineStdout = false;
+        }
+    }
+
+    // NOTE(khvorov) Waiting for the stages one by one could leave a later stage blocked on its captured output
+    if (mode == prb_Background_No) {
+        prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(procs, procCount);
+        while (prb_processCompletionIterNext(&iter) == prb_Success) {
+            if (iter.curProc->status != prb_ProcessStatus_CompletedSuccess) {
+                result = prb_Failure;
+            }
+        }
+        prb_destroyProcessCompletionIter(&iter);
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return result;
+}
+
+typedef struct prb_ProcessLauncher {
+    prb_Process* procs;
+    prb_Status*  results;
+} prb_ProcessLauncher;
+
+static void
+prb_processLauncherProc(prb_Arena* scratch, void* data, int32_t from, int32_t to) {
+    prb_ProcessLauncher* launcher = (prb_ProcessLauncher*)data;
+    for (int32_t procIndex = from; procIndex < to; procIndex++) {
+        prb_TempMemory temp = prb_beginTempMemory(scratch);
+        launcher->results[procIndex] = prb_launchProcesses(scratch, launcher->procs + procIndex, 1, prb_Background_Yes);
+        prb_endTempMemory(temp);
+    }
+}
+
+prb_PUBLICDEF prb_Status
+prb_launchProcessesOnThreads(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_ThreadPool* pool, prb_Background mode) {
+    prb_Status result = prb_Success;
+
+#if prb_PLATFORM_WINDOWS
+
+    // NOTE(khvorov) Redirect handles are inheritable while a process is created, launching from several threads
+    // would leak them into the wrong children. So processes are launched one by one from the calling thread
+    // whatever the pool.
+    prb_unused(pool);
+    result = prb_launchProcesses(arena, procs, procCount, prb_Background_Yes);
+
+#elif prb_PLATFORM_LINUX
+
+    // NOTE(khvorov) Launches are spread over the pool's workers, each uses its own scratch arena.
+    // The calling thread takes a share too and uses the arena passed in. No pool means launching one by one.
+    // A process is only ever touched by one thread, which is done with it before parallelFor returns.
     prb_TempMemory      temp = prb_beginTempMemory(arena);
-    prb_CoreCountResult result = {.success = false, .cores = 0};
+    prb_ProcessLauncher launcher = {};
+    launcher.procs = procs;
+    launcher.results = prb_arenaAllocArray(arena, prb_Status, procCount);
+    prb_parallelFor(arena, pool, procCount, 1, prb_processLauncherProc, &launcher);
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        if (launcher.results[procIndex] == prb_Failure) {
+            result = prb_Failure;
+        }
+    }
+    prb_endTempMemory(temp);
+
+#else
+#error unimplemented
+#endif
+
+    // NOTE(khvorov) Waiting one by one could leave a later process blocked on its captured output
+    if (mode == prb_Background_No) {
+        prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(procs, procCount);
+        while (prb_processCompletionIterNext(&iter) == prb_Success) {
+            if (iter.curProc->status != prb_ProcessStatus_CompletedSuccess) {
+                result = prb_Failure;
+            }
+        }
+        prb_destroyProcessCompletionIter(&iter);
+    }
+
+    return result;
+}
+
+prb_PUBLICDEF prb_ProcessCompletionIter
+prb_createProcessCompletionIter(prb_Process* procs, int32_t procCount) {
+    prb_ProcessCompletionIter iter;
+    prb_memset(&iter, 0, sizeof(iter));
+    iter.procs = procs;
+    iter.procCount = procCount;
+    iter.curProc = 0;
+    iter.curProcIndex = -1;
+    iter.createTime = prb_timeStart();
+
+#if prb_PLATFORM_WINDOWS
+
+#elif prb_PLATFORM_LINUX
+
+    iter.epollHandle = epoll_create1(EPOLL_CLOEXEC);
+    prb_stbds_arrsetlen(iter.pidfds, procCount);
+    prb_stbds_arrsetlen(iter.pidfdPids, procCount);
+    prb_stbds_arrsetlen(iter.pipeHandles, procCount * 3);
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        iter.pidfds[procIndex] = -1;
+        iter.pidfdPids[procIndex] = 0;
+        for (int32_t pipeIndex = 0; pipeIndex < 3; pipeIndex++) {
+            iter.pipeHandles[procIndex * 3 + pipeIndex] = -1;
+        }
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return iter;
+}
+
+#if prb_PLATFORM_LINUX
+
+typedef enum prb_linux_CompletionEventKind {
+    prb_linux_CompletionEventKind_Exit,
+    prb_linux_CompletionEventKind_Stdout,
+    prb_linux_CompletionEventKind_Stderr,
+    prb_linux_CompletionEventKind_Stdin,
+} prb_linux_CompletionEventKind;
+
+static bool
+prb_linux_completionIterRegister(prb_ProcessCompletionIter* iter, int handle, int32_t procIndex, prb_linux_CompletionEventKind kind) {
+    uint32_t           events = kind == prb_linux_CompletionEventKind_Stdin ? EPOLLOUT : EPOLLIN;
+    struct epoll_event event = {.events = events, .data = {.u64 = ((uint64_t)procIndex << 2) | (uint64_t)kind}};
+    int                ctlResult = epoll_ctl(iter->epollHandle, EPOLL_CTL_ADD, handle, &event);
+    bool               result = ctlResult == 0 || errno == EEXIST;
+    return result;
+}
+
+static void
+prb_linux_completionIterForgetProcess(prb_ProcessCompletionIter* iter, int32_t procIndex) {
+    if (iter->pidfds[procIndex] != -1) {
+        close(iter->pidfds[procIndex]);
+        iter->pidfds[procIndex] = -1;
+    }
+    // NOTE(khvorov) Pipes belong to the processes, closing them or epoll unregisters them
+    for (int32_t pipeIndex = 0; pipeIndex < 3; pipeIndex++) {
+        iter->pipeHandles[procIndex * 3 + pipeIndex] = -1;
+    }
+}
+
+static void
+prb_linux_completionIterCloseHandles(prb_ProcessCompletionIter* iter) {
+    for (int32_t procIndex = 0; procIndex < iter->procCount; procIndex++) {
+        prb_linux_completionIterForgetProcess(iter, procIndex);
+    }
+    if (iter->epollHandle != -1) {
+        close(iter->epollHandle);
+        iter->epollHandle = -1;
+    }
+}
+
+static void
+prb_linux_completionIterRegisterPipe(prb_ProcessCompletionIter* iter, int pipe, int32_t procIndex, prb_linux_CompletionEventKind kind) {
+    int* registered = iter->pipeHandles + procIndex * 3 + (int32_t)kind - 1;
+    if (iter->epollHandle != -1 && pipe != -1 && *registered != pipe) {
+        if (prb_linux_completionIterRegister(iter, pipe, procIndex, kind)) {
+            *registered = pipe;
+        } else {
+            prb_linux_completionIterCloseHandles(iter);
+        }
+    }
+}
+
+// NOTE(khvorov) Registers processes launched since the last call and forgets the ones reaped elsewhere.
+// Returns how many are still running.
+static int32_t
+prb_linux_completionIterRegisterLaunched(prb_ProcessCompletionIter* iter) {
+    int32_t result = 0;
+    for (int32_t procIndex = 0; procIndex < iter->procCount; procIndex++) {
+        prb_Process* proc = iter->procs + procIndex;
+        bool         launched = proc->status == prb_ProcessStatus_Launched;
+
+        // NOTE(khvorov) The pidfd of a reaped process stays readable for good
+        if (iter->pidfds[procIndex] != -1 && (!launched || iter->pidfdPids[procIndex] != proc->pid)) {
+            prb_linux_completionIterForgetProcess(iter, procIndex);
+        }
+
+        if (launched) {
+            result += 1;
+            if (iter->epollHandle != -1 && iter->pidfds[procIndex] == -1) {
+                int pidfd = prb_linux_pidfdOpen(proc->pid);
+                if (pidfd != -1 && prb_linux_completionIterRegister(iter, pidfd, procIndex, prb_linux_CompletionEventKind_Exit)) {
+                    iter->pidfds[procIndex] = pidfd;
+                    iter->pidfdPids[procIndex] = proc->pid;
+                } else {
+                    if (pidfd != -1) {
+                        close(pidfd);
+                    }
+                    prb_linux_completionIterCloseHandles(iter);
+                }
+            }
+
+            // NOTE(khvorov) Output has to be read as it comes so that children don't block on full pipes
+            prb_linux_completionIterRegisterPipe(iter, proc->stdoutPipe, procIndex, prb_linux_CompletionEventKind_Stdout);
+            prb_linux_completionIterRegisterPipe(iter, proc->stderrPipe, procIndex, prb_linux_CompletionEventKind_Stderr);
+            prb_linux_completionIterRegisterPipe(iter, proc->stdinPipe, procIndex, prb_linux_CompletionEventKind_Stdin);
+        }
+    }
+    return result;
+}
+
+static void
+prb_linux_completionIterAddExited(prb_ProcessCompletionIter* iter, int32_t procIndex) {
+    prb_stbds_arrput(iter->exitedProcIndices, procIndex);
+    prb_stbds_arrput(iter->exitedWallMs, prb_getMsFrom(iter->procs[procIndex].launchTime));
+}
+
+#endif
+
+// NOTE(khvorov) Killed processes still have to exit and be reaped the usual way.
+// Returns how long until the next process runs out of time, -1 when none of them can.
+static float
+prb_completionIterKillExpired(prb_ProcessCompletionIter* iter) {
+    float result = -1;
+    for (int32_t procIndex = 0; procIndex < iter->procCount; procIndex++) {
+        prb_Process* proc = iter->procs + procIndex;
+        if (proc->status == prb_ProcessStatus_Launched && !proc->timedOut) {
+            bool  limited = false;
+            float remainingMs = 0;
+            if (iter->deadlineMs > 0) {
+                limited = true;
+                remainingMs = iter->deadlineMs - prb_getMsFrom(iter->createTime);
+            }
+            if (proc->spec.timeoutMs > 0) {
+                float procRemainingMs = proc->spec.timeoutMs - prb_getMsFrom(proc->launchTime);
+                remainingMs = limited ? prb_min(remainingMs, procRemainingMs) : procRemainingMs;
+                limited = true;
+            }
+
+            if (limited && remainingMs <= 0) {
+                proc->timedOut = true;
+#if prb_PLATFORM_WINDOWS
+                prb_windows_sendKill(proc);
+#elif prb_PLATFORM_LINUX
+                prb_linux_sendKill(proc);
+#else
+#error unimplemented
+#endif
+            } else if (limited && (result < 0 || remainingMs < result)) {
+                result = remainingMs;
+            }
+        }
+    }
+    return result;
+}
+
+#if prb_PLATFORM_LINUX
+
+// NOTE(khvorov) Returns how long until whichever comes first, a kill or a sample
+static float
+prb_linux_completionIterKillAndSample(prb_ProcessCompletionIter* iter) {
+    float result = prb_completionIterKillExpired(iter);
+    for (int32_t procIndex = 0; procIndex < iter->procCount; procIndex++) {
+        float untilSampleMs = prb_linux_sampleProcessIfDue(iter->procs + procIndex);
+        if (untilSampleMs >= 0 && (result < 0 || untilSampleMs < result)) {
+            result = untilSampleMs;
+        }
+    }
+    return result;
+}
+
+// NOTE(khvorov) Returns false when epoll stops working, it would fail the same way every time around
+static bool
+prb_linux_completionIterWaitEpoll(prb_ProcessCompletionIter* iter, int timeout) {
+    struct epoll_event events[64];
+    int                eventCount = epoll_wait(iter->epollHandle, events, prb_arrayCount(events), timeout);
+    for (int32_t eventIndex = 0; eventIndex < eventCount; eventIndex++) {
+        int32_t                       eventProcIndex = (int32_t)(events[eventIndex].data.u64 >> 2);
+        prb_linux_CompletionEventKind eventKind = (prb_linux_CompletionEventKind)(events[eventIndex].data.u64 & 3);
+        prb_Process*                  eventProc = iter->procs + eventProcIndex;
+        switch (eventKind) {
+            case prb_linux_CompletionEventKind_Exit: {
+                prb_linux_completionIterForgetProcess(iter, eventProcIndex);
+                if (eventProc->status == prb_ProcessStatus_Launched) {
+                    prb_linux_completionIterAddExited(iter, eventProcIndex);
+                }
+            } break;
+            case prb_linux_CompletionEventKind_Stdout: prb_linux_drainStdoutPipe(eventProc); break;
+            case prb_linux_CompletionEventKind_Stderr: prb_linux_drainCapturePipe(&eventProc->stderrPipe, &eventProc->stderrBuffer, 0); break;
+            case prb_linux_CompletionEventKind_Stdin: prb_linux_feedStdinPipe(eventProc); break;
+        }
+    }
+    bool result = eventCount != -1 || errno == EINTR;
+    return result;
+}
+
+// NOTE(khvorov) Checks on the children without blocking and then waits for SIGCHLD, a pipe or the timeout.
+// Can't block in waitid while children might be waiting for their output to be read.
+static void
+prb_linux_completionIterWaitFallback(prb_ProcessCompletionIter* iter, int32_t launchedCount, int signalHandle, int timeout) {
+    struct pollfd* pollfds = 0;
+    pid_t          lastPid = 0;
+    for (int32_t procIndex = 0; procIndex < iter->procCount; procIndex++) {
+        prb_Process* proc = iter->procs + procIndex;
+        if (proc->status == prb_ProcessStatus_Launched) {
+            // NOTE(khvorov) Fails when somebody else reaped the child, waiting for it would fail the same way
+            siginfo_t info = {};
+            if (waitid(P_PID, (id_t)proc->pid, &info, WEXITED | WNOHANG | WNOWAIT) == -1 || info.si_pid == proc->pid) {
+                prb_linux_completionIterAddExited(iter, procIndex);
+            }
+            lastPid = proc->pid;
+
+            if (proc->stdoutPipe != -1) {
+                struct pollfd pollfd = {.fd = proc->stdoutPipe, .events = POLLIN, .revents = 0};
+                prb_stbds_arrput(pollfds, pollfd);
+            }
+            if (proc->stderrPipe != -1) {
+                struct pollfd pollfd = {.fd = proc->stderrPipe, .events = POLLIN, .revents = 0};
+                prb_stbds_arrput(pollfds, pollfd);
+            }
+            if (proc->stdinPipe != -1) {
+                struct pollfd pollfd = {.fd = proc->stdinPipe, .events = POLLOUT, .revents = 0};
+                prb_stbds_arrput(pollfds, pollfd);
+            }
+        }
+    }
+
+    if (prb_stbds_arrlen(iter->exitedProcIndices) == 0) {
+        if (launchedCount == 1 && timeout < 0 && prb_stbds_arrlen(pollfds) == 0) {
+            // NOTE(khvorov) With just one of ours left and nothing else to look out for there is no need
+            // to hear about anybody else's children
+            siginfo_t info = {};
+            waitid(P_PID, (id_t)lastPid, &info, WEXITED | WNOWAIT);
+        } else {
+            int maxTimeout = signalHandle == -1 ? 10 : 100;
+            timeout = timeout < 0 ? maxTimeout : prb_min(timeout, maxTimeout);
+            if (signalHandle != -1) {
+                struct pollfd pollfd = {.fd = signalHandle, .events = POLLIN, .revents = 0};
+                prb_stbds_arrput(pollfds, pollfd);
+            }
+            poll(pollfds, (nfds_t)prb_stbds_arrlen(pollfds), timeout);
+
+            if (signalHandle != -1) {
+                struct signalfd_siginfo signalInfo = {};
+                while (read(signalHandle, &signalInfo, sizeof(signalInfo)) > 0) {}
+            }
+            for (int32_t procIndex = 0; procIndex < iter->procCount; procIndex++) {
+                prb_Process* proc = iter->procs + procIndex;
+                if (proc->status == prb_ProcessStatus_Launched) {
+                    prb_linux_serviceProcessPipes(proc);
+                }
+            }
+        }
+    }
+
+    prb_stbds_arrfree(pollfds);
+}
+
+// NOTE(khvorov) Returns once some of the processes exit, false if they can't be waited on.
+// Launched processes are only looked for once per wait, the rest of the wait goes through the events.
+static bool
+prb_linux_completionIterWaitForExit(prb_ProcessCompletionIter* iter, int32_t launchedCount) {
+    // NOTE(khvorov) SIGCHLD has to be blocked before the children are checked on, otherwise one could exit
+    // in between and the signal would be gone. It's taken off the pending set so a handler would not see it.
+    bool     fallback = iter->epollHandle == -1;
+    int      signalHandle = -1;
+    sigset_t childSignal;
+    sigset_t prevMask;
+    if (fallback) {
+        sigemptyset(&childSignal);
+        sigaddset(&childSignal, SIGCHLD);
+        pthread_sigmask(SIG_BLOCK, &childSignal, &prevMask);
+        signalHandle = signalfd(-1, &childSignal, SFD_CLOEXEC | SFD_NONBLOCK);
+    }
+
+    bool          result = true;
+    float         untilWakeMs = prb_linux_completionIterKillAndSample(iter);
+    prb_TimeStart wakeFrom = prb_timeStart();
+    while (result && prb_stbds_arrlen(iter->exitedProcIndices) == 0) {
+        int timeout = -1;
+        if (untilWakeMs >= 0) {
+            float remainingMs = untilWakeMs - prb_getMsFrom(wakeFrom);
+            timeout = remainingMs > 0 ? (int)remainingMs + 1 : 0;
+        }
+
+        if (fallback) {
+            prb_linux_completionIterWaitFallback(iter, launchedCount, signalHandle, timeout);
+        } else {
+            result = prb_linux_completionIterWaitEpoll(iter, timeout);
+        }
+
+        if (untilWakeMs >= 0 && prb_getMsFrom(wakeFrom) >= untilWakeMs) {
+            untilWakeMs = prb_linux_completionIterKillAndSample(iter);
+            wakeFrom = prb_timeStart();
+        }
+    }
+
+    if (fallback) {
+        if (signalHandle != -1) {
+            close(signalHandle);
+        }
+        pthread_sigmask(SIG_SETMASK, &prevMask, 0);
+    }
+    return result;
+}
+
+#endif
+
+prb_PUBLICDEF prb_Status
+prb_processCompletionIterNext(prb_ProcessCompletionIter* iter) {
+    prb_Status result = prb_Failure;
+    iter->curProc = 0;
+    iter->curProcIndex = -1;
+
+#if prb_PLATFORM_WINDOWS
+
+    for (bool done = false; !done;) {
+        float   untilKillMs = prb_completionIterKillExpired(iter);
+        int32_t launchedCount = 0;
+        for (int32_t chunkStart = 0; chunkStart < iter->procCount && !done;) {
+            HANDLE  handles[MAXIMUM_WAIT_OBJECTS];
+            int32_t handleProcIndices[MAXIMUM_WAIT_OBJECTS];
+            int32_t handleCount = 0;
+            for (; chunkStart < iter->procCount && handleCount < MAXIMUM_WAIT_OBJECTS; chunkStart++) {
+                prb_Process* proc = iter->procs + chunkStart;
+                if (proc->status == prb_ProcessStatus_Launched) {
+                    handles[handleCount] = proc->processInfo.hProcess;
+                    handleProcIndices[handleCount] = chunkStart;
+                    handleCount += 1;
+                }
+            }
+            launchedCount += handleCount;
+
+            if (handleCount > 0) {
+                // NOTE(khvorov) Can only wait on 64 handles at a time, so only block for good when they all fit
+                DWORD timeout = launchedCount == handleCount && chunkStart == iter->procCount ? INFINITE : 10;
+                if (untilKillMs >= 0) {
+                    timeout = prb_min(timeout, (DWORD)untilKillMs + 1);
+                }
+                DWORD waitResult = WaitForMultipleObjects((DWORD)handleCount, handles, FALSE, timeout);
+                if (waitResult < WAIT_OBJECT_0 + (DWORD)handleCount) {
+                    iter->curProcIndex = handleProcIndices[waitResult - WAIT_OBJECT_0];
+                    iter->curProc = iter->procs + iter->curProcIndex;
+                    prb_windows_waitForProcess(iter->curProc);
+                    result = prb_Success;
+                    done = true;
+                } else if (waitResult == WAIT_FAILED) {
+                    done = true;
+                }
+            }
+        }
+        if (launchedCount == 0) {
+            done = true;
+        }
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    for (bool done = false; !done;) {
+        if (prb_stbds_arrlen(iter->exitedProcIndices) > 0) {
+            // NOTE(khvorov) Processes that exited together are returned one at a time
+            int32_t procIndex = iter->exitedProcIndices[0];
+            float   wallMs = iter->exitedWallMs[0];
+            prb_stbds_arrdel(iter->exitedProcIndices, 0);
+            prb_stbds_arrdel(iter->exitedWallMs, 0);
+            prb_linux_completionIterForgetProcess(iter, procIndex);
+
+            // NOTE(khvorov) The process could have been waited on by someone else in the meantime
+            prb_Process* proc = iter->procs + procIndex;
+            if (proc->status == prb_ProcessStatus_Launched) {
+                prb_linux_waitForProcess(proc);
+                proc->usage.wallMs = wallMs;
+                iter->curProcIndex = procIndex;
+                iter->curProc = proc;
+                if (!iter->holdBufferedOutput) {
+                    prb_writeBufferedOutput(proc, 1);
+                }
+                result = prb_Success;
+                done = true;
+            }
+        } else {
+            int32_t launchedCount = prb_linux_completionIterRegisterLaunched(iter);
+            done = launchedCount == 0 || !prb_linux_completionIterWaitForExit(iter, launchedCount);
+        }
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return result;
+}
+
+prb_PUBLICDEF void
+prb_destroyProcessCompletionIter(prb_ProcessCompletionIter* iter) {
+#if prb_PLATFORM_WINDOWS
+
+#elif prb_PLATFORM_LINUX
+
+    prb_linux_completionIterCloseHandles(iter);
+    prb_stbds_arrfree(iter->pidfds);
+    prb_stbds_arrfree(iter->pidfdPids);
+    prb_stbds_arrfree(iter->pipeHandles);
+    prb_stbds_arrfree(iter->exitedProcIndices);
+    prb_stbds_arrfree(iter->exitedWallMs);
+
+#else
+#error unimplemented
+#endif
+
+    iter->procs = 0;
+    iter->procCount = 0;
+    iter->curProc = 0;
+    iter->curProcIndex = -1;
+}
+
+// NOTE(khvorov) Kept between calls with the same handles so that waiting for the rest of the processes
+// doesn't have to set everything up again each time. Destroyed once there is nothing left to wait for.
+static prb_THREAD_LOCAL prb_ProcessCompletionIter prb_waitForAnyProcessIter;
+static prb_THREAD_LOCAL bool                      prb_waitForAnyProcessIterCreated = false;
+
+prb_PUBLICDEF int32_t
+prb_waitForAnyProcess(prb_Process* handles, int32_t handleCount) {
+    prb_ProcessCompletionIter* iter = &prb_waitForAnyProcessIter;
+    if (prb_waitForAnyProcessIterCreated && (iter->procs != handles || iter->procCount != handleCount)) {
+        prb_destroyProcessCompletionIter(iter);
+        prb_waitForAnyProcessIterCreated = false;
+    }
+    if (!prb_waitForAnyProcessIterCreated) {
+        *iter = prb_createProcessCompletionIter(handles, handleCount);
+        prb_waitForAnyProcessIterCreated = true;
+    }
+
+    int32_t result = -1;
+    if (prb_processCompletionIterNext(iter) == prb_Success) {
+        result = iter->curProcIndex;
+    } else {
+        prb_destroyProcessCompletionIter(iter);
+        prb_waitForAnyProcessIterCreated = false;
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_writeBufferedOutput(prb_Process* procs, int32_t procCount) {
+    prb_Status result = prb_Success;
+
+#if prb_PLATFORM_WINDOWS
+
+    prb_unused(procs);
+    prb_unused(procCount);
+
+#elif prb_PLATFORM_LINUX
+
+    struct iovec* iovecs = 0;
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        prb_Process* proc = procs + procIndex;
+        bool         completed = proc->status == prb_ProcessStatus_CompletedSuccess || proc->status == prb_ProcessStatus_CompletedFailed;
+        if (proc->spec.bufferOutput && completed && prb_stbds_arrlen(proc->stdoutBuffer) > 0) {
+            struct iovec iovec = {.iov_base = proc->stdoutBuffer, .iov_len = (size_t)prb_stbds_arrlen(proc->stdoutBuffer)};
+            prb_stbds_arrput(iovecs, iovec);
+        }
+    }
+
+    // NOTE(khvorov) 1024 is the kernel's limit on the number of buffers in one writev
+    int32_t iovecCount = (int32_t)prb_stbds_arrlen(iovecs);
+    int32_t firstIovec = 0;
+    while (firstIovec < iovecCount) {
+        ssize_t written = writev(STDOUT_FILENO, iovecs + firstIovec, prb_min(iovecCount - firstIovec, 1024));
+        if (written == -1 && errno == EINTR) {
+            continue;
+        } else if (written == -1) {
+            result = prb_Failure;
+            break;
+        }
+        // NOTE(khvorov) Partial writes can stop in the middle of a buffer
+        while (firstIovec < iovecCount && (size_t)written >= iovecs[firstIovec].iov_len) {
+            written -= (ssize_t)iovecs[firstIovec].iov_len;
+            firstIovec += 1;
+        }
+        if (written > 0) {
+            iovecs[firstIovec].iov_base = (uint8_t*)iovecs[firstIovec].iov_base + written;
+            iovecs[firstIovec].iov_len -= (size_t)written;
+        }
+    }
+    prb_stbds_arrfree(iovecs);
+
+    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
+        prb_Process* proc = procs + procIndex;
+        if (proc->spec.bufferOutput && proc->status != prb_ProcessStatus_Launched) {
+            prb_stbds_arrfree(proc->stdoutBuffer);
+        }
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return result;
+}
+
+#if prb_PLATFORM_LINUX
+
+// NOTE(khvorov) Opening the /proc link creates a separate open file description,
+// so it can be non-blocking without affecting anyone else reading from the same pipe
+static int
+prb_linux_jobserverReopenReadEnd(prb_Arena* arena, int handle) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    const char*    path = prb_fmt(arena, "/proc/self/fd/%d", handle).ptr;
+    int            result = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    prb_endTempMemory(temp);
+    return result;
+}
+
+#endif
+
+// NOTE(khvorov) Messages are capped so that garbage from a broken worker doesn't get us to allocate everything
+#define prb_WORKER_MAX_MESSAGE_BYTES (1 << 30)
+
+static void
+prb_workerPutU32(uint8_t** buffer, uint32_t value) {
+    uint8_t* dest = prb_stbds_arraddnptr(*buffer, 4);
+    for (int32_t byteIndex = 0; byteIndex < 4; byteIndex++) {
+        dest[byteIndex] = (uint8_t)(value >> (byteIndex * 8));
+    }
+}
+
+static uint32_t
+prb_workerGetU32(const uint8_t* src) {
+    uint32_t result = (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+    return result;
+}
+
+static void
+prb_workerPutBytes(uint8_t** buffer, const void* data, int32_t len) {
+    prb_workerPutU32(buffer, (uint32_t)len);
+    if (len > 0) {
+        uint8_t* dest = prb_stbds_arraddnptr(*buffer, len);
+        prb_memcpy(dest, data, len);
+    }
+}
+
+static void
+prb_workerPutRequest(uint8_t** buffer, prb_WorkerRequest* request) {
+    int32_t lenOffset = (int32_t)prb_stbds_arrlen(*buffer);
+    prb_workerPutU32(buffer, 0);
+    prb_workerPutU32(buffer, (uint32_t)request->argCount);
+    for (int32_t argIndex = 0; argIndex < request->argCount; argIndex++) {
+        prb_workerPutBytes(buffer, request->args[argIndex].ptr, request->args[argIndex].len);
+    }
+    prb_workerPutBytes(buffer, request->input.data, request->input.len);
+
+    uint32_t messageLen = (uint32_t)((int32_t)prb_stbds_arrlen(*buffer) - lenOffset - 4);
+    for (int32_t byteIndex = 0; byteIndex < 4; byteIndex++) {
+        (*buffer)[lenOffset + byteIndex] = (uint8_t)(messageLen >> (byteIndex * 8));
+    }
+}
+
+#if prb_PLATFORM_LINUX
+
+static bool
+prb_linux_startWorker(prb_Arena* arena, prb_WorkerPool* pool, prb_Worker* worker) {
+    int  requestPipe[2] = {-1, -1};
+    int  responsePipe[2] = {-1, -1};
+    bool result = prb_linux_createCapturePipe(requestPipe) && prb_linux_createCapturePipe(responsePipe);
+
+    // NOTE(khvorov) The worker gets the pipes the same way pipeline stages get theirs
+    if (result) {
+        worker->process = prb_createProcessArgv(pool->argv, pool->spec.processSpec);
+        worker->process.hasPipelineStdin = true;
+        worker->process.pipelineStdin = requestPipe[0];
+        worker->process.hasPipelineStdout = true;
+        worker->process.pipelineStdout = responsePipe[1];
+        result = prb_launchProcesses(arena, &worker->process, 1, prb_Background_Yes);
+        worker->process.hasPipelineStdin = false;
+        worker->process.hasPipelineStdout = false;
+    }
+
+    if (result) {
+        worker->startCount += 1;
+        worker->requestPipe = requestPipe[1];
+        requestPipe[1] = -1;
+        fcntl(worker->requestPipe, F_SETFL, fcntl(worker->requestPipe, F_GETFL) | O_NONBLOCK);
+        worker->responsePipe = prb_linux_takeCapturePipeReadEnd(responsePipe);
+    }
+
+    for (int32_t pipeEndIndex = 0; pipeEndIndex < 2; pipeEndIndex++) {
+        if (requestPipe[pipeEndIndex] != -1) {
+            close(requestPipe[pipeEndIndex]);
+        }
+        if (responsePipe[pipeEndIndex] != -1) {
+            close(responsePipe[pipeEndIndex]);
+        }
+    }
+    return result;
+}
+
+// NOTE(khvorov) Requests that were in flight are left for the caller to deal with
+static void
+prb_linux_stopWorker(prb_Worker* worker, bool kill) {
+    if (worker->requestPipe != -1) {
+        close(worker->requestPipe);
+        worker->requestPipe = -1;
+    }
+    if (worker->responsePipe != -1) {
+        close(worker->responsePipe);
+        worker->responsePipe = -1;
+    }
+    if (worker->process.status == prb_ProcessStatus_Launched) {
+        if (kill) {
+            prb_killProcesses(&worker->process, 1);
+        } else {
+            prb_waitForProcesses(&worker->process, 1);
+        }
+    }
+    prb_stbds_arrfree(worker->sendBuffer);
+    prb_stbds_arrfree(worker->receiveBuffer);
+    worker->sentBytes = 0;
+}
+
+// NOTE(khvorov) Least loaded worker with ties going round robin, -1 when all of them are full.
+// Workers that are gone are started again while there are restarts left.
+static int32_t
+prb_linux_pickWorker(prb_Arena* arena, prb_WorkerPool* pool) {
+    int32_t maxInFlight = prb_max(pool->spec.maxInFlightPerWorker, 1);
+    int32_t result = -1;
+    int32_t resultLoad = 0;
+    for (int32_t offset = 0; offset < pool->workerCount; offset++) {
+        int32_t     workerIndex = (pool->nextWorkerIndex + offset) % pool->workerCount;
+        prb_Worker* worker = pool->workers + workerIndex;
+        if (worker->requestPipe == -1 && pool->restartCount < pool->spec.maxRestarts) {
+            pool->restartCount += 1;
+            prb_linux_startWorker(arena, pool, worker);
+        }
+        int32_t load = (int32_t)prb_stbds_arrlen(worker->inFlight);
+        if (worker->requestPipe != -1 && load < maxInFlight && (result == -1 || load < resultLoad)) {
+            result = workerIndex;
+            resultLoad = load;
+        }
+    }
+    if (result != -1) {
+        pool->nextWorkerIndex = (result + 1) % pool->workerCount;
+    }
+    return result;
+}
+
+// NOTE(khvorov) Returns false when the worker sent something that doesn't follow the protocol
+static bool
+prb_linux_receiveWorkerResponses(prb_Arena* arena, prb_Worker* worker, prb_WorkerJob* jobs, int32_t* completedCount) {
+    bool result = true;
+    while (result && prb_stbds_arrlen(worker->receiveBuffer) >= 4) {
+        uint32_t messageLen = prb_workerGetU32(worker->receiveBuffer);
+        result = messageLen >= 4 && messageLen <= prb_WORKER_MAX_MESSAGE_BYTES && prb_stbds_arrlen(worker->inFlight) > 0;
+        if (result && (uint32_t)prb_stbds_arrlen(worker->receiveBuffer) - 4 >= messageLen) {
+            prb_WorkerJob* job = jobs + worker->inFlight[0];
+            prb_stbds_arrdel(worker->inFlight, 0);
+
+            job->response.received = true;
+            job->response.exitCode = (int32_t)prb_workerGetU32(worker->receiveBuffer + 4);
+            job->response.output.len = (int32_t)messageLen - 4;
+            job->response.output.data = prb_arenaAllocArray(arena, uint8_t, job->response.output.len + 1);
+            prb_memcpy(job->response.output.data, worker->receiveBuffer + 8, job->response.output.len);
+            *completedCount += 1;
+
+            prb_stbds_arrdeln(worker->receiveBuffer, 0, 4 + (int32_t)messageLen);
+        } else {
+            break;
+        }
+    }
+    return result;
+}
+
+#endif
+
+prb_PUBLICDEF prb_WorkerPool
+prb_createWorkerPool(prb_Arena* arena, prb_Argv argv, prb_WorkerPoolSpec spec) {
+    prb_assert(!spec.processSpec.captureStdout && !spec.processSpec.bufferOutput && !spec.processSpec.hashStdout && !spec.processSpec.feedStdin);
+    prb_assert(!spec.processSpec.captureStderr);
+    prb_WorkerPool pool;
+    prb_memset(&pool, 0, sizeof(pool));
+    pool.argv = argv;
+    pool.spec = spec;
+
+    pool.workerCount = spec.workerCount;
+    if (pool.workerCount <= 0) {
+        prb_CoreCountResult cores = prb_getAllowExecutionCoreCount(arena);
+        pool.workerCount = cores.success ? prb_max(cores.cores, 1) : 1;
+    }
+    pool.workers = prb_arenaAllocArray(arena, prb_Worker, pool.workerCount);
+
+#if prb_PLATFORM_WINDOWS
+
+    // NOTE(khvorov) Not implemented on windows, the pool is never valid
+
+#elif prb_PLATFORM_LINUX
+
+    pool.valid = true;
+    for (int32_t workerIndex = 0; workerIndex < pool.workerCount; workerIndex++) {
+        prb_Worker* worker = pool.workers + workerIndex;
+        worker->requestPipe = -1;
+        worker->responsePipe = -1;
+        if (pool.valid) {
+            pool.valid = prb_linux_startWorker(arena, &pool, worker);
+        }
+    }
+    if (!pool.valid) {
+        prb_destroyWorkerPool(&pool);
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return pool;
+}
+
+prb_PUBLICDEF prb_Status
+prb_runWorkerJobs(prb_Arena* arena, prb_WorkerPool* pool, prb_WorkerJob* jobs, int32_t jobCount) {
+    prb_Status result = prb_Failure;
+    for (int32_t jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+        prb_WorkerJob* job = jobs + jobIndex;
+        prb_memset(&job->response, 0, sizeof(job->response));
+        job->workerIndex = -1;
+        job->attempts = 0;
+    }
+
+#if prb_PLATFORM_WINDOWS
+
+    prb_unused(arena);
+    prb_unused(pool);
+
+#elif prb_PLATFORM_LINUX
+
+    if (pool->valid) {
+        // NOTE(khvorov) Requests that have to be sent again go before the ones that were never sent
+        int32_t        nextJobIndex = 0;
+        int32_t*       retries = 0;
+        int32_t        completedCount = 0;
+        struct pollfd* pollfds = 0;
+        prb_stbds_arrsetlen(pollfds, pool->workerCount * 2);
+        while (completedCount < jobCount) {
+            for (;;) {
+                bool haveWork = prb_stbds_arrlen(retries) > 0 || nextJobIndex < jobCount;
+                int32_t workerIndex = haveWork ? prb_linux_pickWorker(arena, pool) : -1;
+                if (workerIndex == -1) {
+                    break;
+                }
+                int32_t jobIndex = 0;
+                if (prb_stbds_arrlen(retries) > 0) {
+                    jobIndex = retries[prb_stbds_arrlen(retries) - 1];
+                    prb_stbds_arrsetlen(retries, prb_stbds_arrlen(retries) - 1);
+                } else {
+                    jobIndex = nextJobIndex;
+                    nextJobIndex += 1;
+                }
+                prb_WorkerJob* job = jobs + jobIndex;
+                prb_Worker*    worker = pool->workers + workerIndex;
+                job->workerIndex = workerIndex;
+                job->attempts += 1;
+                prb_workerPutRequest(&worker->sendBuffer, &job->request);
+                prb_stbds_arrput(worker->inFlight, jobIndex);
+            }
+
+            int32_t runningCount = 0;
+            for (int32_t workerIndex = 0; workerIndex < pool->workerCount; workerIndex++) {
+                prb_Worker* worker = pool->workers + workerIndex;
+                bool        running = worker->requestPipe != -1;
+                bool        sending = running && worker->sentBytes < (int32_t)prb_stbds_arrlen(worker->sendBuffer);
+                runningCount += running;
+                pollfds[workerIndex * 2] = (struct pollfd) {.fd = running ? worker->responsePipe : -1, .events = POLLIN, .revents = 0};
+                pollfds[workerIndex * 2 + 1] = (struct pollfd) {.fd = sending ? worker->requestPipe : -1, .events = POLLOUT, .revents = 0};
+            }
+
+            // NOTE(khvorov) All the workers are gone for good, nobody is left to send the rest to
+            if (runningCount == 0) {
+                break;
+            }
+
+            poll(pollfds, (nfds_t)(pool->workerCount * 2), -1);
+            for (int32_t workerIndex = 0; workerIndex < pool->workerCount; workerIndex++) {
+                prb_Worker* worker = pool->workers + workerIndex;
+                bool        crashed = false;
+                if (pollfds[workerIndex * 2 + 1].revents != 0) {
+                    int32_t written = prb_linux_writeToPipe(worker->requestPipe, worker->sendBuffer + worker->sentBytes, (int32_t)prb_stbds_arrlen(worker->sendBuffer) - worker->sentBytes);
+                    if (written >= 0) {
+                        worker->sentBytes += written;
+                        if (worker->sentBytes == (int32_t)prb_stbds_arrlen(worker->sendBuffer)) {
+                            prb_stbds_arrfree(worker->sendBuffer);
+                            worker->sentBytes = 0;
+                        }
+                    } else {
+                        crashed = true;
+                    }
+                }
+
+                // NOTE(khvorov) Responses sent right before the worker went away still count
+                if (pollfds[workerIndex * 2].revents != 0) {
+                    int readHandle = worker->responsePipe;
+                    prb_linux_drainCapturePipe(&readHandle, &worker->receiveBuffer, 0);
+                    crashed = crashed || readHandle == -1;
+                    if (readHandle == -1) {
+                        worker->responsePipe = -1;
+                    }
+                    crashed = !prb_linux_receiveWorkerResponses(arena, worker, jobs, &completedCount) || crashed;
+                }
+
+                // NOTE(khvorov) Workers respond in order so the first request in flight is the one that took the worker down.
+                // The rest never got worked on and don't count as attempts
+                if (crashed) {
+                    for (int32_t inFlightIndex = (int32_t)prb_stbds_arrlen(worker->inFlight) - 1; inFlightIndex >= 0; inFlightIndex--) {
+                        prb_WorkerJob* job = jobs + worker->inFlight[inFlightIndex];
+                        if (inFlightIndex > 0) {
+                            job->attempts -= 1;
+                        }
+                        if (job->attempts > pool->spec.maxRetries) {
+                            completedCount += 1;
+                        } else {
+                            prb_stbds_arrput(retries, worker->inFlight[inFlightIndex]);
+                        }
+                    }
+                    prb_stbds_arrfree(worker->inFlight);
+                    prb_linux_stopWorker(worker, true);
+                }
+            }
+        }
+        prb_stbds_arrfree(pollfds);
+        prb_stbds_arrfree(retries);
+
+        result = prb_Success;
+        for (int32_t jobIndex = 0; jobIndex < jobCount && result == prb_Success; jobIndex++) {
+            prb_WorkerResponse response = jobs[jobIndex].response;
+            result = response.received && response.exitCode == 0 ? prb_Success : prb_Failure;
+        }
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return result;
+}
+
+prb_PUBLICDEF void
+prb_destroyWorkerPool(prb_WorkerPool* pool) {
+#if prb_PLATFORM_WINDOWS
+
+#elif prb_PLATFORM_LINUX
+
+    // NOTE(khvorov) Workers are expected to exit once their stdin is closed
+    for (int32_t workerIndex = 0; workerIndex < pool->workerCount; workerIndex++) {
+        prb_Worker* worker = pool->workers + workerIndex;
+        if (worker->requestPipe != -1) {
+            close(worker->requestPipe);
+            worker->requestPipe = -1;
+        }
+    }
+    for (int32_t workerIndex = 0; workerIndex < pool->workerCount; workerIndex++) {
+        prb_Worker* worker = pool->workers + workerIndex;
+        prb_linux_stopWorker(worker, false);
+        prb_stbds_arrfree(worker->inFlight);
+    }
+
+#else
+#error unimplemented
+#endif
+
+    pool->valid = false;
+}
+
+// NOTE(khvorov) Returns false once stdin ends before len bytes are read
+static bool
+prb_readStdinExact(void* dest, int32_t len) {
+    int32_t readSoFar = 0;
+    while (readSoFar < len) {
+#if prb_PLATFORM_WINDOWS
+        DWORD bytesRead = 0;
+        if (!ReadFile(GetStdHandle(STD_INPUT_HANDLE), (uint8_t*)dest + readSoFar, (DWORD)(len - readSoFar), &bytesRead, 0) || bytesRead == 0) {
+            break;
+        }
+        readSoFar += (int32_t)bytesRead;
+#elif prb_PLATFORM_LINUX
+        ssize_t readResult = read(STDIN_FILENO, (uint8_t*)dest + readSoFar, len - readSoFar);
+        if (readResult == -1 && errno == EINTR) {
+            continue;
+        } else if (readResult <= 0) {
+            break;
+        }
+        readSoFar += (int32_t)readResult;
+#else
+#error unimplemented
+#endif
+    }
+    bool result = readSoFar == len;
+    return result;
+}
+
+static bool
+prb_writeStdoutExact(const void* src, int32_t len) {
+    int32_t written = 0;
+    while (written < len) {
+#if prb_PLATFORM_WINDOWS
+        DWORD bytesWritten = 0;
+        if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), (const uint8_t*)src + written, (DWORD)(len - written), &bytesWritten, 0)) {
+            break;
+        }
+        written += (int32_t)bytesWritten;
+#elif prb_PLATFORM_LINUX
+        ssize_t writeResult = write(STDOUT_FILENO, (const uint8_t*)src + written, len - written);
+        if (writeResult == -1 && errno == EINTR) {
+            continue;
+        } else if (writeResult <= 0) {
+            break;
+        }
+        written += (int32_t)writeResult;
+#else
+#error unimplemented
+#endif
+    }
+    bool result = written == len;
+    return result;
+}
+
+prb_PUBLICDEF prb_WorkerRequest
+prb_readWorkerRequest(prb_Arena* arena) {
+    prb_WorkerRequest result = {};
+    uint8_t           lenBytes[4];
+    if (prb_readStdinExact(lenBytes, 4)) {
+        uint32_t messageLen = prb_workerGetU32(lenBytes);
+        // NOTE(khvorov) Workers are not expected to keep going after a bad request, so nothing is freed when it is bad
+        if (messageLen >= 8 && messageLen <= prb_WORKER_MAX_MESSAGE_BYTES) {
+            uint8_t* message = prb_arenaAllocArray(arena, uint8_t, messageLen);
+            if (prb_readStdinExact(message, (int32_t)messageLen)) {
+                // NOTE(khvorov) Every length is checked against what's left before it's used
+                uint32_t offset = 0;
+                uint32_t argCount = prb_workerGetU32(message);
+                offset += 4;
+                result.valid = argCount <= (messageLen - offset) / 4;
+                if (result.valid) {
+                    result.argCount = (int32_t)argCount;
+                    result.args = prb_arenaAllocArray(arena, prb_Str, result.argCount);
+                }
+                for (int32_t argIndex = 0; argIndex <= result.argCount && result.valid; argIndex++) {
+                    result.valid = messageLen - offset >= 4;
+                    if (result.valid) {
+                        uint32_t len = prb_workerGetU32(message + offset);
+                        offset += 4;
+                        result.valid = len <= messageLen - offset;
+                        if (result.valid && argIndex < result.argCount) {
+                            result.args[argIndex] = prb_fmt(arena, "%.*s", (int)len, (const char*)message + offset);
+                        } else if (result.valid) {
+                            result.input.data = message + offset;
+                            result.input.len = (int32_t)len;
+                        }
+                        offset += len;
+                    }
+                }
+            }
+            if (!result.valid) {
+                prb_memset(&result, 0, sizeof(result));
+            }
+        }
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_writeWorkerResponse(int32_t exitCode, prb_Bytes output) {
+    uint8_t header[8];
+    uint32_t messageLen = (uint32_t)output.len + 4;
+    for (int32_t byteIndex = 0; byteIndex < 4; byteIndex++) {
+        header[byteIndex] = (uint8_t)(messageLen >> (byteIndex * 8));
+        header[4 + byteIndex] = (uint8_t)((uint32_t)exitCode >> (byteIndex * 8));
+    }
+    prb_Status result = prb_writeStdoutExact(header, 8) && prb_writeStdoutExact(output.data, output.len) ? prb_Success : prb_Failure;
+    return result;
+}
+
+prb_PUBLICDEF prb_Jobserver
+prb_createJobserver(prb_Arena* arena, int32_t tokenCount, prb_JobserverKind kind) {
+    prb_assert(tokenCount >= 1);
+    prb_Jobserver jobserver;
+    prb_memset(&jobserver, 0, sizeof(jobserver));
+    jobserver.isServer = true;
+
+#if prb_PLATFORM_WINDOWS
+
+    InitializeSRWLock(&jobserver.lock);
+
+    // NOTE(khvorov) Jobservers could be created on several threads at once
+    static LONG jobserverCounter = 0;
+    LONG        jobserverId = InterlockedIncrement(&jobserverCounter);
+
+    prb_unused(kind);
+    prb_Str             name = prb_fmt(arena, "prb_jobserver_%lu_%ld", GetCurrentProcessId(), jobserverId);
+    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
+    jobserver.semaphore = CreateSemaphoreW(0, tokenCount - 1, prb_max(tokenCount - 1, 1), wname.ptr);
+    if (jobserver.semaphore) {
+        jobserver.makeflags = prb_fmt(arena, "-j%d --jobserver-auth=%.*s", tokenCount, prb_LIT(name));
+        jobserver.valid = true;
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    pthread_mutex_init(&jobserver.lock, 0);
+    jobserver.readHandle = -1;
+    jobserver.writeHandle = -1;
+    jobserver.pipeHandles[0] = -1;
+    jobserver.pipeHandles[1] = -1;
+
+    switch (kind) {
+        case prb_JobserverKind_Fifo: {
+            // NOTE(khvorov) The fifo goes in a directory only we can get into so that nobody can swap it out from under us
+            prb_GetenvResult tmpdir = prb_getenv(arena, prb_STR("TMPDIR"));
+            prb_Str          tmpdirPath = tmpdir.found && tmpdir.str.len > 0 ? tmpdir.str : prb_STR("/tmp");
+            prb_Str          dir = prb_fmt(arena, "%.*s/prb_jobserver_XXXXXX", prb_LIT(tmpdirPath));
+            if (mkdtemp((char*)dir.ptr)) {
+                prb_Str     path = prb_fmt(arena, "%.*s/fifo", prb_LIT(dir));
+                const char* pathNull = path.ptr;
+                if (mkfifo(pathNull, S_IRUSR | S_IWUSR) == 0) {
+                    jobserver.fifoPath = path;
+                    // NOTE(khvorov) Opening for both reading and writing so that neither end ever sees the other side closed
+                    jobserver.readHandle = open(pathNull, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+                    jobserver.writeHandle = jobserver.readHandle;
+                    if (jobserver.readHandle != -1) {
+                        jobserver.makeflags = prb_fmt(arena, "-j%d --jobserver-auth=fifo:%.*s", tokenCount, prb_LIT(path));
+                        jobserver.valid = true;
+                    }
+                } else {
+                    rmdir(dir.ptr);
+                }
+            }
+        } break;
+
+        case prb_JobserverKind_Pipe: {
+            // NOTE(khvorov) Not close-on-exec, children find these through MAKEFLAGS
+            if (pipe(jobserver.pipeHandles) == 0) {
+                jobserver.readHandle = prb_linux_jobserverReopenReadEnd(arena, jobserver.pipeHandles[0]);
+                jobserver.writeHandle = jobserver.pipeHandles[1];
+                if (jobserver.readHandle != -1) {
+                    jobserver.makeflags = prb_fmt(arena, "-j%d --jobserver-auth=%d,%d", tokenCount, jobserver.pipeHandles[0], jobserver.pipeHandles[1]);
+                    jobserver.valid = true;
+                }
+            } else {
+                jobserver.pipeHandles[0] = -1;
+                jobserver.pipeHandles[1] = -1;
+            }
+        } break;
+    }
+
+    if (jobserver.valid) {
+        for (int32_t tokenIndex = 0; tokenIndex < tokenCount - 1 && jobserver.valid; tokenIndex++) {
+            uint8_t token = '+';
+            jobserver.valid = write(jobserver.writeHandle, &token, 1) == 1;
+        }
+    }
+
+#else
+#error unimplemented
+#endif
+
+    if (jobserver.valid) {
+        prb_GetenvResult prevMakeflags = prb_getenv(arena, prb_STR("MAKEFLAGS"));
+        jobserver.prevMakeflagsFound = prevMakeflags.found;
+        prb_Str exportedMakeflags = jobserver.makeflags;
+        if (prevMakeflags.found) {
+            // NOTE(khvorov) Make uses the last jobserver-auth so the existing flags can stay
+            jobserver.prevMakeflags = prb_fmt(arena, "%.*s", prb_LIT(prevMakeflags.str));
+            exportedMakeflags = prb_fmt(arena, "%.*s %.*s", prb_LIT(jobserver.prevMakeflags), prb_LIT(jobserver.makeflags));
+        }
+        jobserver.valid = prb_setenv(arena, prb_STR("MAKEFLAGS"), exportedMakeflags) == prb_Success;
+    }
+
+    if (!jobserver.valid) {
+        prb_destroyJobserver(arena, &jobserver);
+    }
+
+    return jobserver;
+}
+
+prb_PUBLICDEF prb_Jobserver
+prb_connectJobserver(prb_Arena* arena) {
+    prb_Jobserver jobserver;
+    prb_memset(&jobserver, 0, sizeof(jobserver));
 #if prb_PLATFORM_WINDOWS
-    SYSTEM_INFO sysinfo;
-    prb_memset(&sysinfo, 0, sizeof(sysinfo));
-    GetSystemInfo(&sysinfo);
-    result.success = true;
-    result.cores = (int32_t)sysinfo.dwNumberOfProcessors;
+    InitializeSRWLock(&jobserver.lock);
 #elif prb_PLATFORM_LINUX
-    prb_Str cpuinfo = prb_strFromBytes(prb_linux_readFromProc(arena, prb_STR("cpuinfo")));
-    prb_StrScanner scanner = prb_createStrScanner(cpuinfo);
-    prb_StrFindSpec spec = {};
-    spec.pattern = prb_STR("processor");
-    spec.direction = prb_StrDirection_FromEnd;
-    if (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
-        spec.pattern = prb_STR(":");
-        spec.direction = prb_StrDirection_FromStart;
-        if (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
-            spec.mode = prb_StrFindMode_LineBreak;
-            if (prb_strScannerMove(&scanner, spec, prb_StrScannerSide_AfterMatch)) {
-                prb_Str coresStr = prb_strTrim(scanner.betweenLastMatches);
-                prb_ParseUintResult parse = prb_parseUint(coresStr, 10);
-                if (parse.success) {
-                    result.success = true;
-                    // NOTE(khvorov) This number is the last CPU index + 1
-                    // Sibling count is not accurate on boards with multiple sockets
-                    result.cores = parse.number + 1;
+    pthread_mutex_init(&jobserver.lock, 0);
+    jobserver.readHandle = -1;
+    jobserver.writeHandle = -1;
+    jobserver.pipeHandles[0] = -1;
+    jobserver.pipeHandles[1] = -1;
+#endif
+
+    prb_GetenvResult makeflags = prb_getenv(arena, prb_STR("MAKEFLAGS"));
+    if (makeflags.found) {
+        // NOTE(khvorov) Only the last one counts, older makes call it jobserver-fds
+        prb_Str auth = {};
+        prb_Str authOptions[] = {prb_STR("--jobserver-auth="), prb_STR("--jobserver-fds=")};
+        for (int32_t optionIndex = 0; optionIndex < prb_arrayCount(authOptions) && auth.ptr == 0; optionIndex++) {
+            prb_StrFindSpec   optionSpec = {.mode = prb_StrFindMode_Exact, .direction = prb_StrDirection_FromEnd, .pattern = authOptions[optionIndex], .alwaysMatchEnd = false};
+            prb_StrFindResult optionFind = prb_strFind(makeflags.str, optionSpec);
+            if (optionFind.found) {
+                prb_StrFindSpec   endSpec = {.mode = prb_StrFindMode_AnyChar, .direction = prb_StrDirection_FromStart, .pattern = prb_STR(" \t"), .alwaysMatchEnd = true};
+                prb_StrFindResult endFind = prb_strFind(optionFind.afterMatch, endSpec);
+                auth = endFind.beforeMatch;
+            }
+        }
+
+        if (auth.ptr && auth.len > 0) {
+            jobserver.makeflags = prb_fmt(arena, "%.*s", prb_LIT(makeflags.str));
+
+#if prb_PLATFORM_WINDOWS
+
+            prb_windows_WideStr wname = prb_windows_getWideStr(arena, auth);
+            jobserver.semaphore = OpenSemaphoreW(SEMAPHORE_ALL_ACCESS, FALSE, wname.ptr);
+            jobserver.valid = jobserver.semaphore != 0;
+
+#elif prb_PLATFORM_LINUX
+
+            if (prb_strStartsWith(auth, prb_STR("fifo:"))) {
+                const char* path = prb_strGetNullTerminated(arena, prb_strSlice(auth, 5, auth.len));
+                jobserver.readHandle = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+                jobserver.writeHandle = jobserver.readHandle;
+                jobserver.valid = jobserver.readHandle != -1;
+            } else {
+                prb_StrFindSpec     commaSpec = {.mode = prb_StrFindMode_Exact, .direction = prb_StrDirection_FromStart, .pattern = prb_STR(","), .alwaysMatchEnd = false};
+                prb_StrFindResult   commaFind = prb_strFind(auth, commaSpec);
+                prb_ParseUintResult readEnd = prb_parseUint(commaFind.beforeMatch, 10);
+                prb_ParseUintResult writeEnd = prb_parseUint(commaFind.afterMatch, 10);
+                // NOTE(khvorov) The handles are only inherited when make thinks we are a recursive make
+                if (commaFind.found && readEnd.success && writeEnd.success && fcntl((int)readEnd.number, F_GETFD) != -1 && fcntl((int)writeEnd.number, F_GETFD) != -1) {
+                    jobserver.readHandle = prb_linux_jobserverReopenReadEnd(arena, (int)readEnd.number);
+                    jobserver.writeHandle = (int)writeEnd.number;
+                    jobserver.valid = jobserver.readHandle != -1;
                 }
             }
+
+#else
+#error unimplemented
+#endif
+        }
+    }
+
+    return jobserver;
+}
+
+static void
+prb_jobserverLock(prb_Jobserver* jobserver) {
+#if prb_PLATFORM_WINDOWS
+    AcquireSRWLockExclusive(&jobserver->lock);
+#elif prb_PLATFORM_LINUX
+    pthread_mutex_lock(&jobserver->lock);
+#else
+#error unimplemented
+#endif
+}
+
+static void
+prb_jobserverUnlock(prb_Jobserver* jobserver) {
+#if prb_PLATFORM_WINDOWS
+    ReleaseSRWLockExclusive(&jobserver->lock);
+#elif prb_PLATFORM_LINUX
+    pthread_mutex_unlock(&jobserver->lock);
+#else
+#error unimplemented
+#endif
+}
+
+static bool
+prb_jobserverTakeImplicitToken(prb_Jobserver* jobserver) {
+    prb_jobserverLock(jobserver);
+    bool result = !jobserver->implicitTokenTaken;
+    jobserver->implicitTokenTaken = true;
+    prb_jobserverUnlock(jobserver);
+    return result;
+}
+
+// NOTE(khvorov) Takes a token from the fifo/pipe/semaphore, waits for at most timeoutMs.
+// Sets broken when there's no point waiting again
+static prb_Status
+prb_jobserverTakeToken(prb_Jobserver* jobserver, int32_t timeoutMs, bool* broken) {
+    prb_Status result = prb_Failure;
+
+#if prb_PLATFORM_WINDOWS
+
+    DWORD waitResult = WaitForSingleObject(jobserver->semaphore, (DWORD)timeoutMs);
+    if (waitResult == WAIT_OBJECT_0) {
+        prb_jobserverLock(jobserver);
+        jobserver->heldTokenCount += 1;
+        prb_jobserverUnlock(jobserver);
+        result = prb_Success;
+    } else if (waitResult != WAIT_TIMEOUT) {
+        *broken = true;
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    for (bool waited = false;;) {
+        uint8_t token = 0;
+        ssize_t readResult = read(jobserver->readHandle, &token, 1);
+        if (readResult == 1) {
+            prb_jobserverLock(jobserver);
+            prb_stbds_arrput(jobserver->heldTokens, token);
+            jobserver->heldTokenCount += 1;
+            prb_jobserverUnlock(jobserver);
+            result = prb_Success;
+            break;
+        } else if (readResult == -1 && errno == EINTR) {
+            continue;
+        } else if (readResult == -1 && errno == EAGAIN && timeoutMs > 0 && !waited) {
+            // NOTE(khvorov) Somebody else can get to the token first, then it's a timeout like any other
+            struct pollfd pollfd = {.fd = jobserver->readHandle, .events = POLLIN, .revents = 0};
+            if (poll(&pollfd, 1, timeoutMs) == -1 && errno != EINTR) {
+                *broken = true;
+                break;
+            }
+            waited = true;
+        } else {
+            *broken = !(readResult == -1 && errno == EAGAIN);
+            break;
+        }
+    }
+
+#else
+#error unimplemented
+#endif
+
+    return result;
+}
+
+// NOTE(khvorov) Another thread can give back the implicit token while we wait on the others,
+// so the wait is done in steps that look at the implicit token in between
+prb_PUBLICDEF prb_Status
+prb_jobserverAcquire(prb_Jobserver* jobserver) {
+    prb_assert(jobserver->valid);
+    prb_Status result = prb_Failure;
+    for (bool broken = false; result == prb_Failure && !broken;) {
+        if (prb_jobserverTakeImplicitToken(jobserver)) {
+            result = prb_Success;
+        } else {
+            result = prb_jobserverTakeToken(jobserver, 100, &broken);
+        }
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_jobserverTryAcquire(prb_Jobserver* jobserver) {
+    prb_assert(jobserver->valid);
+    prb_Status result = prb_Failure;
+    if (prb_jobserverTakeImplicitToken(jobserver)) {
+        result = prb_Success;
+    } else {
+        bool broken = false;
+        result = prb_jobserverTakeToken(jobserver, 0, &broken);
+    }
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_jobserverRelease(prb_Jobserver* jobserver) {
+    prb_assert(jobserver->valid);
+    prb_Status result = prb_Failure;
+    prb_jobserverLock(jobserver);
+    if (jobserver->heldTokenCount > 0) {
+        jobserver->heldTokenCount -= 1;
+#if prb_PLATFORM_LINUX
+        // NOTE(khvorov) Have to give back the same byte we got
+        uint8_t token = prb_stbds_arrpop(jobserver->heldTokens);
+#endif
+        prb_jobserverUnlock(jobserver);
+
+#if prb_PLATFORM_WINDOWS
+        result = ReleaseSemaphore(jobserver->semaphore, 1, 0) ? prb_Success : prb_Failure;
+#elif prb_PLATFORM_LINUX
+        for (;;) {
+            ssize_t writeResult = write(jobserver->writeHandle, &token, 1);
+            if (writeResult == 1) {
+                result = prb_Success;
+                break;
+            } else if (writeResult == -1 && errno == EINTR) {
+                continue;
+            } else {
+                break;
+            }
+        }
+#else
+#error unimplemented
+#endif
+
+        if (result == prb_Failure) {
+            prb_jobserverLock(jobserver);
+            jobserver->heldTokenCount += 1;
+#if prb_PLATFORM_LINUX
+            prb_stbds_arrput(jobserver->heldTokens, token);
+#endif
+            prb_jobserverUnlock(jobserver);
+        }
+    } else {
+        if (jobserver->implicitTokenTaken) {
+            jobserver->implicitTokenTaken = false;
+            result = prb_Success;
+        }
+        prb_jobserverUnlock(jobserver);
+    }
+    return result;
+}
+
+prb_PUBLICDEF void
+prb_destroyJobserver(prb_Arena* arena, prb_Jobserver* jobserver) {
+    if (jobserver->valid) {
+        while (jobserver->heldTokenCount > 0 && prb_jobserverRelease(jobserver) == prb_Success) {}
+        if (jobserver->isServer) {
+            if (jobserver->prevMakeflagsFound) {
+                prb_setenv(arena, prb_STR("MAKEFLAGS"), jobserver->prevMakeflags);
+            } else {
+                prb_unsetenv(arena, prb_STR("MAKEFLAGS"));
+            }
+        }
+    }
+
+#if prb_PLATFORM_WINDOWS
+
+    if (jobserver->semaphore) {
+        CloseHandle(jobserver->semaphore);
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    // NOTE(khvorov) The client write handle belongs to the parent
+    if (jobserver->readHandle != -1) {
+        close(jobserver->readHandle);
+    }
+    for (int32_t pipeEndIndex = 0; pipeEndIndex < 2; pipeEndIndex++) {
+        if (jobserver->pipeHandles[pipeEndIndex] != -1) {
+            close(jobserver->pipeHandles[pipeEndIndex]);
+        }
+    }
+    if (jobserver->fifoPath.ptr) {
+        unlink(prb_strGetNullTerminated(arena, jobserver->fifoPath));
+        rmdir(prb_strGetNullTerminated(arena, prb_getParentDir(arena, jobserver->fifoPath)));
+    }
+    prb_stbds_arrfree(jobserver->heldTokens);
+    pthread_mutex_destroy(&jobserver->lock);
+
+#else
+#error unimplemented
+#endif
+
+    prb_memset(jobserver, 0, sizeof(*jobserver));
+#if prb_PLATFORM_LINUX
+    jobserver->readHandle = -1;
+    jobserver->writeHandle = -1;
+    jobserver->pipeHandles[0] = -1;
+    jobserver->pipeHandles[1] = -1;
+#endif
+}
+
+prb_PUBLICDEF void
+prb_sleep(float ms) {
+#if prb_PLATFORM_WINDOWS
+
+    prb_TimeStart timeStart = prb_timeStart();
+    DWORD         msec = (DWORD)(ms);
+    Sleep(msec);
+    float msSpentSleeping = prb_getMsFrom(timeStart);
+
+    float left = ms - msSpentSleeping;
+    float msSpentSpinning = 0.0f;
+    timeStart = prb_timeStart();
+    while (msSpentSpinning < left) {
+        msSpentSpinning = prb_getMsFrom(timeStart);
+    }
+
+#elif prb_PLATFORM_LINUX
+
+    float secf = ms * 0.001f;
+    long int sec = (long int)(secf);
+    long int nsec = (long int)((secf - (float)sec) * 1000.0f * 1000.0f * 1000.0f);
+    struct timespec ts = {.tv_sec = sec, .tv_nsec = nsec};
+    nanosleep(&ts, 0);
+
+#else
+#error unimplemented
+#endif
+}
+
+prb_PUBLICDEF bool
+prb_debuggerPresent(prb_Arena* arena) {
+    bool           result = false;
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+#if prb_PLATFORM_WINDOWS
+
+    result = IsDebuggerPresent();
+
+#elif prb_PLATFORM_LINUX
+
+    prb_Bytes content = prb_linux_readFromProc(arena, prb_STR("self/status"));
+    prb_Str str = {(const char*)content.data, content.len};
+    prb_StrScanner iter = prb_createStrScanner(str);
+    prb_StrFindSpec lineBreakSpec = {};
+    lineBreakSpec.mode = prb_StrFindMode_LineBreak;
+    while (prb_strScannerMove(&iter, lineBreakSpec, prb_StrScannerSide_AfterMatch)) {
+        prb_Str search = prb_STR("TracerPid:");
+        if (prb_strStartsWith(iter.betweenLastMatches, search)) {
+            prb_Str number = prb_strTrim(prb_strSlice(iter.betweenLastMatches, search.len, iter.betweenLastMatches.len));
+            result = number.len > 1 || number.ptr[0] != '0';
+            break;
         }
     }
+
+#else
+#error unimplemented
+#endif
+
+    prb_endTempMemory(temp);
+    return result;
+}
+
+prb_PUBLICDEF prb_Status
+prb_setenv(prb_Arena* arena, prb_Str name, prb_Str value) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Status     result = prb_Failure;
+
+#if prb_PLATFORM_WINDOWS
+
+    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
+    prb_windows_WideStr wvalue = prb_windows_getWideStr(arena, value);
+    if (SetEnvironmentVariableW(wname.ptr, wvalue.ptr)) {
+        result = prb_Success;
+    }
+
+#elif prb_PLATFORM_LINUX
+    const char* nameNull = prb_strGetNullTerminated(arena, name);
+    const char* valueNull = prb_strGetNullTerminated(arena, value);
+    result = setenv(nameNull, valueNull, 1) == 0 ? prb_Success : prb_Failure;
 #else
 #error unimplemented
 #endif
+
     prb_endTempMemory(temp);
     return result;
 }
 
-prb_PUBLICDEF prb_CoreCountResult
-prb_getAllowExecutionCoreCount(prb_Arena* arena) {
-    prb_CoreCountResult result = {.success = false, .cores = 0};
-    prb_TempMemory      temp = prb_beginTempMemory(arena);
+prb_PUBLICDEF prb_GetenvResult
+prb_getenv(prb_Arena* arena, prb_Str name) {
+    prb_GetenvResult result;
+    prb_memset(&result, 0, sizeof(result));
 
 #if prb_PLATFORM_WINDOWS
-    prb_windows_GetAffinityResult affinityRes = prb_windows_getAffinity();
-    if (affinityRes.success) {
-        result.success = true;
-        result.cores = affinityRes.setBits;
+
+    prb_arenaAlignFreePtr(arena, prb_alignof(uint16_t));
+    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
+    LPWSTR              wptr = (LPWSTR)prb_arenaFreePtr(arena);
+    DWORD               getEnvResult = GetEnvironmentVariableW(wname.ptr, wptr, (DWORD)prb_min(prb_arenaFreeSize(arena), UINT32_MAX));
+    if (getEnvResult > 0) {
+        prb_arenaChangeUsed(arena, (int32_t)getEnvResult * (int32_t)sizeof(*wptr));
+        prb_arenaAllocAndZero(arena, 2, 1);  // NOTE(khvorov) Null terminator
+        result.str = prb_windows_strFromWideStr(arena, (prb_windows_WideStr) {wptr, (int32_t)getEnvResult});
+        result.found = true;
     }
+
 #elif prb_PLATFORM_LINUX
-    prb_linux_GetAffinityResult affinityRes = prb_linux_getAffinity(arena);
-    if (affinityRes.success) {
-        result.success = true;
-        result.cores = affinityRes.setBits;
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    const char* nameNull = prb_strGetNullTerminated(arena, name);
+    char* str = getenv(nameNull);
+    if (str) {
+        result.found = true;
+        result.str = prb_STR(str);
     }
+    prb_endTempMemory(temp);
+
 #else
 #error unimplemented
 #endif
 
-    prb_endTempMemory(temp);
     return result;
 }
 
 prb_PUBLICDEF prb_Status
-prb_allowExecutionOnCores(prb_Arena* arena, int32_t coreCount) {
-    prb_Status     result = prb_Failure;
+prb_unsetenv(prb_Arena* arena, prb_Str name) {
     prb_TempMemory temp = prb_beginTempMemory(arena);
-    if (coreCount >= 1) {
+    prb_Status     result = prb_Failure;
+
 #if prb_PLATFORM_WINDOWS
-        prb_windows_GetAffinityResult affinityRes = prb_windows_getAffinity();
-        if (affinityRes.success) {
-            DWORD_PTR newAffinityMask = affinityRes.affinity;
-            int32_t   coreDelta = coreCount - affinityRes.setBits;
-            for (int32_t bitIndex = 0; bitIndex < (int32_t)sizeof(DWORD_PTR) * 8 && coreDelta != 0; bitIndex++) {
-                DWORD_PTR mask = ((DWORD_PTR)1) << bitIndex;
-                bool      coreIsScheduled = (newAffinityMask & mask) == mask;
-                if (coreIsScheduled) {
-                    if (coreDelta > 0) {
-                        newAffinityMask = newAffinityMask | mask;
-                        coreDelta -= 1;
-                    } else {
-                        newAffinityMask = newAffinityMask & (~mask);
-                        coreDelta += 1;
-                    }
-                }
-            }
 
-            if (coreCount != affinityRes.setBits) {
-                if (SetProcessAffinityMask(GetCurrentProcess(), newAffinityMask)) {
-                    result = prb_Success;
-                }
-            } else {
-                result = prb_Success;
-            }
-        }
+    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
+    if (SetEnvironmentVariableW(wname.ptr, NULL)) {
+        result = prb_Success;
+    }
 
 #elif prb_PLATFORM_LINUX
 
-        prb_linux_GetAffinityResult affinityRes = prb_linux_getAffinity(arena);
-        if (affinityRes.success) {
-            if (coreCount > affinityRes.setBits) {
-                int32_t coresToSchedule = coreCount - affinityRes.setBits;
-                for (int32_t byteIndex = 0; byteIndex < affinityRes.size && coresToSchedule > 0; byteIndex++) {
-                    uint8_t byte = affinityRes.affinity[byteIndex];
-                    for (int32_t bitIndex = 0; bitIndex < 8 && coresToSchedule > 0; bitIndex++) {
-                        uint8_t mask = 1 << bitIndex;
-                        bool coreIsScheduled = (byte & mask) != 0;
-                        if (!coreIsScheduled) {
-                            byte = byte | mask;
-                            affinityRes.affinity[byteIndex] = byte;
-                            coresToSchedule -= 1;
-                        }
-                    }
-                }
-            } else if (coreCount < affinityRes.setBits) {
-                int32_t coresToUnschedule = affinityRes.setBits - coreCount;
-                for (int32_t byteIndex = 0; byteIndex < affinityRes.size && coresToUnschedule > 0; byteIndex++) {
-                    uint8_t byte = affinityRes.affinity[byteIndex];
-                    for (int32_t bitIndex = 0; bitIndex < 8 && coresToUnschedule > 0; bitIndex++) {
-                        uint8_t mask = 1 << bitIndex;
-                        bool coreIsScheduled = (byte & mask) != 0;
-                        if (coreIsScheduled) {
-                            byte = byte & (~mask);
-                            affinityRes.affinity[byteIndex] = byte;
-                            coresToUnschedule -= 1;
-                        }
-                    }
-                }
-            }
+    const char* nameNull = prb_strGetNullTerminated(arena, name);
+    result = unsetenv(nameNull) == 0 ? prb_Success : prb_Failure;
+
+#else
+#error unimplemented
+#endif
+
+    prb_endTempMemory(temp);
+    return result;
+}
+
+prb_PUBLICDEF prb_Env
+prb_createEnv(prb_Arena* arena, prb_Str addEnv) {
+    prb_Env result = prb_createEnvImpl(arena, addEnv, true);
+    return result;
+}
+
+//
+// SECTION Timing (implementation)
+//
+
+prb_PUBLICDEF prb_TimeStart
+prb_timeStart(void) {
+    prb_TimeStart result;
+    prb_memset(&result, 0, sizeof(result));
+#if prb_PLATFORM_WINDOWS
+    LARGE_INTEGER ticks;
+    prb_memset(&ticks, 0, sizeof(ticks));
+    if (QueryPerformanceCounter(&ticks)) {
+        result.valid = true;
+        result.ticks = ticks.QuadPart;
+    }
+#elif prb_PLATFORM_LINUX
+    struct timespec tp = {};
+    if (clock_gettime(CLOCK_MONOTONIC, &tp) == 0) {
+        prb_assert(tp.tv_nsec >= 0 && tp.tv_sec >= 0);
+        result.nsec = (uint64_t)tp.tv_nsec + (uint64_t)tp.tv_sec * 1000 * 1000 * 1000;
+        result.valid = true;
+    }
+#else
+#error unimplemented
+#endif
+    return result;
+}
+
+prb_PUBLICDEF float
+prb_getMsFrom(prb_TimeStart timeStart) {
+    prb_TimeStart now = prb_timeStart();
+    float         result = 0.0f;
+    if (now.valid && timeStart.valid) {
+#if prb_PLATFORM_WINDOWS
+        LARGE_INTEGER ticksPerSecond;
+        prb_memset(&ticksPerSecond, 0, sizeof(ticksPerSecond));
+        if (QueryPerformanceFrequency(&ticksPerSecond)) {
+            LONGLONG ticksDiff = now.ticks - timeStart.ticks;
+            float    secs = (float)ticksDiff / (float)ticksPerSecond.QuadPart;
+            result = secs * 1000.0f;
+        }
+#elif prb_PLATFORM_LINUX
+        uint64_t nsec = now.nsec - timeStart.nsec;
+        result = (float)nsec / 1000.0f / 1000.0f;
+#else
+#error unimplemented
+#endif
+    }
+    return result;
+}
+
+//
+// SECTION Multithreading (implementation)
+//
+
+// NOTE(khvorov) Interlocked functions are full barriers, so with msvc anything stronger than relaxed goes through them
+#if defined(_MSC_VER) && !defined(__clang__)
+#define prb_ATOMICS_INTERLOCKED 1
+#else
+#define prb_ATOMICS_INTERLOCKED 0
+
+// NOTE(khvorov) Failure order of a compare exchange can't be release or stronger than success
+static int
+prb_casFailureOrder(prb_MemoryOrder order) {
+    prb_MemoryOrder result = order;
+    if (order == prb_MemoryOrder_Release) {
+        result = prb_MemoryOrder_Relaxed;
+    } else if (order == prb_MemoryOrder_AcqRel) {
+        result = prb_MemoryOrder_Acquire;
+    }
+    return (int)result;
+}
+#endif
+
+prb_PUBLICDEF int32_t
+prb_atomicLoadI32(int32_t* ptr, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    int32_t result = order == prb_MemoryOrder_Relaxed ? *(volatile int32_t*)ptr : (int32_t)InterlockedCompareExchange((volatile LONG*)ptr, 0, 0);
+#else
+    int32_t result = __atomic_load_n(ptr, (int)order);
+#endif
+    return result;
+}
+
+prb_PUBLICDEF void
+prb_atomicStoreI32(int32_t* ptr, int32_t value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    if (order == prb_MemoryOrder_Relaxed) {
+        *(volatile int32_t*)ptr = value;
+    } else {
+        InterlockedExchange((volatile LONG*)ptr, (LONG)value);
+    }
+#else
+    __atomic_store_n(ptr, value, (int)order);
+#endif
+}
+
+prb_PUBLICDEF int32_t
+prb_atomicExchangeI32(int32_t* ptr, int32_t value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    int32_t result = (int32_t)InterlockedExchange((volatile LONG*)ptr, (LONG)value);
+#else
+    int32_t result = __atomic_exchange_n(ptr, value, (int)order);
+#endif
+    return result;
+}
+
+prb_PUBLICDEF bool
+prb_atomicCasI32(int32_t* ptr, int32_t* expected, int32_t desired, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    int32_t prev = (int32_t)InterlockedCompareExchange((volatile LONG*)ptr, (LONG)desired, (LONG)*expected);
+    bool    result = prev == *expected;
+    *expected = prev;
+#else
+    bool result = __atomic_compare_exchange_n(ptr, expected, desired, false, (int)order, prb_casFailureOrder(order));
+#endif
+    return result;
+}
+
+prb_PUBLICDEF int32_t
+prb_atomicFetchAddI32(int32_t* ptr, int32_t value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    int32_t result = (int32_t)InterlockedExchangeAdd((volatile LONG*)ptr, (LONG)value);
+#else
+    int32_t result = __atomic_fetch_add(ptr, value, (int)order);
+#endif
+    return result;
+}
+
+prb_PUBLICDEF int64_t
+prb_atomicLoadI64(int64_t* ptr, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    int64_t result = order == prb_MemoryOrder_Relaxed ? *(volatile int64_t*)ptr : (int64_t)InterlockedCompareExchange64((volatile LONG64*)ptr, 0, 0);
+#else
+    int64_t result = __atomic_load_n(ptr, (int)order);
+#endif
+    return result;
+}
+
+prb_PUBLICDEF void
+prb_atomicStoreI64(int64_t* ptr, int64_t value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    if (order == prb_MemoryOrder_Relaxed) {
+        *(volatile int64_t*)ptr = value;
+    } else {
+        InterlockedExchange64((volatile LONG64*)ptr, (LONG64)value);
+    }
+#else
+    __atomic_store_n(ptr, value, (int)order);
+#endif
+}
+
+prb_PUBLICDEF int64_t
+prb_atomicExchangeI64(int64_t* ptr, int64_t value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    int64_t result = (int64_t)InterlockedExchange64((volatile LONG64*)ptr, (LONG64)value);
+#else
+    int64_t result = __atomic_exchange_n(ptr, value, (int)order);
+#endif
+    return result;
+}
+
+prb_PUBLICDEF bool
+prb_atomicCasI64(int64_t* ptr, int64_t* expected, int64_t desired, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    int64_t prev = (int64_t)InterlockedCompareExchange64((volatile LONG64*)ptr, (LONG64)desired, (LONG64)*expected);
+    bool    result = prev == *expected;
+    *expected = prev;
+#else
+    bool result = __atomic_compare_exchange_n(ptr, expected, desired, false, (int)order, prb_casFailureOrder(order));
+#endif
+    return result;
+}
+
+prb_PUBLICDEF int64_t
+prb_atomicFetchAddI64(int64_t* ptr, int64_t value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    int64_t result = (int64_t)InterlockedExchangeAdd64((volatile LONG64*)ptr, (LONG64)value);
+#else
+    int64_t result = __atomic_fetch_add(ptr, value, (int)order);
+#endif
+    return result;
+}
+
+prb_PUBLICDEF void*
+prb_atomicLoadPtr(void** ptr, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    void* result = order == prb_MemoryOrder_Relaxed ? *(void* volatile*)ptr : InterlockedCompareExchangePointer((PVOID volatile*)ptr, 0, 0);
+#else
+    void* result = __atomic_load_n(ptr, (int)order);
+#endif
+    return result;
+}
+
+prb_PUBLICDEF void
+prb_atomicStorePtr(void** ptr, void* value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    if (order == prb_MemoryOrder_Relaxed) {
+        *(void* volatile*)ptr = value;
+    } else {
+        InterlockedExchangePointer((PVOID volatile*)ptr, value);
+    }
+#else
+    __atomic_store_n(ptr, value, (int)order);
+#endif
+}
+
+prb_PUBLICDEF void*
+prb_atomicExchangePtr(void** ptr, void* value, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    void* result = InterlockedExchangePointer((PVOID volatile*)ptr, value);
+#else
+    void* result = __atomic_exchange_n(ptr, value, (int)order);
+#endif
+    return result;
+}
 
-            if (coreCount != affinityRes.setBits) {
-                int setAffinityResult = syscall(SYS_sched_setaffinity, 0, affinityRes.size, affinityRes.affinity);
-                if (setAffinityResult == 0) {
-                    result = prb_Success;
-                }
-            } else {
-                result = prb_Success;
-            }
-        }
+prb_PUBLICDEF bool
+prb_atomicCasPtr(void** ptr, void** expected, void* desired, prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    void* prev = InterlockedCompareExchangePointer((PVOID volatile*)ptr, desired, *expected);
+    bool  result = prev == *expected;
+    *expected = prev;
 #else
-#error unimplemented
+    bool result = __atomic_compare_exchange_n(ptr, expected, desired, false, (int)order, prb_casFailureOrder(order));
 #endif
-    }
-    prb_endTempMemory(temp);
     return result;
 }
 
-prb_PUBLICDEF prb_Process
-prb_createProcess(prb_Str cmd, prb_ProcessSpec spec) {
-    prb_Process proc;
-    prb_memset(&proc, 0, sizeof(proc));
-    proc.cmd = cmd;
-    proc.spec = spec;
-    return proc;
+prb_PUBLICDEF void
+prb_atomicFence(prb_MemoryOrder order) {
+#if prb_ATOMICS_INTERLOCKED
+    prb_unused(order);
+    MemoryBarrier();
+#else
+    __atomic_thread_fence((int)order);
+#endif
 }
 
-prb_PUBLICDEF prb_Status
-prb_launchProcesses(prb_Arena* arena, prb_Process* procs, int32_t procCount, prb_Background mode) {
-    prb_Status     result = prb_Success;
-    prb_TempMemory temp = prb_beginTempMemory(arena);
+#if prb_PLATFORM_WINDOWS
 
-    for (int32_t procIndex = 0; procIndex < procCount; procIndex++) {
-        prb_Process* proc = procs + procIndex;
-        if (proc->status == prb_ProcessStatus_NotLaunched) {
-            prb_ProcessSpec spec = proc->spec;
+static DWORD WINAPI
+prb_windows_threadProc(void* data) {
+    prb_Job* job = (prb_Job*)data;
+    job->proc(&job->arena, job->data);
+    return 0;
+}
+
+#elif prb_PLATFORM_LINUX
+
+static void*
+prb_linux_threadProc(void* data) {
+    prb_Job* job = (prb_Job*)data;
+    job->proc(&job->arena, job->data);
+    return 0;
+}
+
+#endif
+
+// NOTE(khvorov) Set on pool worker threads so that jobs launched from inside jobs go to the worker's own deque
+static prb_THREAD_LOCAL prb_ThreadPoolWorker* prb_currentThreadPoolWorker = 0;
 
+static void
+prb_threadPoolLock(prb_ThreadPool* pool) {
 #if prb_PLATFORM_WINDOWS
+    AcquireSRWLockExclusive(&pool->lock);
+#elif prb_PLATFORM_LINUX
+    pthread_mutex_lock(&pool->lock);
+#else
+#error unimplemented
+#endif
+}
 
-            STARTUPINFOW startupInfo;
-            prb_memset(&startupInfo, 0, sizeof(startupInfo));
-            startupInfo.cb = sizeof(STARTUPINFOW);
+static void
+prb_threadPoolUnlock(prb_ThreadPool* pool) {
+#if prb_PLATFORM_WINDOWS
+    ReleaseSRWLockExclusive(&pool->lock);
+#elif prb_PLATFORM_LINUX
+    pthread_mutex_unlock(&pool->lock);
+#else
+#error unimplemented
+#endif
+}
 
-            bool    redirectSuccessful = true;
-            BOOL    inheritHandles = spec.redirectStdout || spec.redirectStderr;
-            HANDLE  handlesToClose[2] = {0, 0};
-            int32_t handlesToCloseCount = 0;
+#if prb_PLATFORM_WINDOWS
 
-            if (inheritHandles) {
-                startupInfo.dwFlags = STARTF_USESTDHANDLES;
+static void
+prb_windows_threadPoolWait(prb_ThreadPool* pool, CONDITION_VARIABLE* cond) {
+    SleepConditionVariableSRW(cond, &pool->lock, INFINITE, 0);
+}
 
-                SECURITY_ATTRIBUTES securityAttr = {
-                    .nLength = sizeof(securityAttr),
-                    .lpSecurityDescriptor = NULL,
-                    .bInheritHandle = TRUE,
-                };
+static void
+prb_windows_threadPoolWake(CONDITION_VARIABLE* cond, bool all) {
+    if (all) {
+        WakeAllConditionVariable(cond);
+    } else {
+        WakeConditionVariable(cond);
+    }
+}
 
-                prb_Str stdoutPath = spec.stdoutFilepath;
-                if (stdoutPath.ptr == 0 || stdoutPath.len == 0) {
-                    stdoutPath = prb_STR("NUL");
-                }
+#define prb_threadPoolWaitForWork(pool) prb_windows_threadPoolWait(pool, &(pool)->workCond)
+#define prb_threadPoolWaitForDone(pool) prb_windows_threadPoolWait(pool, &(pool)->doneCond)
+#define prb_threadPoolWakeWorkers(pool, all) prb_windows_threadPoolWake(&(pool)->workCond, all)
+#define prb_threadPoolWakeWaiters(pool) prb_windows_threadPoolWake(&(pool)->doneCond, true)
 
-                prb_Str stderrPath = spec.stderrFilepath;
-                if (stderrPath.ptr == 0 || stderrPath.len == 0) {
-                    stderrPath = prb_STR("NUL");
-                }
+#elif prb_PLATFORM_LINUX
 
-                if (spec.redirectStdout && spec.redirectStderr && prb_streq(stdoutPath, stderrPath)) {
-                    prb_windows_OpenResult openRes = prb_windows_open(arena, stdoutPath, GENERIC_WRITE, FILE_SHARE_WRITE, CREATE_ALWAYS, &securityAttr);
-                    if (openRes.success) {
-                        startupInfo.hStdOutput = openRes.handle;
-                        startupInfo.hStdError = openRes.handle;
-                        handlesToClose[handlesToCloseCount++] = openRes.handle;
-                    } else {
-                        redirectSuccessful = false;
-                    }
-                } else {
-                    if (spec.redirectStdout) {
-                        prb_windows_OpenResult openRes = prb_windows_open(arena, stdoutPath, GENERIC_WRITE, 0, CREATE_ALWAYS, &securityAttr);
-                        if (openRes.success) {
-                            startupInfo.hStdOutput = openRes.handle;
-                            handlesToClose[handlesToCloseCount++] = openRes.handle;
-                        } else {
-                            redirectSuccessful = false;
-                        }
-                    }
+static void
+prb_linux_threadPoolWake(pthread_cond_t* cond, bool all) {
+    if (all) {
+        pthread_cond_broadcast(cond);
+    } else {
+        pthread_cond_signal(cond);
+    }
+}
 
-                    if (spec.redirectStderr) {
-                        prb_windows_OpenResult openRes = prb_windows_open(arena, stderrPath, GENERIC_WRITE, 0, CREATE_ALWAYS, &securityAttr);
-                        if (openRes.success) {
-                            startupInfo.hStdError = openRes.handle;
-                            handlesToClose[handlesToCloseCount++] = openRes.handle;
-                        } else {
-                            redirectSuccessful = false;
-                        }
-                    }
-                }
-            }
+#define prb_threadPoolWaitForWork(pool) pthread_cond_wait(&(pool)->workCond, &(pool)->lock)
+#define prb_threadPoolWaitForDone(pool) pthread_cond_wait(&(pool)->doneCond, &(pool)->lock)
+#define prb_threadPoolWakeWorkers(pool, all) prb_linux_threadPoolWake(&(pool)->workCond, all)
+#define prb_threadPoolWakeWaiters(pool) prb_linux_threadPoolWake(&(pool)->doneCond, true)
 
-            if (redirectSuccessful) {
-                // NOTE(khvorov) Just replace spaces with null terminators and stick that to the start of the
-                // existing environment and call it a day.
-                LPWCH env = 0;
-                if (spec.addEnv.ptr && spec.addEnv.len > 0) {
-                    prb_windows_WideStr envCopy = prb_windows_getWideStr(arena, spec.addEnv);
-                    for (int32_t envIndex = 0; envIndex < envCopy.len; envIndex++) {
-                        if (envCopy.ptr[envIndex] == ' ') {
-                            envCopy.ptr[envIndex] = '\0';
-                        }
-                    }
-                    LPWCH   existingEnv = GetEnvironmentStringsW();
-                    int32_t existingEnvLen = 0;
-                    for (;;) {
-                        if (existingEnv[existingEnvLen] == '\0' && existingEnv[existingEnvLen + 1] == '\0') {
-                            break;
-                        } else {
-                            existingEnvLen += 1;
-                        }
-                    }
-                    env = (LPWCH)prb_arenaAllocArray(arena, uint16_t, envCopy.len + 1 + existingEnvLen + 2);
-                    prb_memcpy(env, envCopy.ptr, envCopy.len * sizeof(*envCopy.ptr));
-                    prb_memcpy(env + envCopy.len + 1, existingEnv, existingEnvLen * sizeof(*existingEnv));
-                    FreeEnvironmentStringsW(existingEnv);
-                }
+#else
+#error unimplemented
+#endif
 
-                prb_windows_WideStr wcmd = prb_windows_getWideStr(arena, proc->cmd);
-                if (CreateProcessW(0, wcmd.ptr, 0, 0, inheritHandles, CREATE_UNICODE_ENVIRONMENT, env, 0, &startupInfo, &proc->processInfo)) {
-                    proc->status = prb_ProcessStatus_Launched;
-                    if (mode == prb_Background_No) {
-                        prb_windows_waitForProcess(proc);
-                    }
-                }
-            }
+static bool
+prb_threadPoolDequePush(prb_ThreadPoolDeque* deque, prb_Job* job) {
+    bool    result = false;
+    int64_t bottom = prb_atomicLoadI64(&deque->bottom, prb_MemoryOrder_Relaxed);
+    int64_t top = prb_atomicLoadI64(&deque->top, prb_MemoryOrder_Acquire);
+    if (bottom - top < deque->capacity) {
+        prb_atomicStorePtr((void**)(deque->buffer + (bottom & (deque->capacity - 1))), job, prb_MemoryOrder_Relaxed);
+        prb_atomicFence(prb_MemoryOrder_Release);
+        prb_atomicStoreI64(&deque->bottom, bottom + 1, prb_MemoryOrder_Relaxed);
+        result = true;
+    }
+    return result;
+}
 
-            for (int32_t handleIndex = 0; handleIndex < handlesToCloseCount; handleIndex++) {
-                CloseHandle(handlesToClose[handleIndex]);
+static prb_Job*
+prb_threadPoolDequeTake(prb_ThreadPoolDeque* deque) {
+    prb_Job* result = 0;
+    int64_t  bottom = prb_atomicLoadI64(&deque->bottom, prb_MemoryOrder_Relaxed) - 1;
+    prb_atomicStoreI64(&deque->bottom, bottom, prb_MemoryOrder_Relaxed);
+    prb_atomicFence(prb_MemoryOrder_SeqCst);
+    int64_t top = prb_atomicLoadI64(&deque->top, prb_MemoryOrder_Relaxed);
+    if (top <= bottom) {
+        result = (prb_Job*)prb_atomicLoadPtr((void**)(deque->buffer + (bottom & (deque->capacity - 1))), prb_MemoryOrder_Relaxed);
+        if (top == bottom) {
+            // NOTE(khvorov) Last one, thieves might be after it too
+            if (!prb_atomicCasI64(&deque->top, &top, top + 1, prb_MemoryOrder_SeqCst)) {
+                result = 0;
             }
+            prb_atomicStoreI64(&deque->bottom, bottom + 1, prb_MemoryOrder_Relaxed);
+        }
+    } else {
+        prb_atomicStoreI64(&deque->bottom, bottom + 1, prb_MemoryOrder_Relaxed);
+    }
+    return result;
+}
 
-#elif prb_PLATFORM_LINUX
+static prb_Job*
+prb_threadPoolDequeSteal(prb_ThreadPoolDeque* deque, bool* lostRace) {
+    prb_Job* result = 0;
+    int64_t  top = prb_atomicLoadI64(&deque->top, prb_MemoryOrder_Acquire);
+    prb_atomicFence(prb_MemoryOrder_SeqCst);
+    int64_t bottom = prb_atomicLoadI64(&deque->bottom, prb_MemoryOrder_Acquire);
+    if (top < bottom) {
+        prb_Job* job = (prb_Job*)prb_atomicLoadPtr((void**)(deque->buffer + (top & (deque->capacity - 1))), prb_MemoryOrder_Relaxed);
+        if (prb_atomicCasI64(&deque->top, &top, top + 1, prb_MemoryOrder_SeqCst)) {
+            result = job;
+        } else {
+            *lostRace = true;
+        }
+    }
+    return result;
+}
 
-            const char* stdoutPath = 0;
-            if (spec.redirectStdout) {
-                if (spec.stdoutFilepath.ptr && spec.stdoutFilepath.len > 0) {
-                    stdoutPath = prb_strGetNullTerminated(arena, spec.stdoutFilepath);
-                } else {
-                    stdoutPath = "/dev/null";
+static prb_Job*
+prb_threadPoolInjectPop(prb_ThreadPool* pool) {
+    prb_Job* result = pool->injectHead;
+    if (result) {
+        pool->injectHead = result->poolNext;
+        if (pool->injectHead == 0) {
+            pool->injectTail = 0;
+        }
+        prb_atomicStoreI32(&pool->injectCount, pool->injectCount - 1, prb_MemoryOrder_Relaxed);
+    }
+    return result;
+}
+
+// NOTE(khvorov) Own deque first, then the inject list, then everyone else's deques.
+// Worker is null when the caller is not on one of this pool's threads
+static prb_Job*
+prb_threadPoolFindJob(prb_ThreadPool* pool, prb_ThreadPoolWorker* worker) {
+    prb_Job* result = 0;
+    if (worker) {
+        result = prb_threadPoolDequeTake(&worker->deque);
+    }
+
+    if (result == 0 && prb_atomicLoadI32(&pool->injectCount, prb_MemoryOrder_Relaxed) > 0) {
+        prb_threadPoolLock(pool);
+        result = prb_threadPoolInjectPop(pool);
+        if (result && worker) {
+            // NOTE(khvorov) Move our share of the rest to the deque so that the others can steal it
+            // instead of lining up for the lock
+            int32_t share = pool->injectCount / pool->workerCount;
+            for (int32_t shareIndex = 0; shareIndex < share; shareIndex++) {
+                if (!prb_threadPoolDequePush(&worker->deque, pool->injectHead)) {
+                    break;
                 }
+                prb_threadPoolInjectPop(pool);
             }
+        }
+        prb_threadPoolUnlock(pool);
+    }
 
-            const char* stderrPath = 0;
-            if (spec.redirectStderr) {
-                if (spec.stderrFilepath.ptr && spec.stderrFilepath.len > 0) {
-                    stderrPath = prb_strGetNullTerminated(arena, spec.stderrFilepath);
-                } else {
-                    stderrPath = "/dev/null";
+    if (result == 0) {
+        int32_t firstVictimIndex = worker ? worker->index + 1 : 0;
+        bool    lostRace = true;
+        while (result == 0 && lostRace) {
+            lostRace = false;
+            for (int32_t victimOffset = 0; victimOffset < pool->workerCount && result == 0; victimOffset++) {
+                prb_ThreadPoolWorker* victim = pool->workers + (firstVictimIndex + victimOffset) % pool->workerCount;
+                if (victim != worker) {
+                    result = prb_threadPoolDequeSteal(&victim->deque, &lostRace);
                 }
             }
+        }
+    }
 
-            bool fileActionsSucceeded = true;
-            bool fileActionsInited = false;
-            posix_spawn_file_actions_t* fileActionsPtr = 0;
-            posix_spawn_file_actions_t fileActions = {};
-            if (spec.redirectStdout || spec.redirectStderr) {
-                fileActionsPtr = &fileActions;
-                int initResult = posix_spawn_file_actions_init(&fileActions);
-                fileActionsSucceeded = initResult == 0;
-                fileActionsInited = initResult == 0;
-                if (fileActionsSucceeded) {
-                    if (spec.redirectStdout) {
-                        int stdoutRedirectResult = posix_spawn_file_actions_addopen(
-                            &fileActions,
-                            STDOUT_FILENO,
-                            stdoutPath,
-                            O_WRONLY | O_CREAT | O_TRUNC,
-                            S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR
-                        );
-                        fileActionsSucceeded = stdoutRedirectResult == 0;
-                    }
+    if (result) {
+        prb_atomicFetchAddI32(&pool->pendingJobCount, -1, prb_MemoryOrder_SeqCst);
+    }
+    return result;
+}
 
-                    if (fileActionsSucceeded && spec.redirectStderr) {
-                        if (spec.redirectStdout && prb_streq(prb_STR(stdoutPath), prb_STR(stderrPath))) {
-                            int dupResult = posix_spawn_file_actions_adddup2(&fileActions, STDOUT_FILENO, STDERR_FILENO);
-                            fileActionsSucceeded = dupResult == 0;
-                        } else {
-                            int stderrRedirectResult = posix_spawn_file_actions_addopen(
-                                &fileActions,
-                                STDERR_FILENO,
-                                stderrPath,
-                                O_WRONLY | O_CREAT | O_TRUNC,
-                                S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR
-                            );
-                            fileActionsSucceeded = stderrRedirectResult == 0;
-                        }
-                    }
-                }
+static void
+prb_threadPoolRunJob(prb_ThreadPool* pool, prb_Job* job) {
+    job->proc(&job->arena, job->data);
+    // NOTE(khvorov) The job can be gone as soon as this is set
+    prb_atomicStoreI32(&job->poolCompleted, 1, prb_MemoryOrder_SeqCst);
+    if (prb_atomicLoadI32(&pool->waiterCount, prb_MemoryOrder_SeqCst) > 0) {
+        prb_threadPoolLock(pool);
+        prb_threadPoolWakeWaiters(pool);
+        prb_threadPoolUnlock(pool);
+    }
+}
+
+static void
+prb_threadPoolWorkerLoop(prb_ThreadPoolWorker* worker) {
+    prb_ThreadPool* pool = worker->pool;
+    prb_currentThreadPoolWorker = worker;
+    for (bool running = true; running;) {
+        prb_Job* job = prb_threadPoolFindJob(pool, worker);
+        if (job) {
+            prb_threadPoolRunJob(pool, job);
+        } else {
+            // NOTE(khvorov) Submitters bump pendingJobCount before looking at sleeperCount and
+            // we do it the other way round, so one of us is guaranteed to see the other
+            prb_threadPoolLock(pool);
+            prb_atomicFetchAddI32(&pool->sleeperCount, 1, prb_MemoryOrder_SeqCst);
+            while (prb_atomicLoadI32(&pool->pendingJobCount, prb_MemoryOrder_SeqCst) <= 0 && !pool->shutdown) {
+                prb_threadPoolWaitForWork(pool);
             }
+            prb_atomicFetchAddI32(&pool->sleeperCount, -1, prb_MemoryOrder_SeqCst);
+            running = !pool->shutdown || prb_atomicLoadI32(&pool->pendingJobCount, prb_MemoryOrder_SeqCst) > 0;
+            prb_threadPoolUnlock(pool);
+        }
+    }
+    prb_currentThreadPoolWorker = 0;
+}
 
-            if (fileActionsSucceeded) {
-                bool envSucceeded = true;
-                char** env = __environ;
-                bool envAllocated = false;
-                if (proc->spec.addEnv.ptr && proc->spec.addEnv.len > 0) {
-                    envAllocated = true;
-                    env = 0;
-
-                    prb_StrFindSpec space = {};
-                    space.pattern = prb_STR(" ");
-                    space.alwaysMatchEnd = true;
-                    prb_StrFindSpec equals = {};
-                    equals.pattern = prb_STR("=");
-                    prb_StrScanner scanner = prb_createStrScanner(proc->spec.addEnv);
-                    prb_Str* newVarNames = 0;
-                    while (envSucceeded && prb_strScannerMove(&scanner, space, prb_StrScannerSide_AfterMatch)) {
-                        if (scanner.betweenLastMatches.len > 0) {
-                            envSucceeded = false;
-                            prb_StrScanner nameScanner = prb_createStrScanner(scanner.betweenLastMatches);
-                            if (prb_strScannerMove(&nameScanner, equals, prb_StrScannerSide_AfterMatch)) {
-                                if (nameScanner.betweenLastMatches.len > 0) {
-                                    char* newEnvEntry = (char*)prb_strGetNullTerminated(arena, scanner.betweenLastMatches);
-                                    prb_stbds_arrput(env, newEnvEntry);
-                                    prb_stbds_arrput(newVarNames, nameScanner.betweenLastMatches);
-                                    envSucceeded = true;
-                                }
-                            }
-                        }
-                    }
+#if prb_PLATFORM_WINDOWS
 
-                    if (envSucceeded) {
-                        for (int32_t envIndex = 0;; envIndex++) {
-                            char* existingEntry = __environ[envIndex];
-                            if (existingEntry) {
-                                prb_StrScanner nameScanner = prb_createStrScanner(prb_STR(existingEntry));
-                                prb_assert(prb_strScannerMove(&nameScanner, equals, prb_StrScannerSide_AfterMatch));
-                                prb_assert(nameScanner.betweenLastMatches.len > 0);
-                                prb_Str existingName = nameScanner.betweenLastMatches;
-                                bool existingInNew = false;
-                                for (int32_t newVarIndex = 0; newVarIndex < prb_stbds_arrlen(newVarNames) && !existingInNew; newVarIndex++) {
-                                    prb_Str newVarName = newVarNames[newVarIndex];
-                                    existingInNew = prb_streq(newVarName, existingName);
-                                }
-                                if (!existingInNew) {
-                                    prb_stbds_arrput(env, existingEntry);
-                                }
-                            } else {
-                                break;
-                            }
-                        }
+static DWORD WINAPI
+prb_windows_threadPoolWorkerProc(void* data) {
+    prb_threadPoolWorkerLoop((prb_ThreadPoolWorker*)data);
+    return 0;
+}
+
+#elif prb_PLATFORM_LINUX
+
+static void*
+prb_linux_threadPoolWorkerProc(void* data) {
+    prb_threadPoolWorkerLoop((prb_ThreadPoolWorker*)data);
+    return 0;
+}
+
+#endif
+
+static void
+prb_threadPoolSubmit(prb_ThreadPool* pool, prb_Job* jobs, int32_t jobsCount) {
+    prb_assert(pool->valid);
+    prb_atomicFetchAddI32(&pool->pendingJobCount, jobsCount, prb_MemoryOrder_SeqCst);
+
+    prb_ThreadPoolWorker* worker = prb_currentThreadPoolWorker;
+    if (worker && worker->pool != pool) {
+        worker = 0;
+    }
 
-                        // NOTE(khvorov) Null-terminate the new env array
-                        prb_stbds_arrput(env, 0);
-                    }
+    // NOTE(khvorov) Whatever does not go into our own deque is linked up and added to the inject list in one go
+    prb_Job* overflowHead = 0;
+    prb_Job* overflowTail = 0;
+    int32_t  overflowCount = 0;
+    for (int32_t jobIndex = 0; jobIndex < jobsCount; jobIndex++) {
+        prb_Job* job = jobs + jobIndex;
+        job->poolNext = 0;
+        prb_atomicStoreI32(&job->poolCompleted, 0, prb_MemoryOrder_Relaxed);
+        if (worker == 0 || !prb_threadPoolDequePush(&worker->deque, job)) {
+            if (overflowTail) {
+                overflowTail->poolNext = job;
+            } else {
+                overflowHead = job;
+            }
+            overflowTail = job;
+            overflowCount += 1;
+        }
+    }
 
-                    prb_stbds_arrfree(newVarNames);
-                }
+    if (overflowCount > 0) {
+        prb_threadPoolLock(pool);
+        if (pool->injectTail) {
+            pool->injectTail->poolNext = overflowHead;
+        } else {
+            pool->injectHead = overflowHead;
+        }
+        pool->injectTail = overflowTail;
+        prb_atomicStoreI32(&pool->injectCount, pool->injectCount + overflowCount, prb_MemoryOrder_Relaxed);
+        prb_threadPoolUnlock(pool);
+    }
 
-                if (envSucceeded) {
-                    const char** args = prb_getArgArrayFromStr(arena, proc->cmd);
-                    int spawnResult = posix_spawnp(&proc->pid, args[0], fileActionsPtr, 0, (char**)args, env);
-                    if (spawnResult == 0) {
-                        proc->status = prb_ProcessStatus_Launched;
-                        if (mode == prb_Background_No) {
-                            prb_linux_waitForProcess(proc);
-                        }
-                    }
-                    prb_stbds_arrfree(args);
-                }
+    if (prb_atomicLoadI32(&pool->sleeperCount, prb_MemoryOrder_SeqCst) > 0) {
+        prb_threadPoolLock(pool);
+        prb_threadPoolWakeWorkers(pool, jobsCount > 1);
+        prb_threadPoolUnlock(pool);
+    }
+}
 
-                if (envAllocated) {
-                    prb_stbds_arrfree(env);
-                }
-            }
+static void
+prb_threadPoolWaitForJob(prb_ThreadPool* pool, prb_Job* job) {
+    prb_ThreadPoolWorker* worker = prb_currentThreadPoolWorker;
+    if (worker && worker->pool != pool) {
+        worker = 0;
+    }
 
-            if (fileActionsInited) {
-                posix_spawn_file_actions_destroy(fileActionsPtr);
+    while (!prb_atomicLoadI32(&job->poolCompleted, prb_MemoryOrder_Acquire)) {
+        // NOTE(khvorov) Help out while waiting, otherwise jobs that wait on other jobs could take up every worker
+        prb_Job* otherJob = prb_threadPoolFindJob(pool, worker);
+        if (otherJob) {
+            prb_threadPoolRunJob(pool, otherJob);
+        } else {
+            prb_threadPoolLock(pool);
+            prb_atomicFetchAddI32(&pool->waiterCount, 1, prb_MemoryOrder_SeqCst);
+            while (!prb_atomicLoadI32(&job->poolCompleted, prb_MemoryOrder_SeqCst) && prb_atomicLoadI32(&pool->pendingJobCount, prb_MemoryOrder_SeqCst) <= 0) {
+                prb_threadPoolWaitForDone(pool);
             }
+            prb_atomicFetchAddI32(&pool->waiterCount, -1, prb_MemoryOrder_SeqCst);
+            prb_threadPoolUnlock(pool);
+        }
+    }
+}
 
-#else
-#error unimplemented
-#endif
+// NOTE(khvorov) Callers from outside the pool don't help out with other jobs unlike prb_threadPoolWaitForJob,
+// they want to know about the first completion as soon as it happens. A worker of the pool has to help
+// though, it's taking up a worker the jobs might be waiting for (all of them if the pool only has one).
+static int32_t
+prb_threadPoolWaitForAnyJob(prb_ThreadPool* pool, prb_Job* jobs, int32_t jobsCount) {
+    prb_ThreadPoolWorker* worker = prb_currentThreadPoolWorker;
+    if (worker && worker->pool != pool) {
+        worker = 0;
+    }
 
-            prb_ProcessStatus reqStatus = prb_ProcessStatus_CompletedSuccess;
-            if (mode == prb_Background_Yes) {
-                reqStatus = prb_ProcessStatus_Launched;
+    int32_t result = -1;
+    while (result == -1) {
+        bool help = false;
+        prb_threadPoolLock(pool);
+        prb_atomicFetchAddI32(&pool->waiterCount, 1, prb_MemoryOrder_SeqCst);
+        while (result == -1 && !help) {
+            for (int32_t jobIndex = 0; jobIndex < jobsCount && result == -1; jobIndex++) {
+                prb_Job* job = jobs + jobIndex;
+                if (job->status == prb_JobStatus_Launched && prb_atomicLoadI32(&job->poolCompleted, prb_MemoryOrder_SeqCst)) {
+                    result = jobIndex;
+                }
             }
-            if (proc->status != reqStatus) {
-                result = prb_Failure;
+            help = worker && prb_atomicLoadI32(&pool->pendingJobCount, prb_MemoryOrder_SeqCst) > 0;
+            if (result == -1 && !help) {
+                prb_threadPoolWaitForDone(pool);
             }
         }
-    }
+        prb_atomicFetchAddI32(&pool->waiterCount, -1, prb_MemoryOrder_SeqCst);
+        prb_threadPoolUnlock(pool);
 
-    prb_endTempMemory(temp);
+        if (result == -1) {
+            prb_Job* otherJob = prb_threadPoolFindJob(pool, worker);
+            if (otherJob) {
+                prb_threadPoolRunJob(pool, otherJob);
+            }
+        }
+    }
     return result;
 }
 
+prb_PUBLICDEF prb_Job
+prb_createJob(prb_JobProc proc, void* data, prb_Arena* arena, int32_t arenaBytes) {
+    prb_Job job;
+    prb_memset(&job, 0, sizeof(job));
+    job.proc = proc;
+    job.data = data;
+    job.arena = prb_createArenaFromArena(arena, arenaBytes);
+    return job;
+}
+
 prb_PUBLICDEF prb_Status
-prb_waitForProcesses(prb_Process* handles, int32_t handleCount) {
+prb_launchJobs(prb_Job* jobs, int32_t jobsCount, prb_Background mode) {
     prb_Status result = prb_Success;
 
-    for (int32_t handleIndex = 0; handleIndex < handleCount; handleIndex++) {
-        prb_Process* handle = handles + handleIndex;
-        prb_assert(handle->status != prb_ProcessStatus_NotLaunched);
-        if (handle->status == prb_ProcessStatus_Launched) {
+    switch (mode) {
+        case prb_Background_No: {
+            for (int32_t jobIndex = 0; jobIndex < jobsCount && result == prb_Success; jobIndex++) {
+                prb_Job* job = jobs + jobIndex;
+                if (job->status == prb_JobStatus_NotLaunched) {
+                    job->status = prb_JobStatus_Launched;
+                    job->proc(&job->arena, job->data);
+                    job->status = prb_JobStatus_Completed;
+                }
+            }
+        } break;
+
+        case prb_Background_Yes: {
+            for (int32_t jobIndex = 0; jobIndex < jobsCount && result == prb_Success; jobIndex++) {
+                prb_Job* job = jobs + jobIndex;
+                if (job->status == prb_JobStatus_NotLaunched && job->pool) {
+                    // NOTE(khvorov) Neighbours going to the same pool are submitted together
+                    int32_t batchCount = 0;
+                    while (jobIndex + batchCount < jobsCount && job[batchCount].pool == job->pool && job[batchCount].status == prb_JobStatus_NotLaunched) {
+                        job[batchCount].status = prb_JobStatus_Launched;
+                        batchCount += 1;
+                    }
+                    prb_threadPoolSubmit(job->pool, job, batchCount);
+                    jobIndex += batchCount - 1;
+                } else if (job->status == prb_JobStatus_NotLaunched) {
+                    job->status = prb_JobStatus_Launched;
 #if prb_PLATFORM_WINDOWS
-            prb_windows_waitForProcess(handle);
+                    job->threadhandle = CreateThread(0, 0, prb_windows_threadProc, job, 0, &job->threadid);
+                    if (job->threadhandle == NULL) {
+                        result = prb_Failure;
+                    }
 #elif prb_PLATFORM_LINUX
-            prb_linux_waitForProcess(handle);
+                    if (pthread_create(&job->threadid, 0, prb_linux_threadProc, job) != 0) {
+                        result = prb_Failure;
+                    }
 #else
 #error unimplemented
 #endif
-
-            if (handle->status != prb_ProcessStatus_CompletedSuccess) {
-                result = prb_Failure;
+                }
             }
-        }
+        } break;
     }
 
     return result;
 }
 
 prb_PUBLICDEF prb_Status
-prb_killProcesses(prb_Process* handles, int32_t handleCount) {
+prb_waitForJobs(prb_Job* jobs, int32_t jobsCount) {
     prb_Status result = prb_Success;
-
-    for (int32_t handleIndex = 0; handleIndex < handleCount; handleIndex++) {
-        prb_Process* handle = handles + handleIndex;
-        prb_assert(handle->status != prb_ProcessStatus_NotLaunched);
-        if (handle->status == prb_ProcessStatus_Launched) {
+    for (int32_t jobIndex = 0; jobIndex < jobsCount; jobIndex++) {
+        prb_Job* job = jobs + jobIndex;
+        prb_assert(job->status != prb_JobStatus_NotLaunched);
+        if (job->status == prb_JobStatus_Launched && job->pool) {
+            prb_threadPoolWaitForJob(job->pool, job);
+            job->status = prb_JobStatus_Completed;
+        } else if (job->status == prb_JobStatus_Launched) {
 #if prb_PLATFORM_WINDOWS
-            if (TerminateProcess(handle->processInfo.hProcess, 9)) {
-                handle->status = prb_ProcessStatus_CompletedFailed;
-                CloseHandle(handle->processInfo.hProcess);
-                CloseHandle(handle->processInfo.hThread);
+
+            if (WaitForSingleObject(job->threadhandle, INFINITE) == WAIT_OBJECT_0) {
+                job->status = prb_JobStatus_Completed;
+            } else {
+                result = prb_Failure;
             }
+
 #elif prb_PLATFORM_LINUX
-            if (kill(handle->pid, SIGKILL) == 0) {
-                handle->status = prb_ProcessStatus_CompletedFailed;
+
+            if (pthread_join(job->threadid, 0) == 0) {
+                job->status = prb_JobStatus_Completed;
+            } else {
+                result = prb_Failure;
             }
+
 #else
 #error unimplemented
 #endif
-
-            if (handle->status != prb_ProcessStatus_CompletedFailed) {
-                result = prb_Failure;
-            }
         }
     }
 
     return result;
 }
 
-prb_PUBLICDEF void
-prb_sleep(float ms) {
-#if prb_PLATFORM_WINDOWS
+prb_PUBLICDEF prb_ThreadPool*
+prb_createThreadPool(prb_Arena* arena, int32_t threadCount, int32_t scratchBytes) {
+    prb_ThreadPool* pool = prb_arenaAllocStruct(arena, prb_ThreadPool);
 
-    prb_TimeStart timeStart = prb_timeStart();
-    DWORD         msec = (DWORD)(ms);
-    Sleep(msec);
-    float msSpentSleeping = prb_getMsFrom(timeStart);
+    if (threadCount <= 0) {
+        prb_CoreCountResult cores = prb_getAllowExecutionCoreCount(arena);
+        threadCount = cores.success ? cores.cores : 1;
+    }
+    threadCount = prb_max(threadCount, 1);
+
+    // NOTE(khvorov) Power of 2. Pushes to a full deque go to the inject list instead
+    int64_t dequeCapacity = 4096;
+    pool->workerCount = threadCount;
+    pool->workers = prb_arenaAllocArray(arena, prb_ThreadPoolWorker, threadCount);
+    for (int32_t workerIndex = 0; workerIndex < threadCount; workerIndex++) {
+        prb_ThreadPoolWorker* worker = pool->workers + workerIndex;
+        worker->pool = pool;
+        worker->index = workerIndex;
+        worker->deque.capacity = dequeCapacity;
+        worker->deque.buffer = prb_arenaAllocArray(arena, prb_Job*, dequeCapacity);
+    }
 
-    float left = ms - msSpentSleeping;
-    float msSpentSpinning = 0.0f;
-    timeStart = prb_timeStart();
-    while (msSpentSpinning < left) {
-        msSpentSpinning = prb_getMsFrom(timeStart);
+    // NOTE(khvorov) Every worker's scratch comes out of the caller's arena, so the default is kept small
+    if (scratchBytes <= 0) {
+        scratchBytes = prb_MEGABYTE;
+    }
+    for (int32_t workerIndex = 0; workerIndex < threadCount; workerIndex++) {
+        pool->workers[workerIndex].scratch = prb_createArenaFromArena(arena, scratchBytes);
     }
 
+#if prb_PLATFORM_WINDOWS
+    InitializeSRWLock(&pool->lock);
+    InitializeConditionVariable(&pool->workCond);
+    InitializeConditionVariable(&pool->doneCond);
+    bool syncCreated = true;
 #elif prb_PLATFORM_LINUX
+    bool syncCreated = pthread_mutex_init(&pool->lock, 0) == 0 && pthread_cond_init(&pool->workCond, 0) == 0 && pthread_cond_init(&pool->doneCond, 0) == 0;
+#else
+#error unimplemented
+#endif
 
-    float secf = ms * 0.001f;
-    long int sec = (long int)(secf);
-    long int nsec = (long int)((secf - (float)sec) * 1000.0f * 1000.0f * 1000.0f);
-    struct timespec ts = {.tv_sec = sec, .tv_nsec = nsec};
-    nanosleep(&ts, 0);
-
+    if (syncCreated) {
+        pool->valid = true;
+        int32_t startedCount = 0;
+        for (; startedCount < threadCount; startedCount++) {
+            prb_ThreadPoolWorker* worker = pool->workers + startedCount;
+#if prb_PLATFORM_WINDOWS
+            worker->threadhandle = CreateThread(0, 0, prb_windows_threadPoolWorkerProc, worker, 0, &worker->threadid);
+            if (worker->threadhandle == NULL) {
+                break;
+            }
+#elif prb_PLATFORM_LINUX
+            if (pthread_create(&worker->threadid, 0, prb_linux_threadPoolWorkerProc, worker) != 0) {
+                break;
+            }
 #else
 #error unimplemented
 #endif
-}
+        }
 
-prb_PUBLICDEF bool
-prb_debuggerPresent(prb_Arena* arena) {
-    bool           result = false;
-    prb_TempMemory temp = prb_beginTempMemory(arena);
+        if (startedCount < threadCount) {
+            pool->workerCount = startedCount;
+            prb_destroyThreadPool(pool);
+        }
+    }
+
+    return pool;
+}
 
+prb_PUBLICDEF void
+prb_destroyThreadPool(prb_ThreadPool* pool) {
+    if (pool->valid) {
+        // NOTE(khvorov) Workers finish everything that was submitted before they exit
+        prb_threadPoolLock(pool);
+        pool->shutdown = true;
+        prb_threadPoolWakeWorkers(pool, true);
+        prb_threadPoolUnlock(pool);
+
+        for (int32_t workerIndex = 0; workerIndex < pool->workerCount; workerIndex++) {
+            prb_ThreadPoolWorker* worker = pool->workers + workerIndex;
 #if prb_PLATFORM_WINDOWS
+            WaitForSingleObject(worker->threadhandle, INFINITE);
+            CloseHandle(worker->threadhandle);
+#elif prb_PLATFORM_LINUX
+            pthread_join(worker->threadid, 0);
+#else
+#error unimplemented
+#endif
+        }
 
-    result = IsDebuggerPresent();
+#if prb_PLATFORM_LINUX
+        pthread_cond_destroy(&pool->doneCond);
+        pthread_cond_destroy(&pool->workCond);
+        pthread_mutex_destroy(&pool->lock);
+#endif
+        pool->valid = false;
+    }
+}
 
-#elif prb_PLATFORM_LINUX
+static int32_t
+prb_jobGraphAddNode(prb_JobGraph* graph, prb_JobGraphNodeKind kind, prb_Job* job, prb_Process* proc, float cost) {
+    prb_JobGraphNode node;
+    prb_memset(&node, 0, sizeof(node));
+    node.kind = kind;
+    node.job = job;
+    node.process = proc;
+    node.cost = cost;
+    int32_t result = (int32_t)prb_stbds_arrlen(graph->nodes);
+    prb_stbds_arrput(graph->nodes, node);
+    return result;
+}
 
-    prb_Bytes content = prb_linux_readFromProc(arena, prb_STR("self/status"));
-    prb_Str str = {(const char*)content.data, content.len};
-    prb_StrScanner iter = prb_createStrScanner(str);
-    prb_StrFindSpec lineBreakSpec = {};
-    lineBreakSpec.mode = prb_StrFindMode_LineBreak;
-    while (prb_strScannerMove(&iter, lineBreakSpec, prb_StrScannerSide_AfterMatch)) {
-        prb_Str search = prb_STR("TracerPid:");
-        if (prb_strStartsWith(iter.betweenLastMatches, search)) {
-            prb_Str number = prb_strTrim(prb_strSlice(iter.betweenLastMatches, search.len, iter.betweenLastMatches.len));
-            result = number.len > 1 || number.ptr[0] != '0';
+// NOTE(khvorov) Runs on a pool worker, or inline without a pool. Processes are waited on from here too so that
+// the scheduler only has to watch pool jobs
+static void
+prb_jobGraphNodeProc(prb_Arena* arena, void* data) {
+    prb_JobGraphNode* node = (prb_JobGraphNode*)data;
+    switch (node->kind) {
+        case prb_JobGraphNodeKind_Job: {
+            node->job->proc(&node->job->arena, node->job->data);
+        } break;
+        case prb_JobGraphNodeKind_Process: {
+            prb_TempMemory temp = prb_beginTempMemory(arena);
+            prb_launchProcesses(arena, node->process, 1, prb_Background_No);
+            prb_endTempMemory(temp);
+        } break;
+    }
+}
+
+static void
+prb_jobGraphReadyPush(int32_t* heap, int32_t* heapCount, prb_JobGraphNode* nodes, int32_t nodeIndex) {
+    int32_t child = *heapCount;
+    *heapCount += 1;
+    heap[child] = nodeIndex;
+    while (child > 0) {
+        int32_t parent = (child - 1) / 2;
+        if (nodes[heap[parent]].criticalPathCost >= nodes[heap[child]].criticalPathCost) {
             break;
         }
+        int32_t tmp = heap[parent];
+        heap[parent] = heap[child];
+        heap[child] = tmp;
+        child = parent;
     }
+}
 
-#else
-#error unimplemented
-#endif
+static int32_t
+prb_jobGraphReadyPop(int32_t* heap, int32_t* heapCount, prb_JobGraphNode* nodes) {
+    int32_t result = heap[0];
+    *heapCount -= 1;
+    heap[0] = heap[*heapCount];
+    int32_t parent = 0;
+    for (;;) {
+        int32_t largest = parent;
+        int32_t children[] = {parent * 2 + 1, parent * 2 + 2};
+        for (int32_t childIndex = 0; childIndex < prb_arrayCount(children); childIndex++) {
+            int32_t child = children[childIndex];
+            if (child < *heapCount && nodes[heap[child]].criticalPathCost > nodes[heap[largest]].criticalPathCost) {
+                largest = child;
+            }
+        }
+        if (largest == parent) {
+            break;
+        }
+        int32_t tmp = heap[parent];
+        heap[parent] = heap[largest];
+        heap[largest] = tmp;
+        parent = largest;
+    }
+    return result;
+}
 
-    prb_endTempMemory(temp);
+prb_PUBLICDEF int32_t
+prb_jobGraphAddJob(prb_JobGraph* graph, prb_Job* job, float cost) {
+    int32_t result = prb_jobGraphAddNode(graph, prb_JobGraphNodeKind_Job, job, 0, cost);
+    return result;
+}
+
+prb_PUBLICDEF int32_t
+prb_jobGraphAddProcess(prb_JobGraph* graph, prb_Process* proc, float cost) {
+    int32_t result = prb_jobGraphAddNode(graph, prb_JobGraphNodeKind_Process, 0, proc, cost);
     return result;
 }
 
+prb_PUBLICDEF void
+prb_jobGraphAddDep(prb_JobGraph* graph, int32_t nodeIndex, int32_t depIndex) {
+    int32_t nodeCount = (int32_t)prb_stbds_arrlen(graph->nodes);
+    prb_assert(nodeIndex >= 0 && nodeIndex < nodeCount && depIndex >= 0 && depIndex < nodeCount);
+    prb_stbds_arrput(graph->nodes[nodeIndex].deps, depIndex);
+}
+
 prb_PUBLICDEF prb_Status
-prb_setenv(prb_Arena* arena, prb_Str name, prb_Str value) {
-    prb_TempMemory temp = prb_beginTempMemory(arena);
-    prb_Status     result = prb_Failure;
+prb_runJobGraph(prb_Arena* arena, prb_JobGraph* graph, prb_ThreadPool* pool) {
+    prb_Status        result = prb_Success;
+    prb_TempMemory    temp = prb_beginTempMemory(arena);
+    prb_JobGraphNode* nodes = graph->nodes;
+    int32_t           nodeCount = (int32_t)prb_stbds_arrlen(nodes);
+
+    // NOTE(khvorov) Dependents of every node laid out back to back, node i owns [dependentsStart[i], dependentsStart[i + 1])
+    int32_t* dependentsStart = prb_arenaAllocArray(arena, int32_t, nodeCount + 1);
+    int32_t* remainingDepCounts = prb_arenaAllocArray(arena, int32_t, nodeCount);
+    int32_t  edgeCount = 0;
+    for (int32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+        int32_t depCount = (int32_t)prb_stbds_arrlen(nodes[nodeIndex].deps);
+        remainingDepCounts[nodeIndex] = depCount;
+        edgeCount += depCount;
+        for (int32_t depIndex = 0; depIndex < depCount; depIndex++) {
+            dependentsStart[nodes[nodeIndex].deps[depIndex] + 1] += 1;
+        }
+    }
+    for (int32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+        dependentsStart[nodeIndex + 1] += dependentsStart[nodeIndex];
+    }
+    int32_t* dependents = prb_arenaAllocArray(arena, int32_t, edgeCount);
+    {
+        int32_t* fillCounts = prb_arenaAllocArray(arena, int32_t, nodeCount);
+        for (int32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+            for (int32_t depIndex = 0; depIndex < prb_stbds_arrlen(nodes[nodeIndex].deps); depIndex++) {
+                int32_t dep = nodes[nodeIndex].deps[depIndex];
+                dependents[dependentsStart[dep] + fillCounts[dep]] = nodeIndex;
+                fillCounts[dep] += 1;
+            }
+        }
+    }
 
-#if prb_PLATFORM_WINDOWS
+    // NOTE(khvorov) Kahn's algorithm, whatever does not make it into the order is on a cycle or waits on one
+    int32_t* order = prb_arenaAllocArray(arena, int32_t, nodeCount);
+    int32_t  orderCount = 0;
+    {
+        int32_t* depCounts = prb_arenaAllocArray(arena, int32_t, nodeCount);
+        for (int32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+            depCounts[nodeIndex] = remainingDepCounts[nodeIndex];
+            if (depCounts[nodeIndex] == 0) {
+                order[orderCount++] = nodeIndex;
+            }
+        }
+        for (int32_t orderIndex = 0; orderIndex < orderCount; orderIndex++) {
+            int32_t nodeIndex = order[orderIndex];
+            for (int32_t dependentIndex = dependentsStart[nodeIndex]; dependentIndex < dependentsStart[nodeIndex + 1]; dependentIndex++) {
+                int32_t dependent = dependents[dependentIndex];
+                depCounts[dependent] -= 1;
+                if (depCounts[dependent] == 0) {
+                    order[orderCount++] = dependent;
+                }
+            }
+        }
+    }
 
-    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
-    prb_windows_WideStr wvalue = prb_windows_getWideStr(arena, value);
-    if (SetEnvironmentVariableW(wname.ptr, wvalue.ptr)) {
-        result = prb_Success;
+    if (orderCount < nodeCount) {
+        result = prb_Failure;
+    } else {
+        for (int32_t orderIndex = nodeCount - 1; orderIndex >= 0; orderIndex--) {
+            int32_t           nodeIndex = order[orderIndex];
+            prb_JobGraphNode* node = nodes + nodeIndex;
+            float             longestAfter = 0;
+            for (int32_t dependentIndex = dependentsStart[nodeIndex]; dependentIndex < dependentsStart[nodeIndex + 1]; dependentIndex++) {
+                longestAfter = prb_max(longestAfter, nodes[dependents[dependentIndex]].criticalPathCost);
+            }
+            node->criticalPathCost = (node->cost > 0 ? node->cost : 1) + longestAfter;
+            node->status = prb_JobGraphNodeStatus_NotStarted;
+        }
+
+        // NOTE(khvorov) Without a pool nodes run one at a time on the calling thread, same as prb_parallelFor
+        prb_assert(pool == 0 || pool->valid);
+
+        // NOTE(khvorov) No more nodes running than there are workers, so the order nodes start in actually matters
+        int32_t  slotCount = pool ? pool->workerCount : 1;
+        prb_Job* slotJobs = prb_arenaAllocArray(arena, prb_Job, slotCount);
+        int32_t* slotNodes = prb_arenaAllocArray(arena, int32_t, slotCount);
+        int32_t  freeSlotCount = slotCount;
+        int32_t* freeSlots = prb_arenaAllocArray(arena, int32_t, slotCount);
+        for (int32_t slotIndex = 0; slotIndex < slotCount; slotIndex++) {
+            freeSlots[slotIndex] = slotCount - 1 - slotIndex;
+        }
+        prb_Arena* slotArenas = prb_arenaAllocArray(arena, prb_Arena, slotCount);
+        intptr_t   slotArenaBytes = prb_min(prb_arenaFreeSize(arena) / (slotCount + 1), 16 * prb_MEGABYTE);
+        for (int32_t slotIndex = 0; slotIndex < slotCount; slotIndex++) {
+            slotArenas[slotIndex] = prb_createArenaFromArena(arena, slotArenaBytes);
+        }
+
+        int32_t* readyHeap = prb_arenaAllocArray(arena, int32_t, nodeCount);
+        int32_t  readyCount = 0;
+        bool*    depFailed = prb_arenaAllocArray(arena, bool, nodeCount);
+        int32_t* finished = prb_arenaAllocArray(arena, int32_t, nodeCount);
+        for (int32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+            if (remainingDepCounts[nodeIndex] == 0) {
+                prb_jobGraphReadyPush(readyHeap, &readyCount, nodes, nodeIndex);
+            }
+        }
+
+        for (int32_t runningCount = 0; readyCount > 0 || runningCount > 0;) {
+            while (readyCount > 0 && freeSlotCount > 0) {
+                int32_t           nodeIndex = prb_jobGraphReadyPop(readyHeap, &readyCount, nodes);
+                prb_JobGraphNode* node = nodes + nodeIndex;
+                int32_t           slot = freeSlots[--freeSlotCount];
+                node->status = prb_JobGraphNodeStatus_Running;
+                if (node->kind == prb_JobGraphNodeKind_Job) {
+                    node->job->status = prb_JobStatus_Launched;
+                }
+                slotJobs[slot] = prb_createJob(prb_jobGraphNodeProc, node, arena, 0);
+                slotJobs[slot].arena = slotArenas[slot];
+                slotJobs[slot].pool = pool;
+                slotNodes[slot] = nodeIndex;
+                prb_launchJobs(slotJobs + slot, 1, pool ? prb_Background_Yes : prb_Background_No);
+                runningCount += 1;
+            }
+
+            if (runningCount > 0) {
+                int32_t slot = pool ? prb_threadPoolWaitForAnyJob(pool, slotJobs, slotCount) : 0;
+                prb_waitForJobs(slotJobs + slot, 1);
+                freeSlots[freeSlotCount++] = slot;
+                runningCount -= 1;
+
+                prb_JobGraphNode* node = nodes + slotNodes[slot];
+                switch (node->kind) {
+                    case prb_JobGraphNodeKind_Job: {
+                        node->job->status = prb_JobStatus_Completed;
+                        node->status = prb_JobGraphNodeStatus_Completed;
+                    } break;
+                    case prb_JobGraphNodeKind_Process: {
+                        node->status = node->process->status == prb_ProcessStatus_CompletedSuccess ? prb_JobGraphNodeStatus_Completed : prb_JobGraphNodeStatus_Failed;
+                    } break;
+                }
+
+                // NOTE(khvorov) Skipped nodes count as finished too, their dependents get skipped in turn
+                int32_t finishedCount = 0;
+                finished[finishedCount++] = slotNodes[slot];
+                while (finishedCount > 0) {
+                    int32_t nodeIndex = finished[--finishedCount];
+                    bool    failed = nodes[nodeIndex].status != prb_JobGraphNodeStatus_Completed;
+                    if (failed) {
+                        result = prb_Failure;
+                    }
+                    for (int32_t dependentIndex = dependentsStart[nodeIndex]; dependentIndex < dependentsStart[nodeIndex + 1]; dependentIndex++) {
+                        int32_t dependent = dependents[dependentIndex];
+                        depFailed[dependent] = depFailed[dependent] || failed;
+                        remainingDepCounts[dependent] -= 1;
+                        if (remainingDepCounts[dependent] == 0) {
+                            if (depFailed[dependent]) {
+                                nodes[dependent].status = prb_JobGraphNodeStatus_Skipped;
+                                finished[finishedCount++] = dependent;
+                            } else {
+                                prb_jobGraphReadyPush(readyHeap, &readyCount, nodes, dependent);
+                            }
+                        }
+                    }
+                }
+            }
+        }
     }
 
-#elif prb_PLATFORM_LINUX
-    const char* nameNull = prb_strGetNullTerminated(arena, name);
-    const char* valueNull = prb_strGetNullTerminated(arena, value);
-    result = setenv(nameNull, valueNull, 1) == 0 ? prb_Success : prb_Failure;
-#else
-#error unimplemented
-#endif
-
     prb_endTempMemory(temp);
     return result;
 }
 
-prb_PUBLICDEF prb_GetenvResult
-prb_getenv(prb_Arena* arena, prb_Str name) {
-    prb_GetenvResult result;
-    prb_memset(&result, 0, sizeof(result));
+prb_PUBLICDEF void
+prb_destroyJobGraph(prb_JobGraph* graph) {
+    for (int32_t nodeIndex = 0; nodeIndex < prb_stbds_arrlen(graph->nodes); nodeIndex++) {
+        prb_stbds_arrfree(graph->nodes[nodeIndex].deps);
+    }
+    prb_stbds_arrfree(graph->nodes);
+}
 
-#if prb_PLATFORM_WINDOWS
+typedef struct prb_ParallelFor {
+    prb_ParallelForProc proc;
+    void*               data;
+    int32_t             count;
+    int32_t             grainSize;
+    // NOTE(khvorov) Every thread steps past the end once, which could overflow 32 bits near the max count
+    alignas(64) int64_t nextIndex;
+} prb_ParallelFor;
 
-    prb_arenaAlignFreePtr(arena, prb_alignof(uint16_t));
-    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
-    LPWSTR              wptr = (LPWSTR)prb_arenaFreePtr(arena);
-    DWORD               getEnvResult = GetEnvironmentVariableW(wname.ptr, wptr, (DWORD)prb_min(prb_arenaFreeSize(arena), UINT32_MAX));
-    if (getEnvResult > 0) {
-        prb_arenaChangeUsed(arena, (int32_t)getEnvResult * (int32_t)sizeof(*wptr));
-        prb_arenaAllocAndZero(arena, 2, 1);  // NOTE(khvorov) Null terminator
-        result.str = prb_windows_strFromWideStr(arena, (prb_windows_WideStr) {wptr, (int32_t)getEnvResult});
-        result.found = true;
+static void
+prb_parallelForRunChunks(prb_Arena* scratch, prb_ParallelFor* parallelFor) {
+    for (;;) {
+        int64_t from = prb_atomicFetchAddI64(&parallelFor->nextIndex, parallelFor->grainSize, prb_MemoryOrder_Relaxed);
+        if (from >= parallelFor->count) {
+            break;
+        }
+        int64_t        to = prb_min(from + parallelFor->grainSize, (int64_t)parallelFor->count);
+        prb_TempMemory temp = prb_beginTempMemory(scratch);
+        parallelFor->proc(scratch, parallelFor->data, (int32_t)from, (int32_t)to);
+        prb_endTempMemory(temp);
+    }
+}
+
+// NOTE(khvorov) Helpers that end up on a thread that is not a pool worker have no scratch to use,
+// they leave the chunks to the calling thread, which goes through whatever is left anyway
+static void
+prb_parallelForJobProc(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    prb_ThreadPoolWorker* worker = prb_currentThreadPoolWorker;
+    if (worker) {
+        prb_parallelForRunChunks(&worker->scratch, (prb_ParallelFor*)data);
     }
+}
 
-#elif prb_PLATFORM_LINUX
+prb_PUBLICDEF void
+prb_parallelFor(prb_Arena* arena, prb_ThreadPool* pool, int32_t count, int32_t grainSize, prb_ParallelForProc proc, void* data) {
+    prb_assert(pool == 0 || pool->valid);
     prb_TempMemory temp = prb_beginTempMemory(arena);
-    const char* nameNull = prb_strGetNullTerminated(arena, name);
-    char* str = getenv(nameNull);
-    if (str) {
-        result.found = true;
-        result.str = prb_STR(str);
+
+    int32_t workerCount = pool ? pool->workerCount : 0;
+    if (grainSize <= 0) {
+        // NOTE(khvorov) A few chunks per thread so that uneven items even out
+        grainSize = prb_max(count / ((workerCount + 1) * 4), 1);
     }
-    prb_endTempMemory(temp);
+    int32_t chunkCount = (int32_t)(((int64_t)count + grainSize - 1) / grainSize);
+
+    prb_ParallelFor parallelFor = {};
+    parallelFor.proc = proc;
+    parallelFor.data = data;
+    parallelFor.count = count;
+    parallelFor.grainSize = grainSize;
+
+    // NOTE(khvorov) The calling thread takes chunks too, so one helper fewer than chunks is enough
+    int32_t  helperCount = prb_max(prb_min(workerCount, chunkCount - 1), 0);
+    prb_Job* helpers = prb_arenaAllocArray(arena, prb_Job, helperCount);
+    for (int32_t helperIndex = 0; helperIndex < helperCount; helperIndex++) {
+        helpers[helperIndex] = prb_createJob(prb_parallelForJobProc, &parallelFor, arena, 0);
+        helpers[helperIndex].pool = pool;
+    }
+    prb_launchJobs(helpers, helperCount, prb_Background_Yes);
 
-#else
-#error unimplemented
-#endif
+    prb_ThreadPoolWorker* worker = prb_currentThreadPoolWorker;
+    prb_parallelForRunChunks(worker ? &worker->scratch : arena, &parallelFor);
 
-    return result;
+    prb_waitForJobs(helpers, helperCount);
+    prb_endTempMemory(temp);
 }
 
-prb_PUBLICDEF prb_Status
-prb_unsetenv(prb_Arena* arena, prb_Str name) {
-    prb_TempMemory temp = prb_beginTempMemory(arena);
-    prb_Status     result = prb_Failure;
+prb_PUBLICDEF prb_MpmcQueue
+prb_createMpmcQueue(prb_Arena* arena, int32_t capacity) {
+    // NOTE(khvorov) Rounded up to a power of 2, there need to be at least 2 cells
+    int64_t cellCount = 2;
+    while (cellCount < capacity) {
+        cellCount *= 2;
+    }
 
-#if prb_PLATFORM_WINDOWS
+    // NOTE(khvorov) Arena allocations are sized in 32 bits
+    int64_t cellsBytes = cellCount * (int64_t)sizeof(prb_MpmcQueueCell);
+    prb_assert(cellsBytes <= INT32_MAX);
 
-    prb_windows_WideStr wname = prb_windows_getWideStr(arena, name);
-    if (SetEnvironmentVariableW(wname.ptr, NULL)) {
-        result = prb_Success;
+    prb_MpmcQueue queue = {};
+    queue.cells = (prb_MpmcQueueCell*)prb_arenaAllocAndZero(arena, (int32_t)cellsBytes, prb_alignof(prb_MpmcQueueCell));
+    queue.mask = cellCount - 1;
+    for (int64_t cellIndex = 0; cellIndex < cellCount; cellIndex++) {
+        queue.cells[cellIndex].sequence = cellIndex;
     }
+    return queue;
+}
 
-#elif prb_PLATFORM_LINUX
+// NOTE(khvorov) A cell's sequence says whose turn it is. It equals the position when the cell is free
+// for a push at that position and the position + 1 when it holds a value for a pop at that position
+prb_PUBLICDEF prb_Status
+prb_mpmcQueuePush(prb_MpmcQueue* queue, void* value) {
+    prb_Status         result = prb_Failure;
+    prb_MpmcQueueCell* cell = 0;
+    int64_t            pos = prb_atomicLoadI64(&queue->pushPos, prb_MemoryOrder_Relaxed);
+    for (;;) {
+        cell = queue->cells + (pos & queue->mask);
+        int64_t sequence = prb_atomicLoadI64(&cell->sequence, prb_MemoryOrder_Acquire);
+        int64_t diff = sequence - pos;
+        if (diff == 0) {
+            if (prb_atomicCasI64(&queue->pushPos, &pos, pos + 1, prb_MemoryOrder_Relaxed)) {
+                result = prb_Success;
+                break;
+            }
+        } else if (diff < 0) {
+            // NOTE(khvorov) Full, the cell still holds the value from a lap ago
+            break;
+        } else {
+            pos = prb_atomicLoadI64(&queue->pushPos, prb_MemoryOrder_Relaxed);
+        }
+    }
 
-    const char* nameNull = prb_strGetNullTerminated(arena, name);
-    result = unsetenv(nameNull) == 0 ? prb_Success : prb_Failure;
+    if (result == prb_Success) {
+        cell->value = value;
+        prb_atomicStoreI64(&cell->sequence, pos + 1, prb_MemoryOrder_Release);
+    }
+    return result;
+}
 
-#else
-#error unimplemented
-#endif
+prb_PUBLICDEF prb_MpmcQueuePopResult
+prb_mpmcQueuePop(prb_MpmcQueue* queue) {
+    prb_MpmcQueuePopResult result = {.success = false, .value = 0};
+    prb_MpmcQueueCell*     cell = 0;
+    int64_t                pos = prb_atomicLoadI64(&queue->popPos, prb_MemoryOrder_Relaxed);
+    for (;;) {
+        cell = queue->cells + (pos & queue->mask);
+        int64_t sequence = prb_atomicLoadI64(&cell->sequence, prb_MemoryOrder_Acquire);
+        int64_t diff = sequence - (pos + 1);
+        if (diff == 0) {
+            if (prb_atomicCasI64(&queue->popPos, &pos, pos + 1, prb_MemoryOrder_Relaxed)) {
+                result.success = true;
+                break;
+            }
+        } else if (diff < 0) {
+            // NOTE(khvorov) Empty, nobody pushed to this cell yet
+            break;
+        } else {
+            pos = prb_atomicLoadI64(&queue->popPos, prb_MemoryOrder_Relaxed);
+        }
+    }
 
-    prb_endTempMemory(temp);
+    if (result.success) {
+        result.value = cell->value;
+        prb_atomicStoreI64(&cell->sequence, pos + queue->mask + 1, prb_MemoryOrder_Release);
+    }
     return result;
 }
 
-//
-// SECTION Timing (implementation)
-//
-
-prb_PUBLICDEF prb_TimeStart
-prb_timeStart(void) {
-    prb_TimeStart result;
-    prb_memset(&result, 0, sizeof(result));
+// NOTE(khvorov) Sleeps only if the word still holds the expected value, spurious wakeups are fine for every caller
+static void
+prb_futexWait(int32_t* word, int32_t expected) {
 #if prb_PLATFORM_WINDOWS
-    LARGE_INTEGER ticks;
-    prb_memset(&ticks, 0, sizeof(ticks));
-    if (QueryPerformanceCounter(&ticks)) {
-        result.valid = true;
-        result.ticks = ticks.QuadPart;
-    }
+    WaitOnAddress((volatile VOID*)word, &expected, sizeof(expected), INFINITE);
 #elif prb_PLATFORM_LINUX
-    struct timespec tp = {};
-    if (clock_gettime(CLOCK_MONOTONIC, &tp) == 0) {
-        prb_assert(tp.tv_nsec >= 0 && tp.tv_sec >= 0);
-        result.nsec = (uint64_t)tp.tv_nsec + (uint64_t)tp.tv_sec * 1000 * 1000 * 1000;
-        result.valid = true;
-    }
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
 #else
 #error unimplemented
 #endif
-    return result;
 }
 
-prb_PUBLICDEF float
-prb_getMsFrom(prb_TimeStart timeStart) {
-    prb_TimeStart now = prb_timeStart();
-    float         result = 0.0f;
-    if (now.valid && timeStart.valid) {
+static void
+prb_futexWake(int32_t* word, int32_t count) {
 #if prb_PLATFORM_WINDOWS
-        LARGE_INTEGER ticksPerSecond;
-        prb_memset(&ticksPerSecond, 0, sizeof(ticksPerSecond));
-        if (QueryPerformanceFrequency(&ticksPerSecond)) {
-            LONGLONG ticksDiff = now.ticks - timeStart.ticks;
-            float    secs = (float)ticksDiff / (float)ticksPerSecond.QuadPart;
-            result = secs * 1000.0f;
-        }
+    if (count == 1) {
+        WakeByAddressSingle((PVOID)word);
+    } else {
+        WakeByAddressAll((PVOID)word);
+    }
 #elif prb_PLATFORM_LINUX
-        uint64_t nsec = now.nsec - timeStart.nsec;
-        result = (float)nsec / 1000.0f / 1000.0f;
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
 #else
 #error unimplemented
 #endif
-    }
-    return result;
 }
 
-//
-// SECTION Multithreading (implementation)
-//
-
-#if prb_PLATFORM_WINDOWS
-
-static DWORD WINAPI
-prb_windows_threadProc(void* data) {
-    prb_Job* job = (prb_Job*)data;
-    job->proc(&job->arena, job->data);
-    return 0;
+// NOTE(khvorov) Mutex 3 from Drepper's "Futexes are tricky"
+prb_PUBLICDEF void
+prb_mutexLock(prb_Mutex* mutex) {
+    int32_t state = 0;
+    if (!prb_atomicCasI32(&mutex->state, &state, 1, prb_MemoryOrder_Acquire)) {
+        // NOTE(khvorov) Whoever unlocks after us has to wake somebody up, so mark it as contended
+        if (state != 2) {
+            state = prb_atomicExchangeI32(&mutex->state, 2, prb_MemoryOrder_Acquire);
+        }
+        while (state != 0) {
+            prb_futexWait(&mutex->state, 2);
+            state = prb_atomicExchangeI32(&mutex->state, 2, prb_MemoryOrder_Acquire);
+        }
+    }
 }
 
-#elif prb_PLATFORM_LINUX
+prb_PUBLICDEF prb_Status
+prb_mutexTryLock(prb_Mutex* mutex) {
+    int32_t    state = 0;
+    prb_Status result = prb_atomicCasI32(&mutex->state, &state, 1, prb_MemoryOrder_Acquire) ? prb_Success : prb_Failure;
+    return result;
+}
 
-static void*
-prb_linux_threadProc(void* data) {
-    prb_Job* job = (prb_Job*)data;
-    job->proc(&job->arena, job->data);
-    return 0;
+prb_PUBLICDEF void
+prb_mutexUnlock(prb_Mutex* mutex) {
+    if (prb_atomicFetchAddI32(&mutex->state, -1, prb_MemoryOrder_Release) != 1) {
+        prb_atomicStoreI32(&mutex->state, 0, prb_MemoryOrder_Release);
+        prb_futexWake(&mutex->state, 1);
+    }
 }
 
-#endif
+prb_PUBLICDEF prb_Semaphore
+prb_createSemaphore(int32_t count) {
+    prb_assert(count >= 0);
+    prb_Semaphore sem = {.count = count, .waiterCount = 0};
+    return sem;
+}
 
-prb_PUBLICDEF prb_Job
-prb_createJob(prb_JobProc proc, void* data, prb_Arena* arena, int32_t arenaBytes) {
-    prb_Job job;
-    prb_memset(&job, 0, sizeof(job));
-    job.proc = proc;
-    job.data = data;
-    job.arena = prb_createArenaFromArena(arena, arenaBytes);
-    return job;
+prb_PUBLICDEF void
+prb_semaphoreWait(prb_Semaphore* sem) {
+    while (!prb_semaphoreTryWait(sem)) {
+        // NOTE(khvorov) Posters bump the count before looking at waiterCount and we do it the other way round
+        prb_atomicFetchAddI32(&sem->waiterCount, 1, prb_MemoryOrder_SeqCst);
+        prb_futexWait(&sem->count, 0);
+        prb_atomicFetchAddI32(&sem->waiterCount, -1, prb_MemoryOrder_Relaxed);
+    }
 }
 
 prb_PUBLICDEF prb_Status
-prb_launchJobs(prb_Job* jobs, int32_t jobsCount, prb_Background mode) {
-    prb_Status result = prb_Success;
-
-    switch (mode) {
-        case prb_Background_No: {
-            for (int32_t jobIndex = 0; jobIndex < jobsCount && result == prb_Success; jobIndex++) {
-                prb_Job* job = jobs + jobIndex;
-                if (job->status == prb_JobStatus_NotLaunched) {
-                    job->status = prb_JobStatus_Launched;
-                    job->proc(&job->arena, job->data);
-                    job->status = prb_JobStatus_Completed;
-                }
-            }
-        } break;
-
-        case prb_Background_Yes: {
-            for (int32_t jobIndex = 0; jobIndex < jobsCount && result == prb_Success; jobIndex++) {
-                prb_Job* job = jobs + jobIndex;
-                if (job->status == prb_JobStatus_NotLaunched) {
-                    job->status = prb_JobStatus_Launched;
-#if prb_PLATFORM_WINDOWS
-                    job->threadhandle = CreateThread(0, 0, prb_windows_threadProc, job, 0, &job->threadid);
-                    if (job->threadhandle == NULL) {
-                        result = prb_Failure;
-                    }
-#elif prb_PLATFORM_LINUX
-                    if (pthread_create(&job->threadid, 0, prb_linux_threadProc, job) != 0) {
-                        result = prb_Failure;
-                    }
-#else
-#error unimplemented
-#endif
-                }
-            }
-        } break;
+prb_semaphoreTryWait(prb_Semaphore* sem) {
+    prb_Status result = prb_Failure;
+    int32_t    count = prb_atomicLoadI32(&sem->count, prb_MemoryOrder_Relaxed);
+    while (count > 0 && result == prb_Failure) {
+        if (prb_atomicCasI32(&sem->count, &count, count - 1, prb_MemoryOrder_Acquire)) {
+            result = prb_Success;
+        }
     }
-
     return result;
 }
 
-prb_PUBLICDEF prb_Status
-prb_waitForJobs(prb_Job* jobs, int32_t jobsCount) {
-    prb_Status result = prb_Success;
-    for (int32_t jobIndex = 0; jobIndex < jobsCount; jobIndex++) {
-        prb_Job* job = jobs + jobIndex;
-        prb_assert(job->status != prb_JobStatus_NotLaunched);
-        if (job->status == prb_JobStatus_Launched) {
-#if prb_PLATFORM_WINDOWS
-
-            if (WaitForSingleObject(job->threadhandle, INFINITE) == WAIT_OBJECT_0) {
-                job->status = prb_JobStatus_Completed;
-            } else {
-                result = prb_Failure;
-            }
+prb_PUBLICDEF void
+prb_semaphorePost(prb_Semaphore* sem, int32_t count) {
+    prb_assert(count >= 0);
+    prb_atomicFetchAddI32(&sem->count, count, prb_MemoryOrder_SeqCst);
+    if (prb_atomicLoadI32(&sem->waiterCount, prb_MemoryOrder_SeqCst) > 0) {
+        prb_futexWake(&sem->count, count);
+    }
+}
 
-#elif prb_PLATFORM_LINUX
+prb_PUBLICDEF void
+prb_eventSet(prb_Event* event) {
+    if (prb_atomicExchangeI32(&event->state, 1, prb_MemoryOrder_Release) == 2) {
+        prb_futexWake(&event->state, INT32_MAX);
+    }
+}
 
-            if (pthread_join(job->threadid, 0) == 0) {
-                job->status = prb_JobStatus_Completed;
-            } else {
-                result = prb_Failure;
-            }
+prb_PUBLICDEF void
+prb_eventReset(prb_Event* event) {
+    // NOTE(khvorov) Leaves 2 alone, that already means not set
+    int32_t state = 1;
+    prb_atomicCasI32(&event->state, &state, 0, prb_MemoryOrder_Relaxed);
+}
 
-#else
-#error unimplemented
-#endif
+prb_PUBLICDEF void
+prb_eventWait(prb_Event* event) {
+    for (;;) {
+        int32_t state = prb_atomicLoadI32(&event->state, prb_MemoryOrder_Acquire);
+        if (state == 1) {
+            break;
+        }
+        if (state == 2 || prb_atomicCasI32(&event->state, &state, 2, prb_MemoryOrder_Relaxed)) {
+            prb_futexWait(&event->state, 2);
         }
     }
+}
 
+prb_PUBLICDEF bool
+prb_eventIsSet(prb_Event* event) {
+    bool result = prb_atomicLoadI32(&event->state, prb_MemoryOrder_Acquire) == 1;
     return result;
 }
 
+prb_PUBLICDEF prb_Latch
+prb_createLatch(int32_t count) {
+    prb_assert(count >= 0);
+    prb_Latch latch = {.count = count};
+    return latch;
+}
+
+prb_PUBLICDEF void
+prb_latchCountDown(prb_Latch* latch, int32_t count) {
+    int32_t prevCount = prb_atomicFetchAddI32(&latch->count, -count, prb_MemoryOrder_Release);
+    prb_assert(prevCount >= count);
+    if (prevCount == count) {
+        prb_futexWake(&latch->count, INT32_MAX);
+    }
+}
+
+prb_PUBLICDEF void
+prb_latchWait(prb_Latch* latch) {
+    for (int32_t count = prb_atomicLoadI32(&latch->count, prb_MemoryOrder_Acquire); count != 0;) {
+        prb_futexWait(&latch->count, count);
+        count = prb_atomicLoadI32(&latch->count, prb_MemoryOrder_Acquire);
+    }
+}
+
 //
 // SECTION Random numbers (implementation)
 //
@@ -22,11 +22,13 @@ typedef struct CompileLogEntry {
 } CompileLogEntry;
 
 typedef struct ProjectInfo {
-    prb_Str        rootDir;
-    prb_Str        compileOutDir;
-    Compiler       compiler;
-    bool           release;
-    prb_Background tuCompilationMode;
+    prb_Str             rootDir;
+    prb_Str             compileOutDir;
+    Compiler            compiler;
+    bool                release;
+    prb_Background      tuCompilationMode;
+    prb_ProcessPoolSpec tuPoolSpec;
+    prb_ThreadPool*     pool;
 } ProjectInfo;
 
 typedef enum LogColumn {
@@ -398,6 +400,19 @@ writeLog(prb_Arena* arena, CompileLogEntry* log, prb_Str path, prb_Str* columnNa
     prb_endTempMemory(temp);
 }
 
+typedef struct HashFilesData {
+    prb_Str*      paths;
+    prb_FileHash* hashes;
+} HashFilesData;
+
+function void
+hashFiles(prb_Arena* scratch, void* data, int32_t from, int32_t to) {
+    HashFilesData* hashData = (HashFilesData*)data;
+    for (i32 pathIndex = from; pathIndex < to; pathIndex++) {
+        hashData->hashes[pathIndex] = prb_getFileHash(scratch, hashData->paths[pathIndex]);
+    }
+}
+
 function void
 compileStaticLib(prb_Arena* arena, void* staticLibInfo) {
     prb_TimeStart  compileStart = prb_timeStart();
@@ -466,12 +481,16 @@ compileStaticLib(prb_Arena* arena, void* staticLibInfo) {
         arrput(processesPreprocess, proc);
     }
 
-    prb_assert(prb_launchProcesses(arena, processesPreprocess, arrlen(processesPreprocess), lib->project->tuCompilationMode));
-    prb_Status preprocessStatus = prb_waitForProcesses(processesPreprocess, arrlen(processesPreprocess));
+    prb_Status preprocessStatus = prb_launchProcessPool(arena, processesPreprocess, arrlen(processesPreprocess), lib->project->tuPoolSpec);
     arrfree(processesPreprocess);
 
     // NOTE(khvorov) Compile
     if (preprocessStatus == prb_Success) {
+        // NOTE(khvorov) Reading every preprocessed file is most of the time it takes to figure out what to recompile
+        prb_FileHash* preprocessedHashes = prb_arenaAllocArray(arena, prb_FileHash, arrlen(outputPreprocess));
+        HashFilesData hashData = {outputPreprocess, preprocessedHashes};
+        prb_parallelFor(arena, lib->project->pool, arrlen(outputPreprocess), 1, hashFiles, &hashData);
+
         prb_Str*     outputObjs = 0;
         prb_Process* processesCompile = 0;
         for (i32 inputPathIndex = 0; inputPathIndex < arrlen(inputPaths); inputPathIndex++) {
@@ -491,7 +510,7 @@ compileStaticLib(prb_Arena* arena, void* staticLibInfo) {
 
             // NOTE(khvorov) Figure out if we should recompile this file
             bool         shouldRecompile = true;
-            prb_FileHash preprocessedHash = prb_getFileHash(arena, outputPreprocess[inputPathIndex]);
+            prb_FileHash preprocessedHash = preprocessedHashes[inputPathIndex];
             prb_assert(preprocessedHash.valid);
             if (lib->prevCompileLog != 0 && prb_isFile(arena, outputObjFilepath)) {
                 int32_t logEntryIndex = shgeti(lib->prevCompileLog, outputObjFilepath.ptr);
@@ -539,8 +558,7 @@ compileStaticLib(prb_Arena* arena, void* staticLibInfo) {
             shouldRegenLib = true;
         }
 
-        prb_assert(prb_launchProcesses(arena, processesCompile, arrlen(processesCompile), lib->project->tuCompilationMode));
-        prb_Status compileStatus = prb_waitForProcesses(processesCompile, arrlen(processesCompile));
+        prb_Status compileStatus = prb_launchProcessPool(arena, processesCompile, arrlen(processesCompile), lib->project->tuPoolSpec);
         arrfree(processesCompile);
 
         if (compileStatus == prb_Success) {
@@ -646,9 +664,17 @@ main() {
 
     project->tuCompilationMode = prb_Background_Yes;
 
+    // NOTE(khvorov) Libraries are compiled at the same time, each with its own pool. The pools share a jobserver
+    // so that there's still only a compiler per core overall
+    prb_CoreCountResult cores = prb_getAllowExecutionCoreCount(arena);
+    prb_Jobserver       jobserver = prb_createJobserver(arena, cores.success ? prb_max(cores.cores, 1) : 1, prb_JobserverKind_Pipe);
+    prb_assert(jobserver.valid);
+    project->tuPoolSpec.jobserver = &jobserver;
+
     // NOTE(khvorov) MSVC runs out of memory on CI (lol wtf microsoft)
     if (runningOnCi && project->compiler == Compiler_Msvc) {
         project->tuCompilationMode = prb_Background_No;
+        project->tuPoolSpec.maxInFlight = 1;
     }
 
     //
@@ -1175,28 +1201,6 @@ main() {
     // prb_assert(prb_clearDir(arena, harfbuzz.objDir) == prb_Success);
     // prb_assert(prb_clearDir(arena, sdl.objDir) == prb_Success);
 
-    if (true) {
-        prb_Job* jobs = 0;
-        arrput(jobs, prb_createJob(compileStaticLib, &fribidi, arena, 50 * prb_MEGABYTE));
-        arrput(jobs, prb_createJob(compileStaticLib, &icu, arena, 50 * prb_MEGABYTE));
-        arrput(jobs, prb_createJob(compileStaticLib, &freetype, arena, 50 * prb_MEGABYTE));
-        arrput(jobs, prb_createJob(compileStaticLib, &harfbuzz, arena, 50 * prb_MEGABYTE));
-        arrput(jobs, prb_createJob(compileStaticLib, &sdl, arena, 50 * prb_MEGABYTE));
-
-        // NOTE(khvorov) Multithreading here doesn't really make it faster presumably because each job is
-        // paralellised already anyway
-        prb_assert(prb_launchJobs(jobs, arrlen(jobs), project->tuCompilationMode));
-        prb_assert(prb_waitForJobs(jobs, arrlen(jobs)));
-
-        prb_assert(fribidi.compileStatus == prb_ProcessStatus_CompletedSuccess);
-        prb_assert(icu.compileStatus == prb_ProcessStatus_CompletedSuccess);
-        prb_assert(freetype.compileStatus == prb_ProcessStatus_CompletedSuccess);
-        prb_assert(harfbuzz.compileStatus == prb_ProcessStatus_CompletedSuccess);
-        prb_assert(sdl.compileStatus == prb_ProcessStatus_CompletedSuccess);
-
-        prb_writelnToStdout(arena, prb_fmt(arena, "total deps compile: %.2fms", prb_getMsFrom(compileStart)));
-    }
-
     //
     // SECTION Main program
     //
@@ -1225,12 +1229,7 @@ main() {
     prb_Str mainFlagsStr = prb_stringsJoin(arena, mainFlags, prb_arrayCount(mainFlags), prb_STR(" "));
 
     prb_Str mainCmdPreprocess = constructCompileCmd(arena, project, mainFlagsStr, mainNotPreprocessedPath, mainPreprocessedPath, prb_STR(""));
-    prb_writelnToStdout(arena, mainCmdPreprocess);
-    prb_Process mainHandlePre = prb_createProcess(mainCmdPreprocess, (prb_ProcessSpec) {});
-    prb_assert(prb_launchProcesses(arena, &mainHandlePre, 1, prb_Background_Yes));
-
     prb_Str mainCmdObj = constructCompileCmd(arena, project, mainFlagsStr, mainNotPreprocessedPath, mainObjPath, prb_STR(""));
-    prb_assert(execCmd(arena, mainCmdObj));
 
     prb_Str mainObjs[] = {mainObjPath, freetype.libFile, sdl.libFile, harfbuzz.libFile, icu.libFile, fribidi.libFile};
     prb_Str mainObjsStr = prb_stringsJoin(arena, mainObjs, prb_arrayCount(mainObjs), prb_STR(" "));
@@ -1244,9 +1243,46 @@ main() {
 #endif
 
     prb_Str mainCmdExe = constructCompileCmd(arena, project, mainFlagsStr, mainObjsStr, mainOutPath, mainLinkFlags);
-    prb_assert(execCmd(arena, mainCmdExe));
 
-    prb_assert(prb_waitForProcesses(&mainHandlePre, 1) == prb_Success);
+    // NOTE(khvorov) Only the link has to wait for the libraries, the main object only needs their headers.
+    // Each library is parallelised already so the main point is to not leave cores idle at the tail of a library
+    {
+        StaticLibInfo* libs[] = {&fribidi, &icu, &freetype, &harfbuzz, &sdl};
+        prb_Job        libJobs[prb_arrayCount(libs)] = {};
+        prb_JobGraph   graph = {};
+
+        prb_writelnToStdout(arena, mainCmdPreprocess);
+        prb_writelnToStdout(arena, mainCmdObj);
+        prb_writelnToStdout(arena, mainCmdExe);
+        prb_Process mainProcs[] = {
+            prb_createProcess(mainCmdPreprocess, (prb_ProcessSpec) {}),
+            prb_createProcess(mainCmdObj, (prb_ProcessSpec) {}),
+            prb_createProcess(mainCmdExe, (prb_ProcessSpec) {}),
+        };
+        prb_jobGraphAddProcess(&graph, mainProcs + 0, 1);
+        i32 mainObjNode = prb_jobGraphAddProcess(&graph, mainProcs + 1, 1);
+        i32 mainExeNode = prb_jobGraphAddProcess(&graph, mainProcs + 2, 1);
+        prb_jobGraphAddDep(&graph, mainExeNode, mainObjNode);
+
+        for (i32 libIndex = 0; libIndex < prb_arrayCount(libs); libIndex++) {
+            libJobs[libIndex] = prb_createJob(compileStaticLib, libs[libIndex], arena, 50 * prb_MEGABYTE);
+            i32 libNode = prb_jobGraphAddJob(&graph, libJobs + libIndex, (float)libs[libIndex]->sourcesCount);
+            prb_jobGraphAddDep(&graph, mainExeNode, libNode);
+        }
+
+        // NOTE(khvorov) One thread runs everything one after the other like before
+        project->pool = prb_createThreadPool(arena, project->tuCompilationMode == prb_Background_Yes ? 0 : 1, 0);
+        prb_assert(prb_runJobGraph(arena, &graph, project->pool));
+        prb_destroyThreadPool(project->pool);
+        prb_destroyJobGraph(&graph);
+        prb_destroyJobserver(arena, &jobserver);
+
+        for (i32 libIndex = 0; libIndex < prb_arrayCount(libs); libIndex++) {
+            prb_assert(libs[libIndex]->compileStatus == prb_ProcessStatus_CompletedSuccess);
+        }
+
+        prb_writelnToStdout(arena, prb_fmt(arena, "total compile: %.2fms", prb_getMsFrom(compileStart)));
+    }
 
     prb_writelnToStdout(arena, prb_fmt(arena, "total: %.2fms", prb_getMsFrom(scriptStartTime)));
     return 0;
@@ -0,0 +1,13 @@
+@echo off
+
+set SCRIPT_DIR=%~dp0
+
+set SHELL_BAT=%SCRIPT_DIR%\shell.bat
+if exist %SHELL_BAT% call %SHELL_BAT%
+
+set BENCH_BIN=%SCRIPT_DIR%\bench.exe
+clang -O2 -Wall -Wextra -Werror -Wfatal-errors %SCRIPT_DIR%\bench.c -o %BENCH_BIN% -Xlinker /incremental:no
+if %ERRORLEVEL% NEQ 0 (
+  EXIT /B
+)
+%BENCH_BIN% %*
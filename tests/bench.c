@@ -0,0 +1,522 @@
+#ifdef _MSC_VER
+#pragma warning(disable : 4464)  // relative include path contains '..'
+#pragma warning(disable : 5045)  // Compiler will insert Spectre mitigation for memory load if /Qspectre switch specified
+#endif
+
+#include "../cbuild.h"
+
+#define function static
+
+typedef int32_t i32;
+
+#if prb_PLATFORM_LINUX
+#include <sys/wait.h>
+#include <semaphore.h>
+
+#ifndef CLONE_VFORK
+#define CLONE_VFORK 0x00004000
+#endif
+
+#ifndef SYS_clone3
+#define SYS_clone3 435
+#endif
+
+// NOTE(khvorov) Same layout as struct clone_args from linux/sched.h (first version), not using the kernel header
+// because it conflicts with the libc one
+typedef struct CloneArgs {
+    uint64_t flags;
+    uint64_t pidfd;
+    uint64_t childTid;
+    uint64_t parentTid;
+    uint64_t exitSignal;
+    uint64_t stack;
+    uint64_t stackSize;
+    uint64_t tls;
+} CloneArgs;
+#endif
+
+function void
+printResult(prb_Arena* arena, prb_Str name, i32 count, float totalMs) {
+    prb_writelnToStdout(arena, prb_fmt(arena, "%-40.*s %8.3fms per spawn (%d spawns)", prb_LIT(name), totalMs / (float)count, count));
+}
+
+// NOTE(khvorov) Lots of PATH entries before the one with the executable, like on a machine with
+// a long PATH on a network filesystem. Every lookup that misses the cache has to look through all of them.
+function void
+bench_executableCache(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+#if prb_PLATFORM_WINDOWS
+    prb_Str exe = prb_STR("cmd /c exit 0");
+    prb_Str pathSep = prb_STR(";");
+#elif prb_PLATFORM_LINUX
+    prb_Str exe = prb_STR("true");
+    prb_Str pathSep = prb_STR(":");
+#else
+#error unimplemented
+#endif
+
+    prb_GetenvResult ogPath = prb_getenv(arena, prb_STR("PATH"));
+    prb_assert(ogPath.found);
+    ogPath.str = prb_fmt(arena, "%.*s", prb_LIT(ogPath.str));
+
+    prb_GrowingStr longPathBuilder = prb_beginStr(arena);
+    for (i32 dirIndex = 0; dirIndex < 64; dirIndex++) {
+        prb_addStrSegment(&longPathBuilder, "/prb_bench_nonexistent/dir%d%.*s", dirIndex, prb_LIT(pathSep));
+    }
+    prb_addStrSegment(&longPathBuilder, "%.*s", prb_LIT(ogPath.str));
+    prb_Str longPath = prb_endStr(&longPathBuilder);
+
+    // NOTE(khvorov) The cache is thrown away whenever PATH changes, so switching between two PATHs that find
+    // the same executable makes every launch search all of it. Both runs set PATH every time to cost the same.
+    prb_Str longPaths[] = {longPath, prb_fmt(arena, "%.*s%.*s/prb_bench_nonexistent/last", prb_LIT(longPath), prb_LIT(pathSep))};
+    i32     spawnCount = 300;
+    for (i32 coldIndex = 0; coldIndex < 2; coldIndex++) {
+        bool          cold = coldIndex == 0;
+        prb_TimeStart start = prb_timeStart();
+        for (i32 spawnIndex = 0; spawnIndex < spawnCount; spawnIndex++) {
+            prb_TempMemory spawnTemp = prb_beginTempMemory(arena);
+            prb_assert(prb_setenv(arena, prb_STR("PATH"), longPaths[cold ? spawnIndex % 2 : 0]));
+            prb_Process proc = prb_createProcess(exe, (prb_ProcessSpec) {});
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+            prb_endTempMemory(spawnTemp);
+        }
+        prb_Str name = cold ? prb_STR("prb_launchProcesses (PATH lookup cold)") : prb_STR("prb_launchProcesses (PATH lookup warm)");
+        printResult(arena, name, spawnCount, prb_getMsFrom(start));
+    }
+
+    prb_assert(prb_setenv(arena, prb_STR("PATH"), ogPath.str));
+    prb_endTempMemory(temp);
+}
+
+typedef enum SpawnMethod {
+    SpawnMethod_LaunchProcesses,
+    SpawnMethod_LaunchProcessesNiced,
+#if prb_PLATFORM_LINUX
+    SpawnMethod_PosixSpawn,
+    SpawnMethod_Vfork,
+    SpawnMethod_Clone3,
+#endif
+    SpawnMethod_Count,
+} SpawnMethod;
+
+typedef struct SpawnSample {
+    // NOTE(khvorov) From the start of the spawn until the parent gets control back
+    float spawnMs;
+    // NOTE(khvorov) From the start of the spawn until the child is reaped
+    float totalMs;
+} SpawnSample;
+
+function prb_Str
+spawnMethodName(SpawnMethod method) {
+    prb_Str result = {};
+    switch (method) {
+        case SpawnMethod_LaunchProcesses: result = prb_STR("prb_launchProcesses"); break;
+        case SpawnMethod_LaunchProcessesNiced: result = prb_STR("prb_launchProcesses nice +1"); break;
+#if prb_PLATFORM_LINUX
+        case SpawnMethod_PosixSpawn: result = prb_STR("posix_spawn"); break;
+        case SpawnMethod_Vfork: result = prb_STR("vfork+execve"); break;
+        case SpawnMethod_Clone3: result = prb_STR("clone3(CLONE_VFORK)+execve"); break;
+#endif
+        case SpawnMethod_Count: prb_assert(!"unreachable"); break;
+    }
+    return result;
+}
+
+#if prb_PLATFORM_LINUX
+
+function pid_t
+spawnVfork(prb_Argv argv, prb_Env env) {
+    pid_t pid = vfork();
+    if (pid == 0) {
+        execve(argv.args[0], (char**)argv.args, (char**)env.entries);
+        _exit(127);
+    }
+    return pid;
+}
+
+// NOTE(khvorov) Without CLONE_VM, since a child sharing our memory needs its own stack and that needs an
+// assembly trampoline like the one in libc. So this is a fork that blocks the parent until exec
+function pid_t
+spawnClone3(prb_Argv argv, prb_Env env) {
+    CloneArgs args = {};
+    args.flags = CLONE_VFORK;
+    args.exitSignal = SIGCHLD;
+    long pid = syscall(SYS_clone3, &args, sizeof(args));
+    if (pid == 0) {
+        execve(argv.args[0], (char**)argv.args, (char**)env.entries);
+        _exit(127);
+    }
+    return (pid_t)pid;
+}
+
+#endif
+
+// NOTE(khvorov) Returns false when the method is not available here (e.g. clone3 blocked by seccomp)
+function bool
+spawnAndWait(prb_Arena* arena, SpawnMethod method, prb_Argv argv, prb_Env* env, SpawnSample* sample) {
+    bool          result = true;
+    prb_TimeStart start = prb_timeStart();
+    switch (method) {
+        case SpawnMethod_LaunchProcesses:
+        case SpawnMethod_LaunchProcessesNiced: {
+            prb_ProcessSpec spec = {};
+            spec.env = env;
+            spec.niceIncrement = method == SpawnMethod_LaunchProcessesNiced ? 1 : 0;
+            prb_Process proc = prb_createProcessArgv(argv, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
+            sample->spawnMs = prb_getMsFrom(start);
+            prb_assert(prb_waitForProcesses(&proc, 1));
+        } break;
+
+#if prb_PLATFORM_LINUX
+        case SpawnMethod_PosixSpawn:
+        case SpawnMethod_Vfork:
+        case SpawnMethod_Clone3: {
+            pid_t pid = -1;
+            switch (method) {
+                case SpawnMethod_PosixSpawn: {
+                    if (posix_spawn(&pid, argv.args[0], 0, 0, (char**)argv.args, (char**)env->entries) != 0) {
+                        pid = -1;
+                    }
+                } break;
+                case SpawnMethod_Vfork: pid = spawnVfork(argv, *env); break;
+                case SpawnMethod_Clone3: pid = spawnClone3(argv, *env); break;
+                default: prb_assert(!"unreachable"); break;
+            }
+            sample->spawnMs = prb_getMsFrom(start);
+            result = pid > 0;
+            if (result) {
+                int status = 0;
+                prb_assert(waitpid(pid, &status, 0) == pid);
+                prb_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+            }
+        } break;
+#endif
+
+        case SpawnMethod_Count: prb_assert(!"unreachable"); break;
+    }
+    sample->totalMs = prb_getMsFrom(start);
+    return result;
+}
+
+function int
+compareFloats(const void* lhs, const void* rhs) {
+    float l = *(const float*)lhs;
+    float r = *(const float*)rhs;
+    int   result = (l > r) - (l < r);
+    return result;
+}
+
+function float
+percentile(float* sorted, i32 count, i32 percent) {
+    i32   index = (i32)((int64_t)(count - 1) * percent / 100);
+    float result = sorted[index];
+    return result;
+}
+
+// NOTE(khvorov) Spawns a process that does nothing over and over so that all of the time is spent
+// in the spawn itself. Big argument lists and environments have to be copied into the child, big ones
+// show how much that costs
+function void
+bench_spawn(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    // NOTE(khvorov) Full path so that none of the methods spend time looking through PATH
+#if prb_PLATFORM_WINDOWS
+    prb_Argv baseArgv = prb_createArgv(arena, prb_STR("cmd /c exit 0"));
+#elif prb_PLATFORM_LINUX
+    prb_Argv baseArgv = prb_createArgv(arena, prb_STR("true"));
+#else
+#error unimplemented
+#endif
+    {
+        prb_FindExecutableResult exe = prb_findExecutable(arena, prb_STR(baseArgv.args[0]));
+        prb_assert(exe.found);
+        baseArgv.args[0] = prb_strGetNullTerminated(arena, exe.path);
+    }
+
+    i32 sizesKb[] = {0, 4, 128};
+    i32 entrySize = 1024;
+    i32 spawnCount = 200;
+
+    // NOTE(khvorov) CreateProcess doesn't take command lines longer than 32767 characters
+#if prb_PLATFORM_WINDOWS
+    i32 maxArgKb = 31;
+#elif prb_PLATFORM_LINUX
+    i32 maxArgKb = INT32_MAX;
+#else
+#error unimplemented
+#endif
+
+    prb_writelnToStdout(arena, prb_fmt(arena, "%-28s %6s %6s %9s %9s %9s %9s %9s %10s", "method", "argKb", "envKb", "p50ms", "p90ms", "p99ms", "maxms", "waitp50ms", "spawns/s"));
+
+    SpawnSample* samples = prb_arenaAllocArray(arena, SpawnSample, spawnCount);
+    float*       spawnMs = prb_arenaAllocArray(arena, float, spawnCount);
+    float*       totalMs = prb_arenaAllocArray(arena, float, spawnCount);
+    for (i32 argSizeIndex = 0; argSizeIndex < prb_arrayCount(sizesKb); argSizeIndex++) {
+        i32 argSizeKb = sizesKb[argSizeIndex];
+        if (argSizeKb > maxArgKb) {
+            prb_writelnToStdout(arena, prb_fmt(arena, "%-28s %6d skipped, over the command line limit", "all", argSizeKb));
+            continue;
+        }
+        for (i32 envSizeIndex = 0; envSizeIndex < prb_arrayCount(sizesKb); envSizeIndex++) {
+            i32            envSizeKb = sizesKb[envSizeIndex];
+            prb_TempMemory configTemp = prb_beginTempMemory(arena);
+
+            // NOTE(khvorov) Split into 1kb pieces, a real command line is lots of short arguments
+            prb_Str  filler = prb_fmt(arena, "%0*d", entrySize - 32, 0);
+            prb_Str* extraArgs = 0;
+            for (i32 argIndex = 0; argIndex < argSizeKb; argIndex++) {
+                arrput(extraArgs, prb_fmt(arena, "--arg%d=%.*s", argIndex, prb_LIT(filler)));
+            }
+            prb_Argv argv = prb_argvConcat(arena, baseArgv, extraArgs, (i32)arrlen(extraArgs));
+            arrfree(extraArgs);
+
+            prb_GrowingStr addEnv = prb_beginStr(arena);
+            for (i32 envIndex = 0; envIndex < envSizeKb; envIndex++) {
+                prb_addStrSegment(&addEnv, "PRB_BENCH_VAR%d=%.*s ", envIndex, prb_LIT(filler));
+            }
+            prb_Env env = prb_createEnv(arena, prb_endStr(&addEnv));
+            prb_assert(env.valid);
+
+            for (SpawnMethod method = (SpawnMethod)0; method < SpawnMethod_Count; method = (SpawnMethod)(method + 1)) {
+                bool          available = true;
+                prb_TimeStart start = prb_timeStart();
+                for (i32 spawnIndex = 0; spawnIndex < spawnCount && available; spawnIndex++) {
+                    prb_TempMemory spawnTemp = prb_beginTempMemory(arena);
+                    available = spawnAndWait(arena, method, argv, &env, samples + spawnIndex);
+                    prb_endTempMemory(spawnTemp);
+                }
+                float elapsedMs = prb_getMsFrom(start);
+
+                prb_Str name = spawnMethodName(method);
+                if (available) {
+                    for (i32 sampleIndex = 0; sampleIndex < spawnCount; sampleIndex++) {
+                        spawnMs[sampleIndex] = samples[sampleIndex].spawnMs;
+                        totalMs[sampleIndex] = samples[sampleIndex].totalMs;
+                    }
+                    qsort(spawnMs, (size_t)spawnCount, sizeof(*spawnMs), compareFloats);
+                    qsort(totalMs, (size_t)spawnCount, sizeof(*totalMs), compareFloats);
+                    prb_writelnToStdout(
+                        arena,
+                        prb_fmt(
+                            arena,
+                            "%-28.*s %6d %6d %9.3f %9.3f %9.3f %9.3f %9.3f %10.0f",
+                            prb_LIT(name),
+                            argSizeKb,
+                            envSizeKb,
+                            percentile(spawnMs, spawnCount, 50),
+                            percentile(spawnMs, spawnCount, 90),
+                            percentile(spawnMs, spawnCount, 99),
+                            spawnMs[spawnCount - 1],
+                            percentile(totalMs, spawnCount, 50),
+                            (float)spawnCount / elapsedMs * 1000.0f
+                        )
+                    );
+                } else {
+                    prb_writelnToStdout(arena, prb_fmt(arena, "%-28.*s %6d %6d unavailable", prb_LIT(name), argSizeKb, envSizeKb));
+                }
+            }
+
+            prb_endTempMemory(configTemp);
+        }
+    }
+
+    // NOTE(khvorov) Throughput with as many processes in flight as there are cores, the way a build runs
+    {
+        i32          poolCount = 1000;
+        prb_Process* procs = prb_arenaAllocArray(arena, prb_Process, poolCount);
+        for (i32 procIndex = 0; procIndex < poolCount; procIndex++) {
+            procs[procIndex] = prb_createProcessArgv(baseArgv, (prb_ProcessSpec) {});
+        }
+        prb_TimeStart start = prb_timeStart();
+        prb_assert(prb_launchProcessPool(arena, procs, poolCount, (prb_ProcessPoolSpec) {}));
+        float elapsedMs = prb_getMsFrom(start);
+        prb_writelnToStdout(arena, prb_fmt(arena, "prb_launchProcessPool %d processes: %.0f spawns/s", poolCount, (float)poolCount / elapsedMs * 1000.0f));
+    }
+
+    prb_endTempMemory(temp);
+}
+
+function void
+emptyJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    prb_unused(data);
+}
+
+// NOTE(khvorov) Fine-grained jobs, thread per job against the pool
+function void
+bench_jobs(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    i32      jobCount = 10000;
+    prb_Job* jobs = prb_arenaAllocArray(arena, prb_Job, jobCount);
+
+    {
+        for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            jobs[jobIndex] = prb_createJob(emptyJob, 0, arena, 0);
+        }
+        prb_TimeStart start = prb_timeStart();
+        prb_assert(prb_launchJobs(jobs, jobCount, prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, jobCount));
+        float elapsedMs = prb_getMsFrom(start);
+        prb_writelnToStdout(arena, prb_fmt(arena, "thread per job %d jobs: %.0f jobs/s", jobCount, (float)jobCount / elapsedMs * 1000.0f));
+    }
+
+    {
+        prb_ThreadPool* pool = prb_createThreadPool(arena, 0, 0);
+        prb_assert(pool->valid);
+        for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            jobs[jobIndex] = prb_createJob(emptyJob, 0, arena, 0);
+            jobs[jobIndex].pool = pool;
+        }
+        prb_TimeStart start = prb_timeStart();
+        prb_assert(prb_launchJobs(jobs, jobCount, prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, jobCount));
+        float elapsedMs = prb_getMsFrom(start);
+        prb_writelnToStdout(arena, prb_fmt(arena, "prb_ThreadPool (%d threads) %d jobs: %.0f jobs/s", pool->workerCount, jobCount, (float)jobCount / elapsedMs * 1000.0f));
+        prb_destroyThreadPool(pool);
+    }
+
+    prb_endTempMemory(temp);
+}
+
+typedef struct ContendedData {
+    prb_Mutex* mutex;
+#if prb_PLATFORM_LINUX
+    pthread_mutex_t* pmutex;
+#endif
+    i32* counter;
+    i32  iterations;
+} ContendedData;
+
+function void
+contendedMutexJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    ContendedData* job = (ContendedData*)data;
+    for (i32 index = 0; index < job->iterations; index++) {
+        prb_mutexLock(job->mutex);
+        *job->counter += 1;
+        prb_mutexUnlock(job->mutex);
+    }
+}
+
+#if prb_PLATFORM_LINUX
+function void
+contendedPthreadJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    ContendedData* job = (ContendedData*)data;
+    for (i32 index = 0; index < job->iterations; index++) {
+        pthread_mutex_lock(job->pmutex);
+        *job->counter += 1;
+        pthread_mutex_unlock(job->pmutex);
+    }
+}
+#endif
+
+function void
+printNsPerOp(prb_Arena* arena, prb_Str name, i32 count, float totalMs) {
+    prb_writelnToStdout(arena, prb_fmt(arena, "%-40.*s %8.2fns per op (%d ops)", prb_LIT(name), totalMs * 1000000.0f / (float)count, count));
+}
+
+function void
+bench_sync(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    i32 opCount = 10000000;
+
+    {
+        prb_Mutex     mutex = {};
+        prb_TimeStart start = prb_timeStart();
+        for (i32 index = 0; index < opCount; index++) {
+            prb_mutexLock(&mutex);
+            prb_mutexUnlock(&mutex);
+        }
+        printNsPerOp(arena, prb_STR("prb_Mutex uncontended"), opCount, prb_getMsFrom(start));
+    }
+
+#if prb_PLATFORM_LINUX
+    {
+        pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+        prb_TimeStart   start = prb_timeStart();
+        for (i32 index = 0; index < opCount; index++) {
+            pthread_mutex_lock(&mutex);
+            pthread_mutex_unlock(&mutex);
+        }
+        printNsPerOp(arena, prb_STR("pthread_mutex uncontended"), opCount, prb_getMsFrom(start));
+    }
+#endif
+
+    {
+        prb_Semaphore sem = prb_createSemaphore(0);
+        prb_TimeStart start = prb_timeStart();
+        for (i32 index = 0; index < opCount; index++) {
+            prb_semaphorePost(&sem, 1);
+            prb_semaphoreWait(&sem);
+        }
+        printNsPerOp(arena, prb_STR("prb_Semaphore post+wait"), opCount, prb_getMsFrom(start));
+    }
+
+#if prb_PLATFORM_LINUX
+    {
+        sem_t sem = {};
+        prb_assert(sem_init(&sem, 0, 0) == 0);
+        prb_TimeStart start = prb_timeStart();
+        for (i32 index = 0; index < opCount; index++) {
+            sem_post(&sem);
+            sem_wait(&sem);
+        }
+        printNsPerOp(arena, prb_STR("sem_t post+wait"), opCount, prb_getMsFrom(start));
+        sem_destroy(&sem);
+    }
+#endif
+
+    // NOTE(khvorov) Threads fighting over one counter, this is where the futex waits and wakes show up
+    {
+        i32           threadCount = 4;
+        i32           counter = 0;
+        prb_Mutex     mutex = {};
+        ContendedData data = {};
+        data.mutex = &mutex;
+        data.counter = &counter;
+        data.iterations = opCount / threadCount / 10;
+        prb_Job* jobs = prb_arenaAllocArray(arena, prb_Job, threadCount);
+
+        for (i32 jobIndex = 0; jobIndex < threadCount; jobIndex++) {
+            jobs[jobIndex] = prb_createJob(contendedMutexJob, &data, arena, 0);
+        }
+        prb_TimeStart start = prb_timeStart();
+        prb_assert(prb_launchJobs(jobs, threadCount, prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, threadCount));
+        printNsPerOp(arena, prb_fmt(arena, "prb_Mutex contended (%d threads)", threadCount), counter, prb_getMsFrom(start));
+
+#if prb_PLATFORM_LINUX
+        pthread_mutex_t pmutex = PTHREAD_MUTEX_INITIALIZER;
+        data.pmutex = &pmutex;
+        counter = 0;
+        for (i32 jobIndex = 0; jobIndex < threadCount; jobIndex++) {
+            jobs[jobIndex] = prb_createJob(contendedPthreadJob, &data, arena, 0);
+        }
+        start = prb_timeStart();
+        prb_assert(prb_launchJobs(jobs, threadCount, prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, threadCount));
+        printNsPerOp(arena, prb_fmt(arena, "pthread_mutex contended (%d threads)", threadCount), counter, prb_getMsFrom(start));
+#endif
+    }
+
+    prb_endTempMemory(temp);
+}
+
+int
+main(void) {
+    prb_Arena  arena_ = prb_createArenaFromVmem(1 * prb_GIGABYTE);
+    prb_Arena* arena = &arena_;
+
+    bench_executableCache(arena);
+    bench_spawn(arena);
+    bench_jobs(arena);
+    bench_sync(arena);
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+SCRIPT_DIR=$(dirname "$0")
+BENCH_BIN=$SCRIPT_DIR/bench.bin
+clang -O2 -Wall -Wextra -Werror -Wfatal-errors $SCRIPT_DIR/bench.c -o $BENCH_BIN -lpthread && $BENCH_BIN $@
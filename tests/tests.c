@@ -66,10 +66,78 @@ testNameToPrbName(prb_Arena* arena, prb_Str testName, prb_Str** prbNames) {
         arrput(*prbNames, prb_STR("prb_launchProcesses"));
         arrput(*prbNames, prb_STR("prb_waitForProcesses"));
         arrput(*prbNames, prb_STR("prb_killProcesses"));
+    } else if (prb_streq(testName, prb_STR("test_processCompletionIter"))) {
+        arrput(*prbNames, prb_STR("prb_createProcessCompletionIter"));
+        arrput(*prbNames, prb_STR("prb_processCompletionIterNext"));
+        arrput(*prbNames, prb_STR("prb_destroyProcessCompletionIter"));
+    } else if (prb_streq(testName, prb_STR("test_workerPool"))) {
+        arrput(*prbNames, prb_STR("prb_createWorkerPool"));
+        arrput(*prbNames, prb_STR("prb_runWorkerJobs"));
+        arrput(*prbNames, prb_STR("prb_destroyWorkerPool"));
+        arrput(*prbNames, prb_STR("prb_readWorkerRequest"));
+        arrput(*prbNames, prb_STR("prb_writeWorkerResponse"));
+    } else if (prb_streq(testName, prb_STR("test_jobserver"))) {
+        arrput(*prbNames, prb_STR("prb_createJobserver"));
+        arrput(*prbNames, prb_STR("prb_connectJobserver"));
+        arrput(*prbNames, prb_STR("prb_jobserverAcquire"));
+        arrput(*prbNames, prb_STR("prb_jobserverTryAcquire"));
+        arrput(*prbNames, prb_STR("prb_jobserverRelease"));
+        arrput(*prbNames, prb_STR("prb_destroyJobserver"));
+    } else if (prb_streq(testName, prb_STR("test_hashStream"))) {
+        arrput(*prbNames, prb_STR("prb_createHashStream"));
+        arrput(*prbNames, prb_STR("prb_hashStreamAdd"));
+        arrput(*prbNames, prb_STR("prb_hashStreamEnd"));
+    } else if (prb_streq(testName, prb_STR("test_atomics"))) {
+        arrput(*prbNames, prb_STR("prb_atomicLoadI32"));
+        arrput(*prbNames, prb_STR("prb_atomicStoreI32"));
+        arrput(*prbNames, prb_STR("prb_atomicExchangeI32"));
+        arrput(*prbNames, prb_STR("prb_atomicCasI32"));
+        arrput(*prbNames, prb_STR("prb_atomicFetchAddI32"));
+        arrput(*prbNames, prb_STR("prb_atomicLoadI64"));
+        arrput(*prbNames, prb_STR("prb_atomicStoreI64"));
+        arrput(*prbNames, prb_STR("prb_atomicExchangeI64"));
+        arrput(*prbNames, prb_STR("prb_atomicCasI64"));
+        arrput(*prbNames, prb_STR("prb_atomicFetchAddI64"));
+        arrput(*prbNames, prb_STR("prb_atomicLoadPtr"));
+        arrput(*prbNames, prb_STR("prb_atomicStorePtr"));
+        arrput(*prbNames, prb_STR("prb_atomicExchangePtr"));
+        arrput(*prbNames, prb_STR("prb_atomicCasPtr"));
+        arrput(*prbNames, prb_STR("prb_atomicFence"));
+    } else if (prb_streq(testName, prb_STR("test_mpmcQueue"))) {
+        arrput(*prbNames, prb_STR("prb_createMpmcQueue"));
+        arrput(*prbNames, prb_STR("prb_mpmcQueuePush"));
+        arrput(*prbNames, prb_STR("prb_mpmcQueuePop"));
+    } else if (prb_streq(testName, prb_STR("test_mutex"))) {
+        arrput(*prbNames, prb_STR("prb_mutexLock"));
+        arrput(*prbNames, prb_STR("prb_mutexTryLock"));
+        arrput(*prbNames, prb_STR("prb_mutexUnlock"));
+    } else if (prb_streq(testName, prb_STR("test_semaphore"))) {
+        arrput(*prbNames, prb_STR("prb_createSemaphore"));
+        arrput(*prbNames, prb_STR("prb_semaphoreWait"));
+        arrput(*prbNames, prb_STR("prb_semaphoreTryWait"));
+        arrput(*prbNames, prb_STR("prb_semaphorePost"));
+    } else if (prb_streq(testName, prb_STR("test_event"))) {
+        arrput(*prbNames, prb_STR("prb_eventSet"));
+        arrput(*prbNames, prb_STR("prb_eventReset"));
+        arrput(*prbNames, prb_STR("prb_eventWait"));
+        arrput(*prbNames, prb_STR("prb_eventIsSet"));
+    } else if (prb_streq(testName, prb_STR("test_latch"))) {
+        arrput(*prbNames, prb_STR("prb_createLatch"));
+        arrput(*prbNames, prb_STR("prb_latchCountDown"));
+        arrput(*prbNames, prb_STR("prb_latchWait"));
     } else if (prb_streq(testName, prb_STR("test_jobs"))) {
         arrput(*prbNames, prb_STR("prb_createJob"));
         arrput(*prbNames, prb_STR("prb_launchJobs"));
         arrput(*prbNames, prb_STR("prb_waitForJobs"));
+    } else if (prb_streq(testName, prb_STR("test_threadPool"))) {
+        arrput(*prbNames, prb_STR("prb_createThreadPool"));
+        arrput(*prbNames, prb_STR("prb_destroyThreadPool"));
+    } else if (prb_streq(testName, prb_STR("test_jobGraph"))) {
+        arrput(*prbNames, prb_STR("prb_jobGraphAddJob"));
+        arrput(*prbNames, prb_STR("prb_jobGraphAddProcess"));
+        arrput(*prbNames, prb_STR("prb_jobGraphAddDep"));
+        arrput(*prbNames, prb_STR("prb_runJobGraph"));
+        arrput(*prbNames, prb_STR("prb_destroyJobGraph"));
     } else if (prb_streq(testName, prb_STR("test_getAllDirEntries"))) {
         arrput(*prbNames, prb_STR("prb_getAllDirEntriesCustomBuffer"));
         arrput(*prbNames, prb_STR("prb_getAllDirEntries"));
@@ -1189,6 +1257,39 @@ test_getFileHash(prb_Arena* arena) {
     prb_endTempMemory(temp);
 }
 
+function void
+test_hashStream(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    // NOTE(khvorov) Every length around the word size and the 4 and 8 byte special cases, added in pieces of every size
+    i32      dataLen = 100;
+    uint8_t* data = prb_arenaAllocArray(arena, uint8_t, dataLen);
+    for (i32 byteIndex = 0; byteIndex < dataLen; byteIndex++) {
+        data[byteIndex] = (uint8_t)(byteIndex * 37 + 0x80);
+    }
+    for (i32 len = 0; len <= dataLen; len++) {
+        uint64_t expected = prb_stbds_hash_bytes(data, (size_t)len, 1);
+        for (i32 pieceLen = 1; pieceLen <= 17; pieceLen++) {
+            prb_HashStream stream = prb_createHashStream();
+            for (i32 offset = 0; offset < len; offset += pieceLen) {
+                prb_hashStreamAdd(&stream, data + offset, prb_min(pieceLen, len - offset));
+            }
+            prb_assert(prb_hashStreamEnd(&stream) == expected);
+        }
+    }
+
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_Str        filepath = prb_pathJoin(arena, dir, prb_STR("file.txt"));
+    prb_assert(prb_clearDir(arena, dir));
+    prb_assert(prb_writeEntireFile(arena, filepath, data, dataLen));
+    prb_HashStream stream = prb_createHashStream();
+    prb_hashStreamAdd(&stream, data, dataLen);
+    prb_assert(prb_hashStreamEnd(&stream) == prb_getFileHash(arena, filepath).hash);
+    prb_assert(prb_removePathIfExists(arena, dir));
+
+    prb_endTempMemory(temp);
+}
+
 //
 // SECTION Strings
 //
@@ -2386,6 +2487,163 @@ test_getArgArrayFromStr(prb_Arena* arena) {
     prb_endTempMemory(temp);
 }
 
+function void
+test_createArgv(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    {
+        prb_Argv argv = prb_createArgv(arena, prb_STR("  prg arg1\targ2  arg3 "));
+        prb_assert(argv.len == 4);
+        prb_assert(prb_streq(prb_STR(argv.args[0]), prb_STR("prg")));
+        prb_assert(prb_streq(prb_STR(argv.args[1]), prb_STR("arg1")));
+        prb_assert(prb_streq(prb_STR(argv.args[2]), prb_STR("arg2")));
+        prb_assert(prb_streq(prb_STR(argv.args[3]), prb_STR("arg3")));
+        prb_assert(argv.args[4] == 0);
+    }
+
+    {
+        prb_Argv argv = prb_createArgv(arena, prb_STR("prg \"arg 1\" 'arg \"2\"' -D\"X=a b\" \"\" \"q\\\"\\\\\" C:\\dir\\file"));
+        prb_assert(argv.len == 7);
+        prb_assert(prb_streq(prb_STR(argv.args[1]), prb_STR("arg 1")));
+        prb_assert(prb_streq(prb_STR(argv.args[2]), prb_STR("arg \"2\"")));
+        prb_assert(prb_streq(prb_STR(argv.args[3]), prb_STR("-DX=a b")));
+        prb_assert(prb_streq(prb_STR(argv.args[4]), prb_STR("")));
+        prb_assert(prb_streq(prb_STR(argv.args[5]), prb_STR("q\"\\")));
+        prb_assert(prb_streq(prb_STR(argv.args[6]), prb_STR("C:\\dir\\file")));
+        prb_assert(argv.args[7] == 0);
+    }
+
+    {
+        prb_Argv argv = prb_createArgv(arena, prb_STR("   "));
+        prb_assert(argv.len == 0);
+        prb_assert(argv.args[0] == 0);
+    }
+
+    prb_endTempMemory(temp);
+}
+
+function void
+test_argvConcat(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    prb_Argv prefix = prb_createArgv(arena, prb_STR("clang -c -Wall"));
+    prb_Str  tu1Args[] = {prb_STR("-o"), prb_STR("one.o"), prb_STR("one file.c")};
+    prb_Argv tu1 = prb_argvConcat(arena, prefix, tu1Args, prb_arrayCount(tu1Args));
+    prb_Str  tu2Args[] = {prb_STR("two.c")};
+    prb_Argv tu2 = prb_argvConcat(arena, prefix, tu2Args, prb_arrayCount(tu2Args));
+
+    prb_assert(tu1.len == 6 && tu1.args[6] == 0);
+    prb_assert(tu2.len == 4 && tu2.args[4] == 0);
+    for (i32 argIndex = 0; argIndex < prefix.len; argIndex++) {
+        prb_assert(tu1.args[argIndex] == prefix.args[argIndex]);
+        prb_assert(tu2.args[argIndex] == prefix.args[argIndex]);
+    }
+    prb_assert(prb_streq(prb_STR(tu1.args[5]), prb_STR("one file.c")));
+    prb_assert(prb_streq(prb_STR(tu2.args[3]), prb_STR("two.c")));
+    prb_assert(prefix.len == 3 && prefix.args[3] == 0);
+
+    prb_Argv same = prb_argvConcat(arena, prefix, 0, 0);
+    prb_assert(same.len == 3 && same.args[3] == 0);
+
+    prb_endTempMemory(temp);
+}
+
+function void
+test_argvToStr(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    prb_Str  args[] = {prb_STR("prg"), prb_STR("a b"), prb_STR(""), prb_STR("q\"\\"), prb_STR("C:\\dir")};
+    prb_Argv argv = prb_argvConcat(arena, (prb_Argv) {}, args, prb_arrayCount(args));
+    prb_Str  str = prb_argvToStr(arena, argv);
+    prb_assert(prb_streq(str, prb_STR("prg \"a b\" \"\" \"q\\\"\\\\\" C:\\dir")));
+
+    prb_Argv roundTrip = prb_createArgv(arena, str);
+    prb_assert(roundTrip.len == argv.len);
+    for (i32 argIndex = 0; argIndex < argv.len; argIndex++) {
+        prb_assert(prb_streq(prb_STR(roundTrip.args[argIndex]), prb_STR(argv.args[argIndex])));
+    }
+
+    prb_endTempMemory(temp);
+}
+
+function void
+test_findExecutable(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    {
+        prb_FindExecutableResult clang = prb_findExecutable(arena, prb_STR("clang"));
+        prb_assert(clang.found);
+        prb_assert(prb_isFile(arena, clang.path));
+        prb_FindExecutableResult again = prb_findExecutable(arena, prb_STR("clang"));
+        prb_assert(again.found && prb_streq(again.path, clang.path));
+    }
+
+    prb_assert(!prb_findExecutable(arena, prb_STR("prb_not_an_executable_anywhere")).found);
+    prb_assert(!prb_findExecutable(arena, prb_STR("")).found);
+
+    prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("prb_test_find_exe.c"));
+    prb_Str prog = prb_STR("int main() {return 0;}");
+    prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+#if prb_PLATFORM_WINDOWS
+    prb_Str progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+    prb_Str pathSep = prb_STR(";");
+#elif prb_PLATFORM_LINUX
+    prb_Str progExe = prb_pathJoin(arena, dir, prb_STR("prb_test_find_exe"));
+    prb_Str pathSep = prb_STR(":");
+#else
+#error unimplemented
+#endif
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+    prb_assert(prb_findExecutable(arena, progExe).found);
+
+    // NOTE(khvorov) Changing PATH makes the new executable visible
+    prb_GetenvResult ogPath = prb_getenv(arena, prb_STR("PATH"));
+    prb_assert(ogPath.found);
+    ogPath.str = prb_fmt(arena, "%.*s", prb_LIT(ogPath.str));
+    prb_assert(!prb_findExecutable(arena, prb_STR("prb_test_find_exe")).found);
+    prb_assert(prb_setenv(arena, prb_STR("PATH"), prb_fmt(arena, "%.*s%.*s%.*s", prb_LIT(dir), prb_LIT(pathSep), prb_LIT(ogPath.str))));
+    {
+        prb_FindExecutableResult exe = prb_findExecutable(arena, prb_STR("prb_test_find_exe"));
+        prb_assert(exe.found);
+        prb_assert(prb_streq(prb_getAbsolutePath(arena, exe.path), prb_getAbsolutePath(arena, progExe)));
+
+        prb_Process proc = prb_createProcess(prb_STR("prb_test_find_exe"), (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+    }
+
+    // NOTE(khvorov) Cached path that no longer exists
+    prb_assert(prb_removePathIfExists(arena, progExe));
+    prb_assert(!prb_findExecutable(arena, prb_STR("prb_test_find_exe")).found);
+    {
+        prb_Process proc = prb_createProcess(prb_STR("prb_test_find_exe"), (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+    }
+
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) Scripts without a shebang go through the shell, with their arguments
+    {
+        prb_Str scriptPath = prb_pathJoin(arena, dir, prb_STR("prb_test_script"));
+        prb_Str script = prb_STR("exit $1\n");
+        prb_assert(prb_writeEntireFile(arena, scriptPath, script.ptr, script.len));
+        prb_assert(chmod(prb_strGetNullTerminated(arena, scriptPath), 0755) == 0);
+
+        prb_Process proc = prb_createProcess(prb_STR("prb_test_script 0"), (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+        proc = prb_createProcess(prb_STR("prb_test_script 3"), (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+        prb_assert(proc.status == prb_ProcessStatus_CompletedFailed);
+    }
+#endif
+
+    prb_assert(prb_setenv(arena, prb_STR("PATH"), ogPath.str));
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
 function void
 test_executionOnCores(prb_Arena* arena) {
     prb_TempMemory temp = prb_beginTempMemory(arena);
@@ -2419,6 +2677,34 @@ test_executionOnCores(prb_Arena* arena) {
     prb_endTempMemory(temp);
 }
 
+#if prb_PLATFORM_LINUX
+// NOTE(khvorov) Fields are numbered like in proc(5), counting starts after the name in parens at field 3
+function i32
+parseProcStatField(prb_Str stat, i32 field) {
+    prb_StrFindSpec parenSpec = {};
+    parenSpec.pattern = prb_STR(")");
+    parenSpec.direction = prb_StrDirection_FromEnd;
+    prb_StrFindResult paren = prb_strFind(stat, parenSpec);
+    prb_assert(paren.found);
+    prb_StrScanner  scanner = prb_createStrScanner(prb_strTrim(paren.afterMatch));
+    prb_StrFindSpec spaceSpec = {};
+    spaceSpec.pattern = prb_STR(" ");
+    spaceSpec.alwaysMatchEnd = true;
+    for (i32 fieldIndex = 3; fieldIndex <= field; fieldIndex++) {
+        prb_assert(prb_strScannerMove(&scanner, spaceSpec, prb_StrScannerSide_AfterMatch));
+    }
+    prb_Str value = scanner.betweenLastMatches;
+    bool    negative = prb_strStartsWith(value, prb_STR("-"));
+    if (negative) {
+        value = prb_strSlice(value, 1, value.len);
+    }
+    prb_ParseUintResult number = prb_parseUint(value, 10);
+    prb_assert(number.success);
+    i32 result = negative ? -(i32)number.number : (i32)number.number;
+    return result;
+}
+#endif
+
 function void
 test_process(prb_Arena* arena) {
     prb_TempMemory temp = prb_beginTempMemory(arena);
@@ -2520,7 +2806,331 @@ test_process(prb_Arena* arena) {
             prb_assert(readRes.success);
             prb_assert(prb_streq(prb_strFromBytes(readRes.content), prb_fmt(arena, "hello world%.*sstderrout%.*s", prb_LIT(lineBreak), prb_LIT(lineBreak))));
         }
+
+#if prb_PLATFORM_LINUX
+        {
+            prb_ProcessSpec spec;
+            prb_memset(&spec, 0, sizeof(spec));
+            spec.captureStdout = true;
+            spec.captureStderr = true;
+            spec.captureArena = arena;
+            prb_Process proc = prb_createProcess(helloExe, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+            prb_assert(prb_streq(proc.capturedStdout, prb_STR("hello world\n")));
+            prb_assert(prb_streq(proc.capturedStderr, prb_STR("stderrout\n")));
+            prb_assert(proc.capturedStdout.ptr[proc.capturedStdout.len] == '\0');
+        }
+
+        {
+            prb_ProcessSpec spec;
+            prb_memset(&spec, 0, sizeof(spec));
+            spec.captureStdout = true;
+            spec.captureArena = arena;
+            spec.redirectStdout = true;
+            spec.stdoutFilepath = prb_pathJoin(arena, dir, prb_STR("notcreated.txt"));
+            spec.redirectStderr = true;
+            prb_Process proc = prb_createProcess(helloExe, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+            prb_assert(prb_streq(proc.capturedStdout, prb_STR("hello world\n")));
+            prb_assert(proc.capturedStderr.ptr == 0);
+            prb_assert(!prb_isFile(arena, spec.stdoutFilepath));
+        }
+#endif
+    }
+
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) Output that doesn't fit in a pipe buffer from several processes at once
+    {
+        prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("bigoutput.c"));
+        prb_Str prog = prb_STR(
+            "#include <stdio.h>\n"
+            "int main() {\n"
+            "for (int i = 0; i < 100000; i++) {printf(\"%d\\n\", i); fprintf(stderr, \"e%d\\n\", i);}\n"
+            "return 0;\n"
+            "}"
+        );
+        prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+        prb_Str progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+        prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), nullSpec);
+        prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+        prb_GrowingStr expectedOut = prb_beginStr(arena);
+        for (int32_t ind = 0; ind < 100000; ind++) {
+            prb_addStrSegment(&expectedOut, "%d\n", ind);
+        }
+        prb_Str expectedOutStr = prb_endStr(&expectedOut);
+
+        prb_ProcessSpec spec;
+        prb_memset(&spec, 0, sizeof(spec));
+        spec.captureStdout = true;
+        spec.captureStderr = true;
+        spec.captureArena = arena;
+        prb_Process procs[3] = {};
+        for (int32_t procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            procs[procIndex] = prb_createProcess(progExe, spec);
+        }
+
+        prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+        prb_assert(prb_waitForProcesses(procs, prb_arrayCount(procs)));
+        for (int32_t procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            prb_assert(prb_streq(procs[procIndex].capturedStdout, expectedOutStr));
+            prb_assert(procs[procIndex].capturedStderr.len == expectedOutStr.len + 100000);
+        }
+
+        for (int32_t procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            procs[procIndex] = prb_createProcess(progExe, spec);
+        }
+        prb_ProcessPoolSpec poolSpec = {};
+        poolSpec.maxInFlight = 2;
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), poolSpec));
+        for (int32_t procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            prb_assert(prb_streq(procs[procIndex].capturedStdout, expectedOutStr));
+        }
+    }
+#endif
+
+    // NOTE(khvorov) Stdin from memory
+#if prb_PLATFORM_LINUX
+    {
+        prb_Str source = prb_STR("int main() {return 3;}");
+        prb_Str exe = prb_pathJoin(arena, dir, prb_STR("fromstdin.exe"));
+        prb_ProcessSpec spec = {};
+        spec.feedStdin = true;
+        spec.stdinBytes = (prb_Bytes) {(uint8_t*)source.ptr, source.len};
+        prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang -x c - -o %.*s", prb_LIT(exe)), spec);
+        prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+        prb_Process proc = prb_createProcess(exe, nullSpec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+    }
+
+    // NOTE(khvorov) Several processes whose input and output don't fit in a pipe buffer at the same time
+    {
+        i32      inputLen = 300 * 1024;
+        uint8_t* input = prb_arenaAllocArray(arena, uint8_t, inputLen);
+        for (i32 byteIndex = 0; byteIndex < inputLen; byteIndex++) {
+            input[byteIndex] = (uint8_t)('a' + byteIndex % 26);
+        }
+
+        prb_ProcessSpec spec = {};
+        spec.feedStdin = true;
+        spec.stdinBytes = (prb_Bytes) {input, inputLen};
+        spec.captureStdout = true;
+        spec.captureArena = arena;
+        prb_Process procs[3];
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            procs[procIndex] = prb_createProcess(prb_STR("cat"), spec);
+        }
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), (prb_ProcessPoolSpec) {}));
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            prb_assert(prb_streq(procs[procIndex].capturedStdout, (prb_Str) {(const char*)input, inputLen}));
+        }
+
+        prb_Process proc = prb_createProcess(prb_STR("cat"), spec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+        prb_assert(prb_streq(proc.capturedStdout, (prb_Str) {(const char*)input, inputLen}));
+
+        // NOTE(khvorov) Children that don't read their input must not take us down with SIGPIPE
+        prb_ProcessSpec ignoreSpec = {};
+        ignoreSpec.feedStdin = true;
+        ignoreSpec.stdinBytes = spec.stdinBytes;
+        prb_Process ignoreProc = prb_createProcess(prb_STR("true"), ignoreSpec);
+        prb_assert(prb_launchProcesses(arena, &ignoreProc, 1, prb_Background_No));
+
+        prb_ProcessSpec emptySpec = spec;
+        emptySpec.stdinBytes = (prb_Bytes) {};
+        prb_Process emptyProc = prb_createProcess(prb_STR("cat"), emptySpec);
+        prb_assert(prb_launchProcesses(arena, &emptyProc, 1, prb_Background_No));
+        prb_assert(emptyProc.capturedStdout.len == 0);
+    }
+#endif
+
+    // NOTE(khvorov) Priorities
+#if prb_PLATFORM_WINDOWS
+    // NOTE(khvorov) Niceness and sched policies map onto priority classes
+    {
+        prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("priorityclass.c"));
+        prb_Str prog = prb_STR(
+            "#include <windows.h>\n"
+            "#include <stdio.h>\n"
+            "int main() {printf(\"%lu\", GetPriorityClass(GetCurrentProcess())); return 0;}"
+        );
+        prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+        prb_Str     progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+        prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), nullSpec);
+        prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+        prb_SchedPolicy policies[] = {prb_SchedPolicy_Batch, prb_SchedPolicy_Idle, prb_SchedPolicy_Inherit};
+        i32             niceIncrements[] = {0, 0, 3};
+        DWORD           expectedClasses[] = {BELOW_NORMAL_PRIORITY_CLASS, IDLE_PRIORITY_CLASS, BELOW_NORMAL_PRIORITY_CLASS};
+        for (i32 caseIndex = 0; caseIndex < prb_arrayCount(policies); caseIndex++) {
+            prb_ProcessSpec spec = {};
+            spec.redirectStdout = true;
+            spec.stdoutFilepath = prb_pathJoin(arena, dir, prb_STR("priorityclass.txt"));
+            spec.schedPolicy = policies[caseIndex];
+            spec.niceIncrement = niceIncrements[caseIndex];
+            prb_Process proc = prb_createProcess(progExe, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+            prb_ReadEntireFileResult readRes = prb_readEntireFile(arena, spec.stdoutFilepath);
+            prb_assert(readRes.success);
+            prb_assert(prb_streq(prb_strFromBytes(readRes.content), prb_fmt(arena, "%lu", expectedClasses[caseIndex])));
+        }
+    }
+#elif prb_PLATFORM_LINUX
+    {
+        errno = 0;
+        i32 ourNice = getpriority(PRIO_PROCESS, 0);
+        prb_assert(errno == 0);
+
+        prb_ProcessSpec spec = {};
+        spec.captureStdout = true;
+        spec.captureArena = arena;
+        spec.niceIncrement = 3;
+        spec.schedPolicy = prb_SchedPolicy_Batch;
+        prb_Process proc = prb_createProcess(prb_STR("cat /proc/self/stat"), spec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+        // NOTE(khvorov) Niceness is field 19, policy is 41
+        prb_assert(parseProcStatField(proc.capturedStdout, 19) == prb_min(ourNice + 3, 19));
+        prb_assert(parseProcStatField(proc.capturedStdout, 41) == SCHED_BATCH);
+        prb_assert(getpriority(PRIO_PROCESS, 0) == ourNice);
+
+        // NOTE(khvorov) Launches with the same settings share a helper thread, different settings don't
+        {
+            prb_Process procs[4] = {};
+            for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+                prb_ProcessSpec niceSpec = spec;
+                niceSpec.niceIncrement = 1 + procIndex % 2;
+                niceSpec.schedPolicy = prb_SchedPolicy_Inherit;
+                procs[procIndex] = prb_createProcess(prb_STR("cat /proc/self/stat"), niceSpec);
+            }
+            prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_No));
+            for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+                prb_assert(parseProcStatField(procs[procIndex].capturedStdout, 19) == prb_min(ourNice + 1 + procIndex % 2, 19));
+                prb_assert(parseProcStatField(procs[procIndex].capturedStdout, 41) == SCHED_OTHER);
+            }
+        }
+
+        // NOTE(khvorov) Idle is only set once the child is running, so look at it from the outside after the launch
+        prb_ProcessSpec idleSpec = {};
+        idleSpec.schedPolicy = prb_SchedPolicy_Idle;
+        proc = prb_createProcess(prb_STR("sleep 10"), idleSpec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
+        prb_assert(sched_getscheduler(proc.pid) == SCHED_IDLE);
+        prb_assert(getpriority(PRIO_PROCESS, (id_t)proc.pid) == ourNice);
+        prb_assert(prb_killProcesses(&proc, 1));
+
+        // NOTE(khvorov) Without arguments ionice prints its own io priority
+        if (prb_findExecutable(arena, prb_STR("ionice")).found) {
+            prb_ProcessSpec ioSpec = {};
+            ioSpec.captureStdout = true;
+            ioSpec.captureArena = arena;
+            ioSpec.ioPriorityClass = prb_IoPriorityClass_Idle;
+            proc = prb_createProcess(prb_STR("ionice"), ioSpec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+            prb_assert(prb_streq(prb_strTrim(proc.capturedStdout), prb_STR("idle")));
+
+            ioSpec.ioPriorityClass = prb_IoPriorityClass_BestEffort;
+            ioSpec.ioPriorityLevel = 6;
+            proc = prb_createProcess(prb_STR("ionice"), ioSpec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+            prb_assert(prb_streq(prb_strTrim(proc.capturedStdout), prb_STR("best-effort: prio 6")));
+        }
+
+        // NOTE(khvorov) Only privileged processes can make children nicer than themselves
+        if (geteuid() != 0) {
+            prb_ProcessSpec niceSpec = {};
+            niceSpec.niceIncrement = -1;
+            proc = prb_createProcess(prb_STR("true"), niceSpec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+            prb_assert(proc.status == prb_ProcessStatus_NotLaunched);
+        }
+    }
+#else
+#error unimplemented
+#endif
+
+    // NOTE(khvorov) Sampling a process that launches a busy loop
+#if prb_PLATFORM_LINUX
+    {
+        prb_ProcessSpec spec = {};
+        spec.sampleIntervalMs = 20;
+        spec.captureArena = arena;
+        prb_Argv    argv = prb_createArgv(arena, prb_STR("sh -c"));
+        prb_Str     script = prb_STR("sh -c 'while :; do :; done' & sleep 0.3; kill $!");
+        prb_Process proc = prb_createProcessArgv(prb_argvConcat(arena, argv, &script, 1), spec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+        prb_assert(proc.sampleCount >= 5);
+        prb_assert(prb_arenaFreePtr(arena) > (void*)proc.samples);
+
+        float   maxTreeCpuPercent = 0;
+        int32_t maxTreeProcessCount = 0;
+        for (i32 sampleIndex = 0; sampleIndex < proc.sampleCount; sampleIndex++) {
+            prb_ProcessSample sample = proc.samples[sampleIndex];
+            if (sampleIndex > 0) {
+                prb_ProcessSample prev = proc.samples[sampleIndex - 1];
+                prb_assert(sample.timeMs > prev.timeMs && sample.treeCpuMs >= prev.treeCpuMs);
+            }
+            prb_assert(sample.treeCpuMs >= sample.cpuMs && sample.treeRssBytes >= sample.rssBytes);
+            maxTreeCpuPercent = prb_max(maxTreeCpuPercent, sample.treeCpuPercent);
+            maxTreeProcessCount = prb_max(maxTreeProcessCount, sample.treeProcessCount);
+        }
+        prb_assert(proc.samples[0].rssBytes > 0);
+        prb_assert(maxTreeProcessCount >= 2);
+        prb_assert(maxTreeCpuPercent > 10);
+        prb_assert(proc.samples[proc.sampleCount - 1].treeCpuMs > proc.samples[proc.sampleCount - 1].cpuMs);
+    }
+
+    // NOTE(khvorov) Sampling processes waited on together
+    {
+        prb_ProcessSpec spec = {};
+        spec.sampleIntervalMs = 20;
+        spec.captureArena = arena;
+        prb_Process procs[] = {
+            prb_createProcess(prb_STR("sleep 0.2"), spec),
+            prb_createProcess(prb_STR("sleep 0.1"), spec),
+            prb_createProcess(prb_STR("sleep 0.1"), (prb_ProcessSpec) {}),
+        };
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), (prb_ProcessPoolSpec) {}));
+        prb_assert(procs[0].sampleCount >= 3 && procs[1].sampleCount >= 2 && procs[2].sampleCount == 0);
+        prb_assert(procs[0].sampleCount > procs[1].sampleCount);
+        prb_ProcessSample last = procs[0].samples[procs[0].sampleCount - 1];
+        prb_assert(last.treeProcessCount == 1 && last.treeCpuMs < last.timeMs / 2);
+    }
+#endif
+
+    // NOTE(khvorov) Hashing output gives the same thing as hashing the file it would be written to
+#if prb_PLATFORM_LINUX
+    {
+        prb_Str contents[] = {prb_STR("abcd"), prb_STR(""), prb_fmt(arena, "%.*s%.*s", prb_LIT(dir), prb_LIT(dir))};
+        for (i32 contentIndex = 0; contentIndex < prb_arrayCount(contents); contentIndex++) {
+            prb_Str content = contents[contentIndex];
+            prb_Str path = prb_pathJoin(arena, dir, prb_fmt(arena, "hashed%d.txt", contentIndex));
+            prb_assert(prb_writeEntireFile(arena, path, content.ptr, content.len));
+            prb_ProcessSpec spec = {};
+            spec.hashStdout = true;
+            prb_Process proc = prb_createProcess(prb_fmt(arena, "cat %.*s", prb_LIT(path)), spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+            prb_FileHash fileHash = prb_getFileHash(arena, path);
+            prb_assert(proc.stdoutHash.valid && proc.stdoutHash.hash == fileHash.hash);
+        }
+
+        i32 bigLen = 1024 * 1024 + 3;
+        prb_ProcessSpec spec = {};
+        spec.hashStdout = true;
+        spec.captureStdout = true;
+        spec.captureArena = arena;
+        prb_Process procs[2] = {
+            prb_createProcess(prb_fmt(arena, "head -c %d /dev/urandom", bigLen), spec),
+            prb_createProcess(prb_fmt(arena, "head -c %d /dev/urandom", bigLen), spec),
+        };
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), (prb_ProcessPoolSpec) {}));
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            prb_Str out = procs[procIndex].capturedStdout;
+            prb_assert(out.len == bigLen);
+            prb_assert(procs[procIndex].stdoutHash.hash == prb_stbds_hash_bytes((void*)out.ptr, (size_t)out.len, 1));
+        }
+        prb_assert(procs[0].stdoutHash.hash != procs[1].stdoutHash.hash);
     }
+#endif
 
     // NOTE(khvorov) Env vars in child
     {
@@ -2670,7 +3280,98 @@ test_process(prb_Arena* arena) {
             prb_Process proc = prb_createProcess(progExe, nullSpec);
             prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
             prb_assert(prb_killProcesses(&proc, 1));
+            prb_assert(proc.status == prb_ProcessStatus_CompletedFailed);
+            prb_assert(!proc.timedOut);
+        }
+
+        {
+            prb_ProcessSpec spec = {};
+            spec.timeoutMs = 100;
+            prb_Process proc = prb_createProcess(progExe, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+            prb_assert(proc.status == prb_ProcessStatus_CompletedFailed);
+            prb_assert(proc.timedOut);
+            prb_assert(proc.usage.wallMs >= 100.0f && proc.usage.wallMs < 5000.0f);
+        }
+
+#if prb_PLATFORM_LINUX
+        // NOTE(khvorov) The background grandchild holds on to the output pipe, so reading the output
+        // would never finish if it wasn't killed along with the shell
+        {
+            prb_ProcessSpec spec = {};
+            spec.ownProcessGroup = true;
+            spec.timeoutMs = 100;
+            spec.captureStdout = true;
+            spec.captureArena = arena;
+            prb_Argv    argv = prb_createArgv(arena, prb_fmt(arena, "sh -c \"%.*s & %.*s\"", prb_LIT(progExe), prb_LIT(progExe)));
+            prb_Process proc = prb_createProcessArgv(argv, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
+            prb_assert(prb_waitForProcesses(&proc, 1) == prb_Failure);
+            prb_assert(proc.timedOut);
+            prb_assert(proc.capturedStdout.len == 0);
+        }
+
+        {
+            prb_ProcessSpec spec = {};
+            spec.ownProcessGroup = true;
+            spec.captureStdout = true;
+            spec.captureArena = arena;
+            prb_Argv    argv = prb_createArgv(arena, prb_fmt(arena, "sh -c \"%.*s & %.*s\"", prb_LIT(progExe), prb_LIT(progExe)));
+            prb_Process proc = prb_createProcessArgv(argv, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
+            prb_assert(prb_killProcesses(&proc, 1));
+            prb_assert(proc.status == prb_ProcessStatus_CompletedFailed);
+        }
+
+        // NOTE(khvorov) Output written before the kill is kept
+        {
+            prb_Str         writtenPath = prb_pathJoin(arena, dir, prb_STR("written"));
+            prb_ProcessSpec spec = {};
+            spec.ownProcessGroup = true;
+            spec.captureStdout = true;
+            spec.captureArena = arena;
+            prb_Argv    argv = prb_createArgv(arena, prb_fmt(arena, "sh -c \"echo before; touch %.*s; %.*s\"", prb_LIT(writtenPath), prb_LIT(progExe)));
+            prb_Process proc = prb_createProcessArgv(argv, spec);
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
+            prb_TimeStart start = prb_timeStart();
+            while (!prb_isFile(arena, writtenPath) && prb_getMsFrom(start) < 10000.0f) {
+                prb_sleep(5.0f);
+            }
+            prb_assert(prb_killProcesses(&proc, 1));
+            prb_assert(prb_streq(proc.capturedStdout, prb_STR("before\n")));
+        }
+
+        // NOTE(khvorov) Without a process group the grandchild outlives the timeout and keeps the pipe open,
+        // the wait still ends on time with whatever was written before the kill
+        {
+            prb_ProcessSpec spec = {};
+            spec.timeoutMs = 100;
+            spec.captureStdout = true;
+            spec.captureArena = arena;
+            prb_Argv      argv = prb_createArgv(arena, prb_STR("sh -c \"echo before; sleep 3 & sleep 3\""));
+            prb_Process   proc = prb_createProcessArgv(argv, spec);
+            prb_TimeStart start = prb_timeStart();
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+            prb_assert(prb_getMsFrom(start) < 1500);
+            prb_assert(proc.timedOut);
+            prb_assert(prb_streq(proc.capturedStdout, prb_STR("before\n")));
+        }
+
+        // NOTE(khvorov) Same but the shell itself exits right away and only the grandchild is left holding the pipe
+        {
+            prb_ProcessSpec spec = {};
+            spec.timeoutMs = 300;
+            spec.captureStdout = true;
+            spec.captureArena = arena;
+            prb_Argv      argv = prb_createArgv(arena, prb_STR("sh -c \"echo before; sleep 3 &\""));
+            prb_Process   proc = prb_createProcessArgv(argv, spec);
+            prb_TimeStart start = prb_timeStart();
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+            prb_assert(prb_getMsFrom(start) < 1500);
+            prb_assert(proc.timedOut && proc.status == prb_ProcessStatus_CompletedFailed);
+            prb_assert(prb_streq(proc.capturedStdout, prb_STR("before\n")));
         }
+#endif
     }
 
     // NOTE(khvorov) Fail
@@ -2705,42 +3406,1265 @@ test_process(prb_Arena* arena) {
 }
 
 function void
-test_sleep(prb_Arena* arena) {
-    prb_unused(arena);
-    prb_TimeStart timeStart = prb_timeStart();
-    float         sleepMs = 10.9f;
-    prb_sleep(sleepMs);
-    float ms = prb_getMsFrom(timeStart);
-    prb_assert(ms >= sleepMs);
-}
+test_createProcessArgv(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
 
-function void
-test_debuggerPresent(prb_Arena* arena) {
-    // NOTE(khvorov) Just make sure the code executes somewhere, I don't know how to actually test it automatically
-    prb_debuggerPresent(arena);
+    prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("args.c"));
+    prb_Str prog = prb_STR(
+        "int strcmp(const char* s1, const char* s2);\n"
+        "int main(int argc, char** argv) {\n"
+        "if (argc != 4) return 1;\n"
+        "if (strcmp(argv[1], \"hello world\") != 0) return 2;\n"
+        "if (strcmp(argv[2], \"\") != 0) return 3;\n"
+        "if (strcmp(argv[3], \"x\") != 0) return 4;\n"
+        "return 0;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+    prb_Str     progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+    prb_Str     compileArgs[] = {progPath, prb_STR("-o"), progExe};
+    prb_Argv    compileArgv = prb_argvConcat(arena, prb_createArgv(arena, prb_STR("clang")), compileArgs, prb_arrayCount(compileArgs));
+    prb_Process compileProc = prb_createProcessArgv(compileArgv, (prb_ProcessSpec) {});
+    prb_assert(compileProc.cmd.len == 0);
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+    prb_Argv    prefix = prb_createArgv(arena, prb_fmt(arena, "%.*s \"hello world\" \"\"", prb_LIT(progExe)));
+    prb_Str     goodArg = prb_STR("x");
+    prb_Str     badArg = prb_STR("y");
+    prb_Process procs[] = {
+        prb_createProcessArgv(prb_argvConcat(arena, prefix, &goodArg, 1), (prb_ProcessSpec) {}),
+        prb_createProcessArgv(prb_argvConcat(arena, prefix, &badArg, 1), (prb_ProcessSpec) {}),
+    };
+    prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+    prb_assert(prb_waitForProcesses(procs, prb_arrayCount(procs)) == prb_Failure);
+    prb_assert(procs[0].status == prb_ProcessStatus_CompletedSuccess);
+    prb_assert(procs[1].status == prb_ProcessStatus_CompletedFailed);
+
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
 }
 
 function void
-test_env(prb_Arena* arena) {
+test_getProcessUsage(prb_Arena* arena) {
     prb_TempMemory temp = prb_beginTempMemory(arena);
-    prb_Str        name = prb_STR(__FUNCTION__);
-    prb_Str        value = prb_STR("test");
-    prb_Str        value2 = prb_STR("test太阳😐2");
-    prb_unsetenv(arena, name);
-    prb_assert(!prb_getenv(arena, name).found);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
 
-    prb_assert(prb_setenv(arena, name, value));
-    prb_GetenvResult getRes = prb_getenv(arena, name);
-    prb_assert(getRes.found);
-    prb_assert(prb_streq(getRes.str, value));
+    prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("prog.c"));
+    prb_Str prog = prb_STR(
+        "#include \"../../cbuild.h\"\n"
+        "int main() {\n"
+        "int32_t bytes = 64 * prb_MEGABYTE;\n"
+        "char* ptr = (char*)malloc(bytes);\n"
+        "memset(ptr, 1, bytes);\n"
+        "prb_TimeStart start = prb_timeStart();\n"
+        "while (prb_getMsFrom(start) < 100.0f) {}\n"
+        "return ptr[bytes / 2] == 1 ? 0 : 1;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+    prb_Str     progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+    prb_assert(prb_getProcessUsage(&compileProc).wallMs > 0.0f);
+
+    prb_Process proc = prb_createProcess(progExe, (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
+    prb_sleep(10.0f);
+    prb_ProcessUsage runningUsage = prb_getProcessUsage(&proc);
+    prb_assert(runningUsage.wallMs >= 10.0f);
+    prb_assert(runningUsage.userCpuMs == 0.0f && runningUsage.maxRssBytes == 0);
 
-    prb_assert(prb_setenv(arena, name, value2));
-    getRes = prb_getenv(arena, name);
-    prb_assert(getRes.found);
-    prb_assert(prb_streq(getRes.str, value2));
+    prb_assert(prb_waitForProcesses(&proc, 1));
+    prb_ProcessUsage usage = prb_getProcessUsage(&proc);
+    prb_assert(usage.wallMs >= 100.0f);
+    prb_assert(usage.userCpuMs + usage.sysCpuMs >= 20.0f);
+    prb_assert(usage.maxRssBytes >= 64 * prb_MEGABYTE);
+    prb_assert(prb_getProcessUsage(&proc).wallMs == usage.wallMs);
 
-    prb_assert(prb_unsetenv(arena, name));
-    prb_assert(!prb_getenv(arena, name).found);
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_getMemoryInfo(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_MemoryInfo memory = prb_getMemoryInfo(arena);
+    prb_assert(memory.valid);
+    prb_assert(memory.totalBytes > 0);
+    prb_assert(memory.availableBytes > 0 && memory.availableBytes <= memory.totalBytes);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_getProcessMemory(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    // NOTE(khvorov) Holds on to the memory until the file in the first arg shows up
+    prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("prog.c"));
+    prb_Str prog = prb_STR(
+        "#include \"../../cbuild.h\"\n"
+        "int main(int argc, char** argv) {\n"
+        "if (argc < 2) return 1;\n"
+        "prb_Arena arena = prb_createArenaFromVmem(1 * prb_MEGABYTE);\n"
+        "int32_t bytes = 64 * prb_MEGABYTE;\n"
+        "char* ptr = (char*)malloc(bytes);\n"
+        "memset(ptr, 1, bytes);\n"
+        "while (!prb_isFile(&arena, prb_STR(argv[1]))) {prb_sleep(5.0f);}\n"
+        "return ptr[bytes / 2] == 1 ? 0 : 1;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+    prb_Str     progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+    prb_assert(prb_getProcessMemory(arena, &compileProc) == 0);
+
+    prb_Str releasePath = prb_pathJoin(arena, dir, prb_STR("release"));
+
+#if prb_PLATFORM_WINDOWS
+    // NOTE(khvorov) Only the working set of the process itself is counted on windows
+    prb_Str cmds[] = {prb_fmt(arena, "%.*s %.*s", prb_LIT(progExe), prb_LIT(releasePath))};
+#elif prb_PLATFORM_LINUX
+    // NOTE(khvorov) Memory of the grandchild counts too
+    prb_Str cmds[] = {
+        prb_fmt(arena, "%.*s %.*s", prb_LIT(progExe), prb_LIT(releasePath)),
+        prb_fmt(arena, "sh -c \"%.*s %.*s; true\"", prb_LIT(progExe), prb_LIT(releasePath)),
+    };
+#else
+#error unimplemented
+#endif
+
+    for (i32 cmdIndex = 0; cmdIndex < prb_arrayCount(cmds); cmdIndex++) {
+        prb_assert(prb_removePathIfExists(arena, releasePath));
+        prb_Process proc = prb_createProcessArgv(prb_createArgv(arena, cmds[cmdIndex]), (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_Yes));
+        prb_TimeStart start = prb_timeStart();
+        while (prb_getProcessMemory(arena, &proc) < 64 * prb_MEGABYTE && prb_getMsFrom(start) < 10000.0f) {
+            prb_sleep(5.0f);
+        }
+        prb_assert(prb_getProcessMemory(arena, &proc) >= 64 * prb_MEGABYTE);
+        prb_assert(prb_writeEntireFile(arena, releasePath, "x", 1));
+        prb_assert(prb_waitForProcesses(&proc, 1));
+        prb_assert(prb_getProcessMemory(arena, &proc) == 0);
+    }
+
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_getSystemLoad(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_SystemLoad load = prb_getSystemLoad(arena);
+#if prb_PLATFORM_WINDOWS
+    prb_assert(!load.valid && !load.cpuPressureValid);
+#elif prb_PLATFORM_LINUX
+    prb_assert(load.valid);
+    prb_assert(load.loadAverage >= 0.0f);
+    prb_assert(!load.cpuPressureValid || (load.cpuPressure >= 0.0f && load.cpuPressure <= 100.0f));
+#else
+#error unimplemented
+#endif
+    prb_endTempMemory(temp);
+}
+
+// NOTE(khvorov) Each process leaves a marker named after its index in the dir.
+// "together" succeeds once it sees the markers of all the others, "alone" fails if it sees any while it runs
+function prb_Str
+compileOverlapProbeProg(prb_Arena* arena, prb_Str dir) {
+    prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("probe.c"));
+    prb_Str prog = prb_STR(
+        "#include \"../../cbuild.h\"\n"
+        "int main(int argc, char** argv) {\n"
+        "if (argc != 5) return 1;\n"
+        "prb_Arena arena = prb_createArenaFromVmem(1 * prb_MEGABYTE);\n"
+        "prb_Str dir = prb_STR(argv[1]);\n"
+        "int32_t index = atoi(argv[2]);\n"
+        "int32_t count = atoi(argv[3]);\n"
+        "bool together = prb_streq(prb_STR(argv[4]), prb_STR(\"together\"));\n"
+        "prb_Str marker = prb_pathJoin(&arena, dir, prb_fmt(&arena, \"%d\", index));\n"
+        "if (prb_writeEntireFile(&arena, marker, \"x\", 1) != prb_Success) return 1;\n"
+        "prb_TimeStart start = prb_timeStart();\n"
+        "int32_t seen = 0;\n"
+        "for (;;) {\n"
+        "seen = 0;\n"
+        "for (int32_t other = 0; other < count; other++) {\n"
+        "if (other != index && prb_isFile(&arena, prb_pathJoin(&arena, dir, prb_fmt(&arena, \"%d\", other)))) seen += 1;\n"
+        "}\n"
+        "if (!together || seen == count - 1 || prb_getMsFrom(start) > 10000.0f) break;\n"
+        "prb_sleep(5.0f);\n"
+        "}\n"
+        "if (!together) {prb_sleep(50.0f); prb_removePathIfExists(&arena, marker);}\n"
+        "return together ? (seen == count - 1 ? 0 : 1) : (seen == 0 ? 0 : 1);\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+    prb_Str     progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+    return progExe;
+}
+
+function void
+test_launchProcessPool(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    prb_ProcessSpec nullSpec;
+    prb_memset(&nullSpec, 0, sizeof(nullSpec));
+
+    prb_Str progPaths[] = {
+        prb_pathJoin(arena, dir, prb_STR("success.c")),
+        prb_pathJoin(arena, dir, prb_STR("fail.c")),
+        prb_pathJoin(arena, dir, prb_STR("long.c")),
+    };
+    prb_Str progs[] = {
+        prb_STR("#include \"../../cbuild.h\"\nint main() {prb_sleep(100); return 0;}"),
+        prb_STR("int main() {return 1;}"),
+        prb_STR("#include \"../../cbuild.h\"\nint main() {prb_sleep(10000); return 0;}"),
+    };
+    prb_Str progExes[3] = {};
+    for (i32 progIndex = 0; progIndex < prb_arrayCount(progPaths); progIndex++) {
+        prb_Str progPath = progPaths[progIndex];
+        prb_Str prog = progs[progIndex];
+        prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+        progExes[progIndex] = prb_replaceExt(arena, progPath, prb_STR("exe"));
+        prb_Str     compileCmd = prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExes[progIndex]));
+        prb_Process proc = prb_createProcess(compileCmd, nullSpec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+    }
+    prb_Str probeExe = compileOverlapProbeProg(arena, dir);
+
+    // NOTE(khvorov) 4 processes that take 100ms each with 2 slots have to take at least 2 rounds
+    {
+        prb_Process procs[4];
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            procs[procIndex] = prb_createProcess(progExes[0], nullSpec);
+        }
+        prb_ProcessPoolSpec spec = {};
+        spec.maxInFlight = 2;
+        prb_TimeStart poolStart = prb_timeStart();
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec));
+        prb_assert(prb_getMsFrom(poolStart) >= 200.0f);
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            prb_assert(procs[procIndex].status == prb_ProcessStatus_CompletedSuccess);
+        }
+    }
+
+    // NOTE(khvorov) Default slot count and per-process status
+    {
+        prb_Process procs[5];
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            procs[procIndex] = prb_createProcess(progExes[procIndex % 2], nullSpec);
+        }
+        prb_ProcessPoolSpec spec = {};
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec) == prb_Failure);
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            prb_ProcessStatus expected = procIndex % 2 == 0 ? prb_ProcessStatus_CompletedSuccess : prb_ProcessStatus_CompletedFailed;
+            prb_assert(procs[procIndex].status == expected);
+        }
+    }
+
+    // NOTE(khvorov) Processes that are already launched take up a slot and are waited for
+    {
+        prb_Process procs[2] = {prb_createProcess(progExes[0], nullSpec), prb_createProcess(progExes[0], nullSpec)};
+        prb_assert(prb_launchProcesses(arena, procs, 1, prb_Background_Yes));
+        prb_ProcessPoolSpec spec = {};
+        spec.maxInFlight = 1;
+        prb_TimeStart poolStart = prb_timeStart();
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec));
+        prb_assert(prb_getMsFrom(poolStart) >= 200.0f);
+        prb_assert(procs[0].status == prb_ProcessStatus_CompletedSuccess);
+        prb_assert(procs[1].status == prb_ProcessStatus_CompletedSuccess);
+    }
+
+    // NOTE(khvorov) The first failure kills the rest and nothing else gets launched.
+    // The killed processes would otherwise run for 10 seconds.
+    {
+        prb_Process procs[4] = {
+            prb_createProcess(progExes[2], nullSpec),
+            prb_createProcess(progExes[1], nullSpec),
+            prb_createProcess(progExes[2], nullSpec),
+            prb_createProcess(progExes[0], nullSpec),
+        };
+        prb_ProcessPoolSpec spec = {};
+        spec.maxInFlight = 3;
+        spec.failFast = true;
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec) == prb_Failure);
+        prb_assert(procs[0].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(procs[1].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(procs[2].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(procs[3].status == prb_ProcessStatus_NotLaunched);
+        prb_assert(procs[0].usage.wallMs < 5000.0f && procs[2].usage.wallMs < 5000.0f);
+        prb_assert(procs[0].spec.ownProcessGroup && procs[2].spec.ownProcessGroup);
+    }
+
+    {
+        prb_Process procs[3];
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            procs[procIndex] = prb_createProcess(progExes[2], nullSpec);
+        }
+        prb_ProcessPoolSpec spec = {};
+        spec.maxInFlight = 1;
+        spec.deadlineMs = 50;
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec) == prb_Failure);
+        prb_assert(procs[0].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(procs[0].timedOut);
+        prb_assert(procs[0].usage.wallMs >= 50.0f && procs[0].usage.wallMs < 5000.0f);
+        prb_assert(procs[1].status == prb_ProcessStatus_NotLaunched);
+        prb_assert(procs[2].status == prb_ProcessStatus_NotLaunched);
+    }
+
+    // NOTE(khvorov) Processes that don't fit in memory together run one at a time
+    {
+        prb_TempMemory memoryTemp = prb_beginTempMemory(arena);
+        prb_MemoryInfo memory = prb_getMemoryInfo(arena);
+        prb_endTempMemory(memoryTemp);
+        prb_assert(memory.valid);
+
+        int64_t perProcessBytes[] = {memory.totalBytes, 1};
+        for (i32 caseIndex = 0; caseIndex < prb_arrayCount(perProcessBytes); caseIndex++) {
+            prb_Str markerDir = prb_pathJoin(arena, dir, prb_fmt(arena, "memory%d", caseIndex));
+            prb_assert(prb_clearDir(arena, markerDir));
+            const char* mode = caseIndex == 0 ? "alone" : "together";
+            prb_Process procs[3];
+            for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+                prb_Str cmd = prb_fmt(arena, "%.*s %.*s %d %d %s", prb_LIT(probeExe), prb_LIT(markerDir), procIndex, prb_arrayCount(procs), mode);
+                procs[procIndex] = prb_createProcessArgv(prb_createArgv(arena, cmd), nullSpec);
+            }
+            prb_ProcessPoolSpec spec = {};
+            spec.maxInFlight = 3;
+            spec.throttleOnMemory = true;
+            spec.memoryPerProcessBytes = perProcessBytes[caseIndex];
+            prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec));
+            prb_assert(procs[0].heldBackMs == 0.0f);
+            if (caseIndex == 0) {
+                prb_assert(procs[1].heldBackMs > 0.0f && procs[2].heldBackMs > 0.0f);
+            } else {
+                prb_assert(procs[1].heldBackMs == 0.0f && procs[2].heldBackMs == 0.0f);
+            }
+        }
+    }
+
+    // NOTE(khvorov) Processes launched just now are load already, so a load limit below 1 serializes everything.
+    // Nothing is held back where the load isn't known.
+    {
+        prb_TempMemory loadTemp = prb_beginTempMemory(arena);
+        bool           loadKnown = prb_getSystemLoad(arena).valid;
+        prb_endTempMemory(loadTemp);
+
+        float maxLoads[] = {0.5f, 1000.0f};
+        for (i32 caseIndex = 0; caseIndex < prb_arrayCount(maxLoads); caseIndex++) {
+            bool    heldBack = loadKnown && caseIndex == 0;
+            prb_Str markerDir = prb_pathJoin(arena, dir, prb_fmt(arena, "load%d", caseIndex));
+            prb_assert(prb_clearDir(arena, markerDir));
+            const char* mode = heldBack ? "alone" : "together";
+            prb_Process procs[3];
+            for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+                prb_Str cmd = prb_fmt(arena, "%.*s %.*s %d %d %s", prb_LIT(probeExe), prb_LIT(markerDir), procIndex, prb_arrayCount(procs), mode);
+                procs[procIndex] = prb_createProcessArgv(prb_createArgv(arena, cmd), nullSpec);
+            }
+            prb_ProcessPoolSpec spec = {};
+            spec.maxInFlight = 3;
+            spec.maxLoad = maxLoads[caseIndex];
+            prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec));
+            prb_assert(procs[0].heldBackMs == 0.0f);
+            if (heldBack) {
+                prb_assert(procs[1].heldBackMs > 0.0f && procs[2].heldBackMs > 0.0f);
+            } else {
+                prb_assert(procs[1].heldBackMs == 0.0f && procs[2].heldBackMs == 0.0f);
+            }
+        }
+    }
+
+    prb_assert(prb_launchProcessPool(arena, 0, 0, (prb_ProcessPoolSpec) {}));
+
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_launchPipeline(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+#if prb_PLATFORM_WINDOWS
+    {
+        prb_Process procs[2] = {
+            prb_createProcess(prb_STR("prb_nonexistent_executable"), (prb_ProcessSpec) {}),
+            prb_createProcess(prb_STR("prb_nonexistent_executable"), (prb_ProcessSpec) {}),
+        };
+        prb_assert(prb_launchPipeline(arena, procs, prb_arrayCount(procs), prb_Background_No) == prb_Failure);
+    }
+#elif prb_PLATFORM_LINUX
+    prb_ProcessSpec captureSpec = {};
+    captureSpec.captureStdout = true;
+    captureSpec.captureArena = arena;
+
+    {
+        prb_Process procs[3] = {
+            prb_createProcessArgv(prb_createArgv(arena, prb_STR("printf \"b\\na\\nc\\n\"")), (prb_ProcessSpec) {}),
+            prb_createProcess(prb_STR("sort"), (prb_ProcessSpec) {}),
+            prb_createProcess(prb_STR("tr a-z A-Z"), captureSpec),
+        };
+        prb_assert(prb_launchPipeline(arena, procs, prb_arrayCount(procs), prb_Background_No));
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            prb_assert(procs[procIndex].status == prb_ProcessStatus_CompletedSuccess);
+        }
+        prb_assert(prb_streq(procs[2].capturedStdout, prb_STR("A\nB\nC\n")));
+    }
+
+    // NOTE(khvorov) Way more than fits in a pipe, stages have to run at the same time
+    {
+        prb_Process procs[2] = {
+            prb_createProcess(prb_STR("head -c 10000000 /dev/zero"), (prb_ProcessSpec) {}),
+            prb_createProcess(prb_STR("wc -c"), captureSpec),
+        };
+        prb_assert(prb_launchPipeline(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+        prb_assert(procs[0].status == prb_ProcessStatus_Launched && procs[1].status == prb_ProcessStatus_Launched);
+        prb_assert(prb_waitForProcesses(procs, prb_arrayCount(procs)));
+        prb_assert(prb_streq(prb_strTrim(procs[1].capturedStdout), prb_STR("10000000")));
+    }
+
+    // NOTE(khvorov) Stages after a broken one see the end of their input
+    {
+        prb_Process procs[2] = {
+            prb_createProcess(prb_STR("prb_nonexistent_executable"), (prb_ProcessSpec) {}),
+            prb_createProcess(prb_STR("wc -c"), captureSpec),
+        };
+        prb_assert(prb_launchPipeline(arena, procs, prb_arrayCount(procs), prb_Background_No) == prb_Failure);
+        prb_assert(procs[1].status == prb_ProcessStatus_CompletedSuccess);
+        prb_assert(prb_streq(prb_strTrim(procs[1].capturedStdout), prb_STR("0")));
+    }
+
+    // NOTE(khvorov) A zeroed process is not a pipeline stage
+    {
+        prb_Process proc;
+        prb_memset(&proc, 0, sizeof(proc));
+        proc.cmd = prb_STR("echo zeroed");
+        proc.spec = captureSpec;
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+        prb_assert(prb_streq(proc.capturedStdout, prb_STR("zeroed\n")));
+    }
+#else
+#error unimplemented
+#endif
+
+    prb_endTempMemory(temp);
+}
+
+function prb_Str*
+compileSleepAndExitProgs(prb_Arena* arena, prb_Str dir) {
+    prb_Str  progs[] = {
+        prb_STR("#include \"../../cbuild.h\"\nint main() {prb_sleep(300); return 0;}"),
+        prb_STR("int main() {return 0;}"),
+        prb_STR("int main() {return 1;}"),
+    };
+    prb_Str* exes = 0;
+    for (i32 progIndex = 0; progIndex < prb_arrayCount(progs); progIndex++) {
+        prb_Str progPath = prb_pathJoin(arena, dir, prb_fmt(arena, "prog%d.c", progIndex));
+        prb_Str prog = progs[progIndex];
+        prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+        prb_Str progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+        arrput(exes, progExe);
+        prb_Str     compileCmd = prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe));
+        prb_Process proc = prb_createProcess(compileCmd, (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+    }
+    return exes;
+}
+
+function void
+test_launchProcessesOnThreads(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    prb_Str* exes = compileSleepAndExitProgs(arena, dir);
+
+    i32             procCount = 64;
+    prb_Process*    procs = prb_arenaAllocArray(arena, prb_Process, procCount);
+    prb_ThreadPool* pools[] = {0, prb_createThreadPool(arena, 1, 0), prb_createThreadPool(arena, 4, 0)};
+
+#if prb_PLATFORM_LINUX
+    prb_ProcessSpec captureSpec = {};
+    captureSpec.captureStdout = true;
+    captureSpec.captureArena = arena;
+
+    for (i32 poolIndex = 0; poolIndex < prb_arrayCount(pools); poolIndex++) {
+        for (i32 procIndex = 0; procIndex < procCount; procIndex++) {
+            procs[procIndex] = prb_createProcess(prb_fmt(arena, "echo %d", procIndex), captureSpec);
+        }
+        prb_assert(prb_launchProcessesOnThreads(arena, procs, procCount, pools[poolIndex], prb_Background_No));
+        for (i32 procIndex = 0; procIndex < procCount; procIndex++) {
+            prb_assert(procs[procIndex].status == prb_ProcessStatus_CompletedSuccess);
+            prb_assert(prb_streq(procs[procIndex].capturedStdout, prb_fmt(arena, "%d\n", procIndex)));
+        }
+    }
+
+    // NOTE(khvorov) Capture pipes of one process must not end up in another one launched at the same time,
+    // the output of the quick ones would not end until the slow ones exit
+    {
+        for (i32 procIndex = 0; procIndex < procCount; procIndex++) {
+            prb_Str cmd = procIndex % 2 == 0 ? prb_STR("sleep 1") : prb_STR("echo x");
+            procs[procIndex] = prb_createProcess(cmd, captureSpec);
+        }
+        prb_assert(prb_launchProcessesOnThreads(arena, procs, procCount, pools[2], prb_Background_Yes));
+        for (i32 procIndex = 1; procIndex < procCount; procIndex += 2) {
+            prb_assert(prb_waitForProcesses(procs + procIndex, 1));
+            prb_assert(prb_streq(procs[procIndex].capturedStdout, prb_STR("x\n")));
+        }
+        prb_assert(prb_waitForProcesses(procs, procCount));
+    }
+#endif
+
+    // NOTE(khvorov) Exit codes end up in the right process whichever thread launched it
+    for (i32 poolIndex = 0; poolIndex < prb_arrayCount(pools); poolIndex++) {
+        for (i32 procIndex = 0; procIndex < procCount; procIndex++) {
+            procs[procIndex] = prb_createProcess(exes[1 + procIndex % 2], (prb_ProcessSpec) {});
+        }
+        prb_assert(prb_launchProcessesOnThreads(arena, procs, procCount, pools[poolIndex], prb_Background_No) == prb_Failure);
+        for (i32 procIndex = 0; procIndex < procCount; procIndex++) {
+            prb_ProcessStatus expected = procIndex % 2 == 0 ? prb_ProcessStatus_CompletedSuccess : prb_ProcessStatus_CompletedFailed;
+            prb_assert(procs[procIndex].status == expected);
+        }
+    }
+
+    // NOTE(khvorov) Processes that can't be launched don't stop the rest
+    {
+        for (i32 procIndex = 0; procIndex < procCount; procIndex++) {
+            prb_Str cmd = procIndex == 5 ? prb_STR("prb_nonexistent_executable") : exes[1];
+            procs[procIndex] = prb_createProcess(cmd, (prb_ProcessSpec) {});
+        }
+        prb_assert(prb_launchProcessesOnThreads(arena, procs, procCount, pools[2], prb_Background_No) == prb_Failure);
+        for (i32 procIndex = 0; procIndex < procCount; procIndex++) {
+            prb_ProcessStatus expected = procIndex == 5 ? prb_ProcessStatus_NotLaunched : prb_ProcessStatus_CompletedSuccess;
+            prb_assert(procs[procIndex].status == expected);
+        }
+    }
+
+    for (i32 poolIndex = 1; poolIndex < prb_arrayCount(pools); poolIndex++) {
+        prb_destroyThreadPool(pools[poolIndex]);
+    }
+    arrfree(exes);
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+// NOTE(khvorov) "wait <path> <ms>" waits for the file to show up and then sleeps,
+// "touch <path> <bytes>" writes that many bytes to stdout and then creates the file
+function prb_Str
+compileFileSignalProg(prb_Arena* arena, prb_Str dir) {
+    prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("signal.c"));
+    prb_Str prog = prb_STR(
+        "#include \"../../cbuild.h\"\n"
+        "int main(int argc, char** argv) {\n"
+        "if (argc != 4) return 1;\n"
+        "prb_Arena arena = prb_createArenaFromVmem(1 * prb_MEGABYTE);\n"
+        "prb_Str path = prb_STR(argv[2]);\n"
+        "int32_t number = atoi(argv[3]);\n"
+        "if (prb_streq(prb_STR(argv[1]), prb_STR(\"wait\"))) {\n"
+        "prb_TimeStart start = prb_timeStart();\n"
+        "while (!prb_isFile(&arena, path)) {if (prb_getMsFrom(start) > 10000.0f) return 1; prb_sleep(5.0f);}\n"
+        "prb_sleep((float)number);\n"
+        "} else {\n"
+        "char* bytes = (char*)prb_arenaAllocAndZero(&arena, number + 1, 1);\n"
+        "memset(bytes, 'x', number);\n"
+        "prb_Str out = {bytes, number};\n"
+        "if (prb_writeToStdout(out) != prb_Success) return 1;\n"
+        "if (prb_writeEntireFile(&arena, path, \"x\", 1) != prb_Success) return 1;\n"
+        "}\n"
+        "return 0;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+    prb_Str     progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+    return progExe;
+}
+
+function void
+test_processCompletionIter(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    prb_Str* exes = compileSleepAndExitProgs(arena, dir);
+
+    // NOTE(khvorov) The slow process at the start should not hold up the others
+    {
+        prb_Process procs[4];
+        for (i32 procIndex = 0; procIndex < 3; procIndex++) {
+            procs[procIndex] = prb_createProcess(exes[procIndex], (prb_ProcessSpec) {});
+        }
+        procs[3] = prb_createProcess(exes[1], (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, procs, 3, prb_Background_Yes));
+
+        bool                      completed[4] = {};
+        i32                       completedCount = 0;
+        prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(procs, prb_arrayCount(procs));
+        while (prb_processCompletionIterNext(&iter)) {
+            prb_assert(iter.curProc == procs + iter.curProcIndex);
+            prb_assert(!completed[iter.curProcIndex]);
+            completed[iter.curProcIndex] = true;
+            if (completedCount == 0) {
+                prb_assert(iter.curProcIndex != 0);
+                // NOTE(khvorov) Processes launched while iterating are picked up too
+                prb_assert(prb_launchProcesses(arena, procs + 3, 1, prb_Background_Yes));
+            }
+            completedCount += 1;
+        }
+        prb_destroyProcessCompletionIter(&iter);
+
+        prb_assert(completedCount == 4);
+        prb_assert(procs[0].status == prb_ProcessStatus_CompletedSuccess);
+        prb_assert(procs[1].status == prb_ProcessStatus_CompletedSuccess);
+        prb_assert(procs[2].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(procs[3].status == prb_ProcessStatus_CompletedSuccess);
+    }
+
+    // NOTE(khvorov) Processes that run out of time are killed and come out as failed
+    {
+        prb_ProcessSpec timeoutSpec = {};
+        timeoutSpec.timeoutMs = 50;
+        prb_Process procs[3] = {prb_createProcess(exes[0], timeoutSpec), prb_createProcess(exes[0], (prb_ProcessSpec) {}), prb_createProcess(exes[1], (prb_ProcessSpec) {})};
+        prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+
+        prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(procs, prb_arrayCount(procs));
+        iter.deadlineMs = 150;
+        i32 completedCount = 0;
+        while (prb_processCompletionIterNext(&iter)) {
+            completedCount += 1;
+        }
+        prb_destroyProcessCompletionIter(&iter);
+
+        prb_assert(completedCount == 3);
+        prb_assert(procs[0].timedOut && procs[0].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(procs[0].usage.wallMs < 150.0f);
+        prb_assert(procs[1].timedOut && procs[1].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(procs[1].usage.wallMs < 300.0f);
+        prb_assert(!procs[2].timedOut && procs[2].status == prb_ProcessStatus_CompletedSuccess);
+    }
+
+    // NOTE(khvorov) The second process exits long before the first one and should not be timed
+    // as if it ran until the first one was waited for
+    {
+        prb_Str     signalExe = compileFileSignalProg(arena, dir);
+        prb_Str     signalPath = prb_pathJoin(arena, dir, prb_STR("exited"));
+        prb_Process procs[] = {
+            prb_createProcessArgv(prb_createArgv(arena, prb_fmt(arena, "%.*s wait %.*s 300", prb_LIT(signalExe), prb_LIT(signalPath))), (prb_ProcessSpec) {}),
+            prb_createProcessArgv(prb_createArgv(arena, prb_fmt(arena, "%.*s touch %.*s 0", prb_LIT(signalExe), prb_LIT(signalPath))), (prb_ProcessSpec) {}),
+        };
+        prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+        prb_assert(prb_waitForProcesses(procs, prb_arrayCount(procs)));
+        prb_assert(procs[0].usage.wallMs >= 300.0f);
+        prb_assert(procs[1].usage.wallMs < procs[0].usage.wallMs - 200.0f);
+    }
+
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) The first process waits for the second one, which can only finish once its output is read
+    {
+        prb_Str         signalExe = compileFileSignalProg(arena, dir);
+        prb_Str         signalPath = prb_pathJoin(arena, dir, prb_STR("drained"));
+        prb_ProcessSpec captureSpec = {};
+        captureSpec.captureStdout = true;
+        captureSpec.captureArena = arena;
+        prb_Process procs[] = {
+            prb_createProcessArgv(prb_createArgv(arena, prb_fmt(arena, "%.*s wait %.*s 0", prb_LIT(signalExe), prb_LIT(signalPath))), (prb_ProcessSpec) {}),
+            prb_createProcessArgv(prb_createArgv(arena, prb_fmt(arena, "%.*s touch %.*s 200000", prb_LIT(signalExe), prb_LIT(signalPath))), captureSpec),
+        };
+        prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+        prb_assert(prb_waitForProcesses(procs, prb_arrayCount(procs)));
+        prb_assert(procs[1].capturedStdout.len == 200000);
+    }
+#endif
+
+    // NOTE(khvorov) Nothing to wait for
+    {
+        prb_Process               proc = prb_createProcess(exes[1], (prb_ProcessSpec) {});
+        prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(&proc, 1);
+        prb_assert(prb_processCompletionIterNext(&iter) == prb_Failure);
+        prb_assert(iter.curProc == 0);
+        prb_destroyProcessCompletionIter(&iter);
+    }
+
+    arrfree(exes);
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_waitForAnyProcess(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    prb_Str*    exes = compileSleepAndExitProgs(arena, dir);
+    prb_Process procs[2] = {prb_createProcess(exes[0], (prb_ProcessSpec) {}), prb_createProcess(exes[2], (prb_ProcessSpec) {})};
+    prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+
+    prb_assert(prb_waitForAnyProcess(procs, prb_arrayCount(procs)) == 1);
+    prb_assert(procs[1].status == prb_ProcessStatus_CompletedFailed);
+    prb_assert(procs[0].status == prb_ProcessStatus_Launched);
+    prb_assert(prb_waitForAnyProcess(procs, prb_arrayCount(procs)) == 0);
+    prb_assert(procs[0].status == prb_ProcessStatus_CompletedSuccess);
+    prb_assert(prb_waitForAnyProcess(procs, prb_arrayCount(procs)) == -1);
+
+    arrfree(exes);
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_writeBufferedOutput(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+#if prb_PLATFORM_WINDOWS
+    {
+        prb_ProcessSpec spec = {};
+        spec.bufferOutput = true;
+        prb_Process proc = prb_createProcess(prb_STR("cmd /c echo x"), spec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+        prb_assert(proc.status == prb_ProcessStatus_NotLaunched);
+    }
+#elif prb_PLATFORM_LINUX
+    // NOTE(khvorov) The first process is the slowest and the output of both would interleave if it wasn't buffered
+    prb_Str childPath = prb_pathJoin(arena, dir, prb_STR("child.c"));
+    prb_Str child = prb_STR(
+        "#include \"../../cbuild.h\"\n"
+        "int main(int argc, char** argv) {\n"
+        "prb_Arena arena = prb_createArenaFromVmem(1 * prb_MEGABYTE);\n"
+        "const char* args0[] = {\"sh\", \"-c\", \"echo a1; sleep 0.3; echo a2 1>&2\", 0};\n"
+        "const char* args1[] = {\"sh\", \"-c\", \"sleep 0.1; echo b1; echo b2\", 0};\n"
+        "prb_Argv argv0 = {args0, 3};\n"
+        "prb_Argv argv1 = {args1, 3};\n"
+        "prb_ProcessSpec spec = {};\n"
+        "spec.bufferOutput = true;\n"
+        "prb_Process procs[2] = {prb_createProcessArgv(argv0, spec), prb_createProcessArgv(argv1, spec)};\n"
+        "if (argc > 1 && argv[1][0] == 'h') {\n"
+        "    prb_launchProcesses(&arena, procs, 2, prb_Background_Yes);\n"
+        "    prb_ProcessCompletionIter iter = prb_createProcessCompletionIter(procs, 2);\n"
+        "    iter.holdBufferedOutput = true;\n"
+        "    while (prb_processCompletionIterNext(&iter)) {}\n"
+        "    prb_destroyProcessCompletionIter(&iter);\n"
+        "    prb_writeToStdout(prb_STR(\"x\\n\"));\n"
+        "    return prb_writeBufferedOutput(procs, 2) ? 0 : 1;\n"
+        "}\n"
+        "prb_ProcessPoolSpec poolSpec = {};\n"
+        "poolSpec.maxInFlight = 2;\n"
+        "poolSpec.outputInLaunchOrder = argc > 1 && argv[1][0] == 'o';\n"
+        "return prb_launchProcessPool(&arena, procs, 2, poolSpec) ? 0 : 1;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, childPath, child.ptr, child.len));
+    prb_Str     childExe = prb_replaceExt(arena, childPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s -lpthread", prb_LIT(childPath), prb_LIT(childExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+    prb_Str modes[] = {prb_STR("completion"), prb_STR("ordered"), prb_STR("hold")};
+    prb_Str expected[] = {prb_STR("b1\nb2\na1\na2\n"), prb_STR("a1\na2\nb1\nb2\n"), prb_STR("x\na1\na2\nb1\nb2\n")};
+    for (i32 modeIndex = 0; modeIndex < prb_arrayCount(modes); modeIndex++) {
+        prb_ProcessSpec spec = {};
+        spec.captureStdout = true;
+        spec.captureArena = arena;
+        prb_Process proc = prb_createProcess(prb_fmt(arena, "%.*s %.*s", prb_LIT(childExe), prb_LIT(modes[modeIndex])), spec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+        prb_assert(prb_streq(proc.capturedStdout, expected[modeIndex]));
+    }
+#else
+#error unimplemented
+#endif
+
+    // NOTE(khvorov) Nothing to write for processes that didn't buffer or haven't completed
+    {
+        prb_Process proc = prb_createProcess(prb_STR("true"), (prb_ProcessSpec) {});
+        prb_assert(prb_writeBufferedOutput(&proc, 1));
+        prb_assert(prb_writeBufferedOutput(0, 0));
+    }
+
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+function prb_WorkerJob
+createWorkerJob(prb_Arena* arena, prb_Str* args, i32 argCount, prb_Str input) {
+    prb_WorkerJob job = {};
+    job.request.args = prb_arenaAllocArray(arena, prb_Str, argCount);
+    prb_memcpy(job.request.args, args, argCount * (i32)sizeof(*args));
+    job.request.argCount = argCount;
+    job.request.input = (prb_Bytes) {(uint8_t*)input.ptr, input.len};
+    return job;
+}
+
+// NOTE(khvorov) Echo worker responses look like "pid:arg1:input"
+function i32
+getWorkerJobPid(prb_WorkerJob* job) {
+    prb_StrFindSpec colon = {};
+    colon.pattern = prb_STR(":");
+    prb_StrFindResult find = prb_strFind(prb_strFromBytes(job->response.output), colon);
+    prb_assert(find.found);
+    prb_ParseUintResult pid = prb_parseUint(find.beforeMatch, 10);
+    prb_assert(pid.success);
+    return (i32)pid.number;
+}
+
+function void
+test_workerPool(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) "crash" exits without responding, the second arg is a file to create so that it only happens once
+    prb_Str workerPath = prb_pathJoin(arena, dir, prb_STR("worker.c"));
+    prb_Str worker = prb_STR(
+        "#include \"../../cbuild.h\"\n"
+        "int main() {\n"
+        "prb_Arena arena = prb_createArenaFromVmem(1 * prb_GIGABYTE);\n"
+        "for (;;) {\n"
+        "    prb_TempMemory temp = prb_beginTempMemory(&arena);\n"
+        "    prb_WorkerRequest req = prb_readWorkerRequest(&arena);\n"
+        "    if (!req.valid) break;\n"
+        "    if (prb_streq(req.args[0], prb_STR(\"crash\"))) {\n"
+        "        if (req.argCount == 1) prb_terminate(1);\n"
+        "        if (!prb_isFile(&arena, req.args[1])) {prb_writeEntireFile(&arena, req.args[1], \"x\", 1); prb_terminate(1);}\n"
+        "    }\n"
+        "    prb_Str out = prb_fmt(&arena, \"%d:%.*s:%.*s\", (int)getpid(), prb_LIT(req.args[1]), req.input.len, (char*)req.input.data);\n"
+        "    int32_t exitCode = prb_streq(req.args[0], prb_STR(\"fail\")) ? 3 : 0;\n"
+        "    prb_writeWorkerResponse(exitCode, (prb_Bytes) {(uint8_t*)out.ptr, out.len});\n"
+        "    prb_endTempMemory(temp);\n"
+        "}\n"
+        "return 0;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, workerPath, worker.ptr, worker.len));
+    prb_Str     workerExe = prb_replaceExt(arena, workerPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s -lpthread", prb_LIT(workerPath), prb_LIT(workerExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+    prb_Argv workerArgv = prb_createArgv(arena, workerExe);
+
+    // NOTE(khvorov) Big inputs come back in the responses and don't fit in a pipe either way
+    prb_Str bigInput = {};
+    {
+        i32   bigLen = 300 * 1024;
+        char* bigBuf = prb_arenaAllocArray(arena, char, bigLen);
+        for (i32 byteIndex = 0; byteIndex < bigLen; byteIndex++) {
+            bigBuf[byteIndex] = (char)('a' + byteIndex % 26);
+        }
+        bigInput = (prb_Str) {bigBuf, bigLen};
+    }
+
+    {
+        prb_WorkerPoolSpec spec = {};
+        spec.workerCount = 2;
+        spec.maxInFlightPerWorker = 2;
+        prb_WorkerPool pool = prb_createWorkerPool(arena, workerArgv, spec);
+        prb_assert(pool.valid && pool.workerCount == 2);
+
+        i32            jobCount = 50;
+        prb_WorkerJob* jobs = prb_arenaAllocArray(arena, prb_WorkerJob, jobCount);
+        for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            prb_Str args[] = {prb_STR("echo"), prb_fmt(arena, "%d", jobIndex)};
+            prb_Str input = jobIndex % 10 == 0 ? bigInput : prb_fmt(arena, "in%d", jobIndex);
+            jobs[jobIndex] = createWorkerJob(arena, args, prb_arrayCount(args), input);
+        }
+
+        // NOTE(khvorov) The same two workers answer every time
+        i32 pids[2] = {(i32)pool.workers[0].process.pid, (i32)pool.workers[1].process.pid};
+        for (i32 runIndex = 0; runIndex < 2; runIndex++) {
+            prb_assert(prb_runWorkerJobs(arena, &pool, jobs, jobCount));
+            i32 jobsPerWorker[2] = {};
+            for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+                prb_WorkerJob* job = jobs + jobIndex;
+                prb_assert(job->response.received && job->response.exitCode == 0 && job->attempts == 1);
+                prb_assert(getWorkerJobPid(job) == pids[job->workerIndex]);
+                prb_Str expected = prb_fmt(arena, "%d:%d:%.*s", pids[job->workerIndex], jobIndex, job->request.input.len, (char*)job->request.input.data);
+                prb_assert(prb_streq(prb_strFromBytes(job->response.output), expected));
+                jobsPerWorker[job->workerIndex] += 1;
+            }
+            prb_assert(jobsPerWorker[0] > 0 && jobsPerWorker[1] > 0);
+        }
+        prb_assert(pool.workers[0].startCount == 1 && pool.workers[1].startCount == 1);
+
+        // NOTE(khvorov) Exit codes come from the response and don't take the worker down
+        {
+            prb_Str       args[] = {prb_STR("fail"), prb_STR("x")};
+            prb_WorkerJob job = createWorkerJob(arena, args, prb_arrayCount(args), prb_STR(""));
+            prb_assert(prb_runWorkerJobs(arena, &pool, &job, 1) == prb_Failure);
+            prb_assert(job.response.received && job.response.exitCode == 3);
+        }
+
+        prb_destroyWorkerPool(&pool);
+        prb_assert(!pool.valid);
+        prb_assert(pool.workers[0].process.status == prb_ProcessStatus_CompletedSuccess);
+        prb_assert(pool.workers[1].process.status == prb_ProcessStatus_CompletedSuccess);
+    }
+
+    // NOTE(khvorov) Crashed workers are restarted and their requests are sent again
+    {
+        prb_WorkerPoolSpec spec = {};
+        spec.workerCount = 1;
+        spec.maxInFlightPerWorker = 3;
+        spec.maxRestarts = 5;
+        spec.maxRetries = 1;
+        prb_WorkerPool pool = prb_createWorkerPool(arena, workerArgv, spec);
+        prb_assert(pool.valid);
+
+        prb_Str       marker = prb_pathJoin(arena, dir, prb_STR("crashed-once"));
+        prb_Str       crashOnceArgs[] = {prb_STR("crash"), marker};
+        prb_Str       crashArgs[] = {prb_STR("crash")};
+        prb_Str       echoArgs[] = {prb_STR("echo"), prb_STR("e")};
+        prb_WorkerJob jobs[] = {
+            createWorkerJob(arena, echoArgs, prb_arrayCount(echoArgs), prb_STR("1")),
+            createWorkerJob(arena, crashOnceArgs, prb_arrayCount(crashOnceArgs), prb_STR("2")),
+            createWorkerJob(arena, echoArgs, prb_arrayCount(echoArgs), prb_STR("3")),
+            createWorkerJob(arena, crashArgs, prb_arrayCount(crashArgs), prb_STR("4")),
+            createWorkerJob(arena, echoArgs, prb_arrayCount(echoArgs), prb_STR("5")),
+        };
+        prb_assert(prb_runWorkerJobs(arena, &pool, jobs, prb_arrayCount(jobs)) == prb_Failure);
+        prb_assert(jobs[0].response.received && jobs[0].attempts == 1);
+        prb_assert(jobs[1].response.received && jobs[1].attempts == 2);
+        prb_assert(jobs[2].response.received && jobs[2].attempts == 1);
+        prb_assert(jobs[4].response.received && jobs[4].attempts == 1);
+        prb_assert(!jobs[3].response.received && jobs[3].attempts == 2);
+        // NOTE(khvorov) Crash-once crashes once, crash crashes on both attempts
+        prb_assert(pool.restartCount == 3 && pool.workers[0].startCount == 4);
+
+        prb_assert(prb_runWorkerJobs(arena, &pool, jobs + 4, 1));
+        prb_assert(getWorkerJobPid(jobs + 4) == (i32)pool.workers[0].process.pid);
+        prb_destroyWorkerPool(&pool);
+    }
+
+    // NOTE(khvorov) Nothing gets a response once the workers are gone for good
+    {
+        prb_WorkerPoolSpec spec = {};
+        spec.workerCount = 1;
+        prb_WorkerPool pool = prb_createWorkerPool(arena, workerArgv, spec);
+        prb_Str        crashArgs[] = {prb_STR("crash")};
+        prb_Str        echoArgs[] = {prb_STR("echo"), prb_STR("e")};
+        prb_WorkerJob  jobs[] = {
+            createWorkerJob(arena, crashArgs, prb_arrayCount(crashArgs), prb_STR("")),
+            createWorkerJob(arena, echoArgs, prb_arrayCount(echoArgs), prb_STR("")),
+        };
+        prb_assert(prb_runWorkerJobs(arena, &pool, jobs, prb_arrayCount(jobs)) == prb_Failure);
+        prb_assert(!jobs[0].response.received && !jobs[1].response.received);
+        prb_assert(jobs[0].attempts == 1);
+        prb_destroyWorkerPool(&pool);
+    }
+
+    // NOTE(khvorov) Executables that don't exist
+    {
+        prb_WorkerPool pool = prb_createWorkerPool(arena, prb_createArgv(arena, prb_STR("prb_not_an_executable_anywhere")), (prb_WorkerPoolSpec) {});
+        prb_assert(!pool.valid);
+    }
+#elif prb_PLATFORM_WINDOWS
+    prb_WorkerPool pool = prb_createWorkerPool(arena, prb_createArgv(arena, prb_STR("cmd")), (prb_WorkerPoolSpec) {});
+    prb_assert(!pool.valid);
+#else
+#error unimplemented
+#endif
+
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+typedef struct SharedJobserverPool {
+    prb_Process*        procs;
+    i32                 procCount;
+    prb_ProcessPoolSpec spec;
+    prb_Status          result;
+} SharedJobserverPool;
+
+function void
+sharedJobserverPoolJob(prb_Arena* arena, void* data) {
+    SharedJobserverPool* pool = (SharedJobserverPool*)data;
+    pool->result = prb_launchProcessPool(arena, pool->procs, pool->procCount, pool->spec);
+}
+
+function void
+test_jobserver(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    prb_Str* exes = compileSleepAndExitProgs(arena, dir);
+
+    prb_Str childPath = prb_pathJoin(arena, dir, prb_STR("child.c"));
+    prb_Str child = prb_STR(
+        "#include \"../../cbuild.h\"\n"
+        "int main() {\n"
+        "prb_Arena arena = prb_createArenaFromVmem(1 * prb_MEGABYTE);\n"
+        "prb_Jobserver jobserver = prb_connectJobserver(&arena);\n"
+        "if (!jobserver.valid) return 1;\n"
+        "if (!prb_jobserverTryAcquire(&jobserver)) return 2;\n"
+        "if (!prb_jobserverTryAcquire(&jobserver)) return 3;\n"
+        "if (prb_jobserverTryAcquire(&jobserver)) return 4;\n"
+        "prb_destroyJobserver(&arena, &jobserver);\n"
+        "return 0;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, childPath, child.ptr, child.len));
+    prb_Str     childExe = prb_replaceExt(arena, childPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(childPath), prb_LIT(childExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+    prb_GetenvResult makeflagsBefore = prb_getenv(arena, prb_STR("MAKEFLAGS"));
+    if (makeflagsBefore.found) {
+        makeflagsBefore.str = prb_fmt(arena, "%.*s", prb_LIT(makeflagsBefore.str));
+    }
+
+    prb_JobserverKind kinds[] = {prb_JobserverKind_Fifo, prb_JobserverKind_Pipe};
+    for (i32 kindIndex = 0; kindIndex < prb_arrayCount(kinds); kindIndex++) {
+        prb_Jobserver server = prb_createJobserver(arena, 3, kinds[kindIndex]);
+        prb_assert(server.valid);
+        prb_GetenvResult makeflags = prb_getenv(arena, prb_STR("MAKEFLAGS"));
+        prb_assert(makeflags.found && prb_strEndsWith(makeflags.str, server.makeflags));
+        prb_assert(prb_strStartsWith(server.makeflags, prb_STR("-j3 --jobserver-auth=")));
+
+        // NOTE(khvorov) Implicit token and one from the pipe, leaves one for the child
+        prb_assert(prb_jobserverAcquire(&server));
+        prb_assert(prb_jobserverTryAcquire(&server));
+        prb_assert(server.heldTokenCount == 1);
+
+        {
+            prb_Process proc = prb_createProcess(childExe, (prb_ProcessSpec) {});
+            prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No));
+        }
+
+        // NOTE(khvorov) Client in the same process
+        {
+            prb_Jobserver client = prb_connectJobserver(arena);
+            prb_assert(client.valid && !client.isServer);
+            prb_assert(prb_jobserverTryAcquire(&client));
+            prb_assert(prb_jobserverTryAcquire(&client));
+            prb_assert(prb_jobserverTryAcquire(&client) == prb_Failure);
+            prb_assert(prb_jobserverTryAcquire(&server) == prb_Failure);
+            prb_destroyJobserver(arena, &client);
+            prb_assert(!client.valid);
+        }
+
+        prb_assert(prb_jobserverTryAcquire(&server));
+        prb_assert(prb_jobserverTryAcquire(&server) == prb_Failure);
+        prb_assert(prb_jobserverRelease(&server));
+        prb_assert(prb_jobserverRelease(&server));
+        prb_assert(prb_jobserverRelease(&server));
+        prb_assert(prb_jobserverRelease(&server) == prb_Failure);
+        prb_assert(server.heldTokenCount == 0 && !server.implicitTokenTaken);
+
+        prb_destroyJobserver(arena, &server);
+        makeflags = prb_getenv(arena, prb_STR("MAKEFLAGS"));
+        prb_assert(makeflags.found == makeflagsBefore.found);
+        prb_assert(!makeflags.found || prb_streq(makeflags.str, makeflagsBefore.str));
+    }
+
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) The fifo goes in its own directory under TMPDIR and both are removed afterwards
+    {
+        prb_GetenvResult tmpdirBefore = prb_getenv(arena, prb_STR("TMPDIR"));
+        if (tmpdirBefore.found) {
+            tmpdirBefore.str = prb_fmt(arena, "%.*s", prb_LIT(tmpdirBefore.str));
+        }
+        prb_assert(prb_setenv(arena, prb_STR("TMPDIR"), dir));
+
+        prb_Jobserver server = prb_createJobserver(arena, 2, prb_JobserverKind_Fifo);
+        prb_assert(server.valid);
+        prb_Str fifoDir = prb_getParentDir(arena, server.fifoPath);
+        prb_assert(prb_strStartsWith(fifoDir, dir) && fifoDir.len > dir.len + 1);
+        prb_assert(prb_isDir(arena, fifoDir));
+        prb_destroyJobserver(arena, &server);
+        prb_assert(!prb_pathExists(arena, fifoDir));
+
+        if (tmpdirBefore.found) {
+            prb_assert(prb_setenv(arena, prb_STR("TMPDIR"), tmpdirBefore.str));
+        } else {
+            prb_assert(prb_unsetenv(arena, prb_STR("TMPDIR")));
+        }
+    }
+#endif
+
+    // NOTE(khvorov) Pool with a single token runs processes one at a time
+    {
+        prb_Jobserver server = prb_createJobserver(arena, 1, prb_JobserverKind_Pipe);
+        prb_assert(server.valid);
+        prb_Process procs[2] = {prb_createProcess(exes[0], (prb_ProcessSpec) {}), prb_createProcess(exes[0], (prb_ProcessSpec) {})};
+        prb_ProcessPoolSpec spec = {};
+        spec.jobserver = &server;
+        prb_TimeStart poolStart = prb_timeStart();
+        prb_assert(prb_launchProcessPool(arena, procs, prb_arrayCount(procs), spec));
+        prb_assert(prb_getMsFrom(poolStart) >= 600.0f);
+        prb_assert(!server.implicitTokenTaken);
+        prb_destroyJobserver(arena, &server);
+    }
+
+    // NOTE(khvorov) Pools on different threads sharing a single token take turns
+    {
+        prb_Str probeExe = compileOverlapProbeProg(arena, dir);
+        prb_Str markerDir = prb_pathJoin(arena, dir, prb_STR("shared"));
+        prb_assert(prb_clearDir(arena, markerDir));
+        prb_Jobserver server = prb_createJobserver(arena, 1, prb_JobserverKind_Pipe);
+        prb_assert(server.valid);
+
+        i32                 procsPerPool = 3;
+        SharedJobserverPool pools[2] = {};
+        prb_Job             jobs[2] = {};
+        for (i32 poolIndex = 0; poolIndex < prb_arrayCount(pools); poolIndex++) {
+            SharedJobserverPool* pool = pools + poolIndex;
+            pool->procs = prb_arenaAllocArray(arena, prb_Process, procsPerPool);
+            pool->procCount = procsPerPool;
+            pool->spec.jobserver = &server;
+            for (i32 procIndex = 0; procIndex < procsPerPool; procIndex++) {
+                i32     probeIndex = poolIndex * procsPerPool + procIndex;
+                prb_Str cmd = prb_fmt(arena, "%.*s %.*s %d %d alone", prb_LIT(probeExe), prb_LIT(markerDir), probeIndex, procsPerPool * prb_arrayCount(pools));
+                pool->procs[procIndex] = prb_createProcess(cmd, (prb_ProcessSpec) {});
+            }
+            jobs[poolIndex] = prb_createJob(sharedJobserverPoolJob, pool, arena, 1 * prb_MEGABYTE);
+        }
+        prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+        for (i32 poolIndex = 0; poolIndex < prb_arrayCount(pools); poolIndex++) {
+            prb_assert(pools[poolIndex].result == prb_Success);
+        }
+        prb_assert(!server.implicitTokenTaken && server.heldTokenCount == 0);
+        prb_destroyJobserver(arena, &server);
+    }
+
+    arrfree(exes);
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_sleep(prb_Arena* arena) {
+    prb_unused(arena);
+    prb_TimeStart timeStart = prb_timeStart();
+    float         sleepMs = 10.9f;
+    prb_sleep(sleepMs);
+    float ms = prb_getMsFrom(timeStart);
+    prb_assert(ms >= sleepMs);
+}
+
+function void
+test_debuggerPresent(prb_Arena* arena) {
+    // NOTE(khvorov) Just make sure the code executes somewhere, I don't know how to actually test it automatically
+    prb_debuggerPresent(arena);
+}
+
+function void
+test_env(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        name = prb_STR(__FUNCTION__);
+    prb_Str        value = prb_STR("test");
+    prb_Str        value2 = prb_STR("test太阳😐2");
+    prb_unsetenv(arena, name);
+    prb_assert(!prb_getenv(arena, name).found);
+
+    prb_assert(prb_setenv(arena, name, value));
+    prb_GetenvResult getRes = prb_getenv(arena, name);
+    prb_assert(getRes.found);
+    prb_assert(prb_streq(getRes.str, value));
+
+    prb_assert(prb_setenv(arena, name, value2));
+    getRes = prb_getenv(arena, name);
+    prb_assert(getRes.found);
+    prb_assert(prb_streq(getRes.str, value2));
+
+    prb_assert(prb_unsetenv(arena, name));
+    prb_assert(!prb_getenv(arena, name).found);
+    prb_endTempMemory(temp);
+}
+
+function void
+test_createEnv(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    prb_assert(prb_setenv(arena, prb_STR("PRB_TEST_ENV_INHERITED"), prb_STR("inherited")));
+    prb_assert(prb_setenv(arena, prb_STR("PRB_TEST_ENV_OVERRIDDEN"), prb_STR("old")));
+    prb_Env env = prb_createEnv(arena, prb_STR(" PRB_TEST_ENV_NEW=new  PRB_TEST_ENV_OVERRIDDEN=new "));
+#if prb_PLATFORM_LINUX
+    // NOTE(khvorov) Inherited entries are copies since setenv/unsetenv can free the originals
+    for (i32 entryIndex = 0; entryIndex < env.count; entryIndex++) {
+        for (char** existingEntry = __environ; *existingEntry != 0; existingEntry++) {
+            prb_assert(env.entries[entryIndex] != *existingEntry);
+        }
+    }
+#endif
+    prb_assert(prb_unsetenv(arena, prb_STR("PRB_TEST_ENV_INHERITED")));
+    prb_assert(prb_unsetenv(arena, prb_STR("PRB_TEST_ENV_OVERRIDDEN")));
+
+    prb_assert(env.valid);
+    prb_assert(env.entries[env.count] == 0);
+    prb_assert(prb_streq(prb_STR(env.entries[0]), prb_STR("PRB_TEST_ENV_NEW=new")));
+    prb_assert(prb_streq(prb_STR(env.entries[1]), prb_STR("PRB_TEST_ENV_OVERRIDDEN=new")));
+    i32 overriddenCount = 0;
+    i32 inheritedCount = 0;
+    for (i32 entryIndex = 0; entryIndex < env.count; entryIndex++) {
+        prb_Str entry = prb_STR(env.entries[entryIndex]);
+        overriddenCount += prb_strStartsWith(entry, prb_STR("PRB_TEST_ENV_OVERRIDDEN="));
+        inheritedCount += prb_streq(entry, prb_STR("PRB_TEST_ENV_INHERITED=inherited"));
+    }
+    prb_assert(overriddenCount == 1);
+    prb_assert(inheritedCount == 1);
+
+    prb_assert(!prb_createEnv(arena, prb_STR("PRB_TEST_ENV_NEW")).valid);
+    prb_assert(!prb_createEnv(arena, prb_STR("=new")).valid);
+    prb_assert(prb_createEnv(arena, prb_STR("")).valid);
+
+    prb_Str progPath = prb_pathJoin(arena, dir, prb_STR("env.c"));
+    prb_Str prog = prb_STR(
+        "char *getenv(const char *name);\n"
+        "int strcmp(const char* s1, const char* s2);\n"
+        "int main() {\n"
+        "char* newVar = getenv(\"PRB_TEST_ENV_NEW\");\n"
+        "char* overridden = getenv(\"PRB_TEST_ENV_OVERRIDDEN\");\n"
+        "char* inherited = getenv(\"PRB_TEST_ENV_INHERITED\");\n"
+        "if (newVar == 0 || strcmp(newVar, \"new\") != 0) return 1;\n"
+        "if (overridden == 0 || strcmp(overridden, \"new\") != 0) return 1;\n"
+        "if (inherited == 0 || strcmp(inherited, \"inherited\") != 0) return 1;\n"
+        "return 0;\n"
+        "}\n"
+    );
+    prb_assert(prb_writeEntireFile(arena, progPath, prog.ptr, prog.len));
+    prb_Str     progExe = prb_replaceExt(arena, progPath, prb_STR("exe"));
+    prb_Process compileProc = prb_createProcess(prb_fmt(arena, "clang %.*s -o %.*s", prb_LIT(progPath), prb_LIT(progExe)), (prb_ProcessSpec) {});
+    prb_assert(prb_launchProcesses(arena, &compileProc, 1, prb_Background_No));
+
+    {
+        prb_ProcessSpec spec = {};
+        spec.env = &env;
+        prb_Process procs[4];
+        for (i32 procIndex = 0; procIndex < prb_arrayCount(procs); procIndex++) {
+            procs[procIndex] = prb_createProcess(progExe, spec);
+        }
+        prb_assert(prb_launchProcesses(arena, procs, prb_arrayCount(procs), prb_Background_Yes));
+        prb_assert(prb_waitForProcesses(procs, prb_arrayCount(procs)));
+    }
+
+    {
+        prb_Process proc = prb_createProcess(progExe, (prb_ProcessSpec) {});
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+    }
+
+    {
+        prb_Env         badEnv = prb_createEnv(arena, prb_STR("bad"));
+        prb_ProcessSpec spec = {};
+        spec.env = &badEnv;
+        prb_Process proc = prb_createProcess(progExe, spec);
+        prb_assert(prb_launchProcesses(arena, &proc, 1, prb_Background_No) == prb_Failure);
+        prb_assert(proc.status == prb_ProcessStatus_NotLaunched);
+    }
+
+    prb_removePathIfExists(arena, dir);
     prb_endTempMemory(temp);
 }
 
@@ -2762,6 +4686,82 @@ test_timer(prb_Arena* arena) {
 // SECTION Multithreading
 //
 
+typedef struct CasIncrementData {
+    int64_t* counter;
+    i32      incrementCount;
+} CasIncrementData;
+
+// NOTE(khvorov) Increments with a compare exchange loop so that lost updates would show up in the total
+function void
+casIncrementJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    CasIncrementData* increment = (CasIncrementData*)data;
+    for (i32 index = 0; index < increment->incrementCount; index++) {
+        int64_t expected = prb_atomicLoadI64(increment->counter, prb_MemoryOrder_Relaxed);
+        while (!prb_atomicCasI64(increment->counter, &expected, expected + 1, prb_MemoryOrder_AcqRel)) {}
+    }
+}
+
+function void
+test_atomics(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    {
+        int32_t value = 0;
+        prb_atomicStoreI32(&value, 5, prb_MemoryOrder_Release);
+        prb_assert(prb_atomicLoadI32(&value, prb_MemoryOrder_Acquire) == 5);
+        prb_assert(prb_atomicExchangeI32(&value, 7, prb_MemoryOrder_AcqRel) == 5);
+        prb_assert(prb_atomicFetchAddI32(&value, -2, prb_MemoryOrder_Relaxed) == 7);
+        int32_t expected = 4;
+        prb_assert(!prb_atomicCasI32(&value, &expected, 10, prb_MemoryOrder_SeqCst));
+        prb_assert(expected == 5 && value == 5);
+        prb_assert(prb_atomicCasI32(&value, &expected, 10, prb_MemoryOrder_SeqCst));
+        prb_assert(expected == 5 && value == 10);
+    }
+
+    {
+        int64_t value = 0;
+        int64_t big = (int64_t)1 << 40;
+        prb_atomicStoreI64(&value, big, prb_MemoryOrder_SeqCst);
+        prb_assert(prb_atomicLoadI64(&value, prb_MemoryOrder_Relaxed) == big);
+        prb_assert(prb_atomicExchangeI64(&value, big + 1, prb_MemoryOrder_SeqCst) == big);
+        prb_assert(prb_atomicFetchAddI64(&value, big, prb_MemoryOrder_AcqRel) == big + 1);
+        int64_t expected = 0;
+        prb_assert(!prb_atomicCasI64(&value, &expected, 1, prb_MemoryOrder_Release));
+        prb_assert(expected == 2 * big + 1);
+        prb_assert(prb_atomicCasI64(&value, &expected, 1, prb_MemoryOrder_Release));
+        prb_assert(value == 1);
+    }
+
+    {
+        i32   targets[2] = {};
+        void* value = 0;
+        prb_atomicStorePtr(&value, targets, prb_MemoryOrder_Release);
+        prb_atomicFence(prb_MemoryOrder_SeqCst);
+        prb_assert(prb_atomicLoadPtr(&value, prb_MemoryOrder_Acquire) == targets);
+        prb_assert(prb_atomicExchangePtr(&value, targets + 1, prb_MemoryOrder_AcqRel) == targets);
+        void* expected = targets;
+        prb_assert(!prb_atomicCasPtr(&value, &expected, 0, prb_MemoryOrder_SeqCst));
+        prb_assert(expected == targets + 1);
+        prb_assert(prb_atomicCasPtr(&value, &expected, 0, prb_MemoryOrder_SeqCst));
+        prb_assert(value == 0);
+    }
+
+    {
+        int64_t          counter = 0;
+        CasIncrementData data = {&counter, 10000};
+        prb_Job          jobs[4] = {};
+        for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+            jobs[jobIndex] = prb_createJob(casIncrementJob, &data, arena, 0);
+        }
+        prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+        prb_assert(counter == data.incrementCount * prb_arrayCount(jobs));
+    }
+
+    prb_endTempMemory(temp);
+}
+
 function void
 randomJob(prb_Arena* arena, void* data) {
     prb_unused(arena);
@@ -2804,6 +4804,670 @@ test_jobs(prb_Arena* arena) {
     prb_endTempMemory(temp);
 }
 
+function void
+countJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    i32* count = (i32*)data;
+    *count += 1;
+}
+
+typedef struct SumJobData {
+    prb_ThreadPool* pool;
+    i32             from;
+    i32             to;
+    int64_t         sum;
+} SumJobData;
+
+// NOTE(khvorov) Splits the range in two and waits for both halves, so jobs launch jobs from the workers
+function void
+sumJob(prb_Arena* arena, void* data) {
+    SumJobData* sum = (SumJobData*)data;
+    if (sum->to - sum->from <= 16) {
+        for (i32 num = sum->from; num < sum->to; num++) {
+            sum->sum += num;
+        }
+    } else {
+        i32        mid = sum->from + (sum->to - sum->from) / 2;
+        SumJobData halves[] = {{sum->pool, sum->from, mid, 0}, {sum->pool, mid, sum->to, 0}};
+        prb_Job    jobs[] = {prb_createJob(sumJob, halves + 0, arena, 0), prb_createJob(sumJob, halves + 1, arena, 0)};
+        jobs[0].pool = sum->pool;
+        jobs[1].pool = sum->pool;
+        prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+        sum->sum = halves[0].sum + halves[1].sum;
+    }
+}
+
+function void
+test_threadPool(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    {
+        prb_ThreadPool*     pool = prb_createThreadPool(arena, 0, 0);
+        prb_CoreCountResult cores = prb_getAllowExecutionCoreCount(arena);
+        prb_assert(pool->valid && cores.success && pool->workerCount == cores.cores);
+        prb_assert(pool->workers[0].scratch.size == prb_MEGABYTE);
+        prb_destroyThreadPool(pool);
+        prb_assert(!pool->valid);
+    }
+
+    prb_ThreadPool* pool = prb_createThreadPool(arena, 4, 64 * prb_KILOBYTE);
+    prb_assert(pool->valid && pool->workerCount == 4 && pool->workers[3].scratch.size == 64 * prb_KILOBYTE);
+
+    // NOTE(khvorov) More than fits in the deques
+    {
+        i32      jobCount = 20000;
+        prb_Job* jobs = prb_arenaAllocArray(arena, prb_Job, jobCount);
+        i32*     counts = prb_arenaAllocArray(arena, i32, jobCount);
+        for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            jobs[jobIndex] = prb_createJob(countJob, counts + jobIndex, arena, 0);
+            jobs[jobIndex].pool = pool;
+        }
+        prb_assert(prb_launchJobs(jobs, jobCount, prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, jobCount));
+        for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            prb_assert(jobs[jobIndex].status == prb_JobStatus_Completed);
+            prb_assert(counts[jobIndex] == 1);
+        }
+    }
+
+    // NOTE(khvorov) Jobs submitted and waited on from inside pool jobs
+    {
+        i32        count = 100000;
+        SumJobData sum = {pool, 0, count, 0};
+        prb_Job    job = prb_createJob(sumJob, &sum, arena, 0);
+        job.pool = pool;
+        prb_assert(prb_launchJobs(&job, 1, prb_Background_Yes));
+        prb_assert(prb_waitForJobs(&job, 1));
+        prb_assert(sum.sum == (int64_t)count * (count - 1) / 2);
+    }
+
+    // NOTE(khvorov) Jobs with and without a pool in one call, only the latter get their own threads
+    {
+        i32     counts[6] = {};
+        prb_Job jobs[6] = {};
+        for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+            jobs[jobIndex] = prb_createJob(countJob, counts + jobIndex, arena, 0);
+            jobs[jobIndex].pool = jobIndex % 3 == 0 ? 0 : pool;
+        }
+        prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+        for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+            prb_assert(counts[jobIndex] == 1);
+        }
+    }
+
+    // NOTE(khvorov) Whatever was submitted before destroy still runs
+    {
+        i32      jobCount = 1000;
+        prb_Job* jobs = prb_arenaAllocArray(arena, prb_Job, jobCount);
+        i32*     counts = prb_arenaAllocArray(arena, i32, jobCount);
+        for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            jobs[jobIndex] = prb_createJob(countJob, counts + jobIndex, arena, 0);
+            jobs[jobIndex].pool = pool;
+        }
+        prb_assert(prb_launchJobs(jobs, jobCount, prb_Background_Yes));
+        prb_destroyThreadPool(pool);
+        prb_assert(!pool->valid);
+        for (i32 jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            prb_assert(counts[jobIndex] == 1);
+        }
+    }
+
+    prb_endTempMemory(temp);
+}
+
+typedef struct OrderJobData {
+    i32* counter;
+    i32  order;
+} OrderJobData;
+
+function void
+orderJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    OrderJobData* job = (OrderJobData*)data;
+    job->order = prb_atomicFetchAddI32(job->counter, 1, prb_MemoryOrder_SeqCst);
+}
+
+typedef struct NestedGraphData {
+    prb_JobGraph*   graph;
+    prb_ThreadPool* pool;
+    prb_Status      result;
+    prb_Event       done;
+} NestedGraphData;
+
+function void
+nestedGraphJob(prb_Arena* arena, void* data) {
+    NestedGraphData* job = (NestedGraphData*)data;
+    job->result = prb_runJobGraph(arena, job->graph, job->pool);
+    prb_eventSet(&job->done);
+}
+
+function void
+test_jobGraph(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+    prb_Str        dir = getTempPath(arena, __FUNCTION__);
+    prb_assert(prb_clearDir(arena, dir));
+
+    prb_Str* exes = compileSleepAndExitProgs(arena, dir);
+
+    prb_ThreadPool* pool = prb_createThreadPool(arena, 4, 0);
+    prb_ThreadPool* poolOneThread = prb_createThreadPool(arena, 1, 0);
+    i32             counter = 0;
+    OrderJobData    data[4] = {};
+    prb_Job         jobs[4] = {};
+    for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+        data[jobIndex].counter = &counter;
+        jobs[jobIndex] = prb_createJob(orderJob, data + jobIndex, arena, 0);
+    }
+
+    // NOTE(khvorov) Diamond
+    {
+        prb_ThreadPool* pools[] = {pool, 0};
+        for (i32 poolIndex = 0; poolIndex < prb_arrayCount(pools); poolIndex++) {
+            counter = 0;
+            prb_JobGraph graph = {};
+            i32          top = prb_jobGraphAddJob(&graph, jobs + 0, 0);
+            i32          left = prb_jobGraphAddJob(&graph, jobs + 1, 0);
+            i32          right = prb_jobGraphAddJob(&graph, jobs + 2, 0);
+            i32          bottom = prb_jobGraphAddJob(&graph, jobs + 3, 0);
+            prb_jobGraphAddDep(&graph, bottom, left);
+            prb_jobGraphAddDep(&graph, bottom, right);
+            prb_jobGraphAddDep(&graph, left, top);
+            prb_jobGraphAddDep(&graph, right, top);
+            prb_assert(prb_runJobGraph(arena, &graph, pools[poolIndex]));
+            for (i32 nodeIndex = 0; nodeIndex < 4; nodeIndex++) {
+                prb_assert(graph.nodes[nodeIndex].status == prb_JobGraphNodeStatus_Completed);
+                prb_assert(jobs[nodeIndex].status == prb_JobStatus_Completed);
+            }
+            prb_assert(counter == 4);
+            prb_assert(data[0].order == 0 && data[3].order == 3);
+            prb_assert(graph.nodes[top].criticalPathCost == 3);
+            prb_destroyJobGraph(&graph);
+            for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+                jobs[jobIndex].status = prb_JobStatus_NotLaunched;
+            }
+        }
+    }
+
+    // NOTE(khvorov) With one thread the longest chain goes first even though the short one was added first
+    {
+        counter = 0;
+        prb_JobGraph graph = {};
+        i32          shortNode = prb_jobGraphAddJob(&graph, jobs + 0, 1);
+        i32          longFirst = prb_jobGraphAddJob(&graph, jobs + 1, 1);
+        i32          longSecond = prb_jobGraphAddJob(&graph, jobs + 2, 10);
+        prb_jobGraphAddDep(&graph, longSecond, longFirst);
+        prb_assert(prb_runJobGraph(arena, &graph, poolOneThread));
+        prb_assert(graph.nodes[shortNode].criticalPathCost == 1);
+        prb_assert(graph.nodes[longFirst].criticalPathCost == 11);
+        prb_assert(data[1].order == 0 && data[2].order == 1 && data[0].order == 2);
+        prb_destroyJobGraph(&graph);
+    }
+
+    // NOTE(khvorov) Processes, failures skip everything downstream but not the rest
+    {
+        counter = 0;
+        prb_Process  procs[] = {prb_createProcess(exes[1], (prb_ProcessSpec) {}), prb_createProcess(exes[2], (prb_ProcessSpec) {})};
+        prb_JobGraph graph = {};
+        i32          trueNode = prb_jobGraphAddProcess(&graph, procs + 0, 0);
+        i32          falseNode = prb_jobGraphAddProcess(&graph, procs + 1, 0);
+        i32          afterTrue = prb_jobGraphAddJob(&graph, jobs + 0, 0);
+        i32          afterFalse = prb_jobGraphAddJob(&graph, jobs + 1, 0);
+        i32          afterAfterFalse = prb_jobGraphAddJob(&graph, jobs + 2, 0);
+        prb_jobGraphAddDep(&graph, afterTrue, trueNode);
+        prb_jobGraphAddDep(&graph, afterFalse, falseNode);
+        prb_jobGraphAddDep(&graph, afterFalse, trueNode);
+        prb_jobGraphAddDep(&graph, afterAfterFalse, afterFalse);
+        prb_assert(prb_runJobGraph(arena, &graph, pool) == prb_Failure);
+        prb_assert(procs[0].status == prb_ProcessStatus_CompletedSuccess);
+        prb_assert(procs[1].status == prb_ProcessStatus_CompletedFailed);
+        prb_assert(graph.nodes[trueNode].status == prb_JobGraphNodeStatus_Completed);
+        prb_assert(graph.nodes[falseNode].status == prb_JobGraphNodeStatus_Failed);
+        prb_assert(graph.nodes[afterTrue].status == prb_JobGraphNodeStatus_Completed);
+        prb_assert(graph.nodes[afterFalse].status == prb_JobGraphNodeStatus_Skipped);
+        prb_assert(graph.nodes[afterAfterFalse].status == prb_JobGraphNodeStatus_Skipped);
+        prb_assert(counter == 1);
+        prb_destroyJobGraph(&graph);
+    }
+
+    // NOTE(khvorov) Graph run from a job on the same pool, the only worker is busy running the graph itself
+    {
+        counter = 0;
+        prb_JobGraph graph = {};
+        i32          first = prb_jobGraphAddJob(&graph, jobs + 0, 0);
+        i32          second = prb_jobGraphAddJob(&graph, jobs + 1, 0);
+        prb_jobGraphAddJob(&graph, jobs + 2, 0);
+        prb_jobGraphAddDep(&graph, second, first);
+        NestedGraphData nestedData = {&graph, poolOneThread, prb_Failure, {}};
+        prb_Job         nestedJob = prb_createJob(nestedGraphJob, &nestedData, arena, 1 * prb_MEGABYTE);
+        nestedJob.pool = poolOneThread;
+        prb_assert(prb_launchJobs(&nestedJob, 1, prb_Background_Yes));
+        // NOTE(khvorov) Waiting on the job would help run the graph's jobs and hide the problem.
+        // If the worker gets stuck, so does the test
+        prb_eventWait(&nestedData.done);
+        prb_assert(prb_waitForJobs(&nestedJob, 1));
+        prb_assert(nestedData.result == prb_Success);
+        prb_assert(counter == 3 && data[0].order < data[1].order);
+        prb_destroyJobGraph(&graph);
+    }
+
+    // NOTE(khvorov) Cycles are rejected before anything runs
+    {
+        counter = 0;
+        prb_JobGraph graph = {};
+        prb_jobGraphAddJob(&graph, jobs + 0, 0);
+        i32 first = prb_jobGraphAddJob(&graph, jobs + 1, 0);
+        i32 second = prb_jobGraphAddJob(&graph, jobs + 2, 0);
+        i32 third = prb_jobGraphAddJob(&graph, jobs + 3, 0);
+        prb_jobGraphAddDep(&graph, second, first);
+        prb_jobGraphAddDep(&graph, third, second);
+        prb_jobGraphAddDep(&graph, first, third);
+        prb_assert(prb_runJobGraph(arena, &graph, pool) == prb_Failure);
+        prb_assert(counter == 0);
+        for (i32 nodeIndex = 0; nodeIndex < 4; nodeIndex++) {
+            prb_assert(graph.nodes[nodeIndex].status == prb_JobGraphNodeStatus_NotStarted);
+        }
+        prb_destroyJobGraph(&graph);
+    }
+
+    prb_destroyThreadPool(pool);
+    prb_destroyThreadPool(poolOneThread);
+    arrfree(exes);
+    prb_removePathIfExists(arena, dir);
+    prb_endTempMemory(temp);
+}
+
+typedef struct SquareData {
+    i32*    squares;
+    i32*    visits;
+    i32*    calls;
+    int32_t maxRange;
+} SquareData;
+
+function void
+squareRange(prb_Arena* scratch, void* data, int32_t from, int32_t to) {
+    SquareData* square = (SquareData*)data;
+    prb_assert(from < to && to - from <= square->maxRange);
+    prb_atomicFetchAddI32(square->calls, 1, prb_MemoryOrder_Relaxed);
+    // NOTE(khvorov) Would run out of scratch quickly if it wasn't reset between chunks
+    uint8_t* junk = prb_arenaAllocArray(scratch, uint8_t, 64 * prb_KILOBYTE);
+    junk[0] = 1;
+    for (i32 index = from; index < to; index++) {
+        square->squares[index] = index * index;
+        prb_atomicFetchAddI32(square->visits + index, 1, prb_MemoryOrder_Relaxed);
+    }
+}
+
+function void
+sumRange(prb_Arena* scratch, void* data, int32_t from, int32_t to) {
+    prb_unused(scratch);
+    prb_assert(from >= 0 && from < to);
+    prb_atomicFetchAddI64((int64_t*)data, (int64_t)to - from, prb_MemoryOrder_Relaxed);
+}
+
+function void
+test_parallelFor(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    prb_ThreadPool* pool = prb_createThreadPool(arena, 4, 0);
+    i32             count = 20000;
+    i32*            squares = prb_arenaAllocArray(arena, i32, count);
+    i32*            visits = prb_arenaAllocArray(arena, i32, count);
+
+    prb_ThreadPool* pools[] = {pool, 0};
+    i32             grainSizes[] = {0, 1, 7, count, count * 2};
+    for (i32 poolIndex = 0; poolIndex < prb_arrayCount(pools); poolIndex++) {
+        for (i32 grainIndex = 0; grainIndex < prb_arrayCount(grainSizes); grainIndex++) {
+            i32        grainSize = grainSizes[grainIndex];
+            i32        calls = 0;
+            SquareData data = {squares, visits, &calls, grainSize > 0 ? grainSize : count};
+            prb_memset(visits, 0, (size_t)count * sizeof(i32));
+            prb_memset(squares, 0, (size_t)count * sizeof(i32));
+
+            void* freePtrBefore = prb_arenaFreePtr(arena);
+            prb_parallelFor(arena, pools[poolIndex], count, grainSize, squareRange, &data);
+            prb_assert(prb_arenaFreePtr(arena) == freePtrBefore);
+
+            for (i32 index = 0; index < count; index++) {
+                prb_assert(visits[index] == 1 && squares[index] == index * index);
+            }
+            if (grainSize > 0) {
+                prb_assert(calls == (count + grainSize - 1) / grainSize);
+            }
+        }
+    }
+
+    {
+        i32        calls = 0;
+        SquareData data = {squares, visits, &calls, 1};
+        prb_parallelFor(arena, pool, 0, 1, squareRange, &data);
+        prb_assert(calls == 0);
+    }
+
+    // NOTE(khvorov) Every thread steps past the end, which is past the max of a 32 bit index here
+    {
+        int64_t total = 0;
+        prb_parallelFor(arena, pool, INT32_MAX, INT32_MAX / 2, sumRange, &total);
+        prb_assert(total == INT32_MAX);
+    }
+
+    prb_destroyThreadPool(pool);
+    prb_endTempMemory(temp);
+}
+
+typedef struct QueueJobData {
+    prb_MpmcQueue* queue;
+    i32*           seen;
+    i32*           poppedCount;
+    i32            totalCount;
+    i32            from;
+    i32            to;
+} QueueJobData;
+
+// NOTE(khvorov) Values are index + 1 so that none of them is a null pointer
+function void
+queueProducerJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    QueueJobData* job = (QueueJobData*)data;
+    for (i32 index = job->from; index < job->to; index++) {
+        while (!prb_mpmcQueuePush(job->queue, (void*)(intptr_t)(index + 1))) {
+            prb_sleep(0);
+        }
+    }
+}
+
+function void
+queueConsumerJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    QueueJobData* job = (QueueJobData*)data;
+    while (prb_atomicLoadI32(job->poppedCount, prb_MemoryOrder_Relaxed) < job->totalCount) {
+        prb_MpmcQueuePopResult pop = prb_mpmcQueuePop(job->queue);
+        if (pop.success) {
+            i32 index = (i32)(intptr_t)pop.value - 1;
+            prb_atomicFetchAddI32(job->seen + index, 1, prb_MemoryOrder_Relaxed);
+            prb_atomicFetchAddI32(job->poppedCount, 1, prb_MemoryOrder_Relaxed);
+        } else {
+            // NOTE(khvorov) Let the producers run when there are fewer cores than threads
+            prb_sleep(0);
+        }
+    }
+}
+
+function void
+test_mpmcQueue(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    {
+        prb_MpmcQueue queue = prb_createMpmcQueue(arena, 5);
+        prb_assert(queue.mask == 7);
+        prb_assert(!prb_mpmcQueuePop(&queue).success);
+        i32 values[8] = {};
+        for (i32 round = 0; round < 3; round++) {
+            for (i32 index = 0; index < 8; index++) {
+                prb_assert(prb_mpmcQueuePush(&queue, values + index));
+            }
+            prb_assert(prb_mpmcQueuePush(&queue, values) == prb_Failure);
+            for (i32 index = 0; index < 8; index++) {
+                prb_MpmcQueuePopResult pop = prb_mpmcQueuePop(&queue);
+                prb_assert(pop.success && pop.value == values + index);
+            }
+            prb_assert(!prb_mpmcQueuePop(&queue).success);
+        }
+    }
+
+    // NOTE(khvorov) Small queue so that producers keep running into a full one
+    {
+        prb_MpmcQueue queue = prb_createMpmcQueue(arena, 16);
+        i32           totalCount = 40000;
+        i32*          seen = prb_arenaAllocArray(arena, i32, totalCount);
+        i32           poppedCount = 0;
+        i32           producerCount = 4;
+        i32           consumerCount = 3;
+        QueueJobData* data = prb_arenaAllocArray(arena, QueueJobData, producerCount + consumerCount);
+        prb_Job*      jobs = prb_arenaAllocArray(arena, prb_Job, producerCount + consumerCount);
+        for (i32 jobIndex = 0; jobIndex < producerCount + consumerCount; jobIndex++) {
+            QueueJobData* job = data + jobIndex;
+            job->queue = &queue;
+            job->seen = seen;
+            job->poppedCount = &poppedCount;
+            job->totalCount = totalCount;
+            if (jobIndex < producerCount) {
+                job->from = totalCount / producerCount * jobIndex;
+                job->to = totalCount / producerCount * (jobIndex + 1);
+                jobs[jobIndex] = prb_createJob(queueProducerJob, job, arena, 0);
+            } else {
+                jobs[jobIndex] = prb_createJob(queueConsumerJob, job, arena, 0);
+            }
+        }
+        prb_assert(prb_launchJobs(jobs, producerCount + consumerCount, prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, producerCount + consumerCount));
+        prb_assert(poppedCount == totalCount);
+        for (i32 index = 0; index < totalCount; index++) {
+            prb_assert(seen[index] == 1);
+        }
+        prb_assert(!prb_mpmcQueuePop(&queue).success);
+    }
+
+    prb_endTempMemory(temp);
+}
+
+typedef struct SyncJobData {
+    prb_Mutex*     mutex;
+    prb_Semaphore* sem;
+    prb_Event*     event;
+    prb_Latch*     latch;
+    i32*           counter;
+    i32            iterations;
+} SyncJobData;
+
+// NOTE(khvorov) Plain increments, only correct if the mutex works
+function void
+mutexIncrementJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    SyncJobData* job = (SyncJobData*)data;
+    for (i32 index = 0; index < job->iterations; index++) {
+        prb_mutexLock(job->mutex);
+        *job->counter += 1;
+        prb_mutexUnlock(job->mutex);
+    }
+}
+
+function void
+test_mutex(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    {
+        prb_Mutex mutex = {};
+        prb_assert(prb_mutexTryLock(&mutex));
+        prb_assert(prb_mutexTryLock(&mutex) == prb_Failure);
+        prb_mutexUnlock(&mutex);
+        prb_mutexLock(&mutex);
+        prb_assert(mutex.state == 1);
+        prb_mutexUnlock(&mutex);
+        prb_assert(mutex.state == 0);
+    }
+
+    // NOTE(khvorov) Somebody blocked on the mutex marks it as contended and stays blocked until the unlock
+    {
+        prb_Mutex   mutex = {};
+        i32         counter = 0;
+        SyncJobData data = {&mutex, 0, 0, 0, &counter, 1};
+        prb_mutexLock(&mutex);
+        prb_Job job = prb_createJob(mutexIncrementJob, &data, arena, 0);
+        prb_assert(prb_launchJobs(&job, 1, prb_Background_Yes));
+        while (prb_atomicLoadI32(&mutex.state, prb_MemoryOrder_Acquire) != 2) {
+            prb_sleep(1);
+        }
+        prb_sleep(20);
+        prb_assert(counter == 0);
+        prb_mutexUnlock(&mutex);
+        prb_assert(prb_waitForJobs(&job, 1));
+        prb_assert(counter == 1 && mutex.state == 0);
+    }
+
+    {
+        prb_Mutex   mutex = {};
+        i32         counter = 0;
+        SyncJobData data = {&mutex, 0, 0, 0, &counter, 20000};
+        prb_Job     jobs[4] = {};
+        for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+            jobs[jobIndex] = prb_createJob(mutexIncrementJob, &data, arena, 0);
+        }
+        prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+        prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+        prb_assert(counter == data.iterations * prb_arrayCount(jobs));
+        prb_assert(mutex.state == 0);
+    }
+
+    prb_endTempMemory(temp);
+}
+
+function void
+semaphoreWaitJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    SyncJobData* job = (SyncJobData*)data;
+    for (i32 index = 0; index < job->iterations; index++) {
+        prb_semaphoreWait(job->sem);
+        prb_atomicFetchAddI32(job->counter, 1, prb_MemoryOrder_Relaxed);
+    }
+}
+
+function void
+test_semaphore(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    {
+        prb_Semaphore sem = prb_createSemaphore(2);
+        prb_assert(prb_semaphoreTryWait(&sem));
+        prb_semaphoreWait(&sem);
+        prb_assert(prb_semaphoreTryWait(&sem) == prb_Failure);
+        prb_semaphorePost(&sem, 3);
+        prb_assert(sem.count == 3);
+        for (i32 index = 0; index < 3; index++) {
+            prb_assert(prb_semaphoreTryWait(&sem));
+        }
+        prb_assert(prb_semaphoreTryWait(&sem) == prb_Failure);
+    }
+
+    // NOTE(khvorov) Waiters only get through as many times as there were posts
+    {
+        prb_Semaphore sem = prb_createSemaphore(0);
+        i32           counter = 0;
+        SyncJobData   data = {0, &sem, 0, 0, &counter, 1000};
+        prb_Job       jobs[3] = {};
+        for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+            jobs[jobIndex] = prb_createJob(semaphoreWaitJob, &data, arena, 0);
+        }
+        prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+
+        prb_semaphorePost(&sem, 5);
+        while (prb_atomicLoadI32(&counter, prb_MemoryOrder_Relaxed) != 5) {
+            prb_sleep(1);
+        }
+        prb_sleep(20);
+        prb_assert(prb_atomicLoadI32(&counter, prb_MemoryOrder_Relaxed) == 5);
+
+        i32 total = data.iterations * prb_arrayCount(jobs);
+        for (i32 posted = 5; posted < total; posted++) {
+            prb_semaphorePost(&sem, 1);
+        }
+        prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+        prb_assert(counter == total && sem.count == 0);
+    }
+
+    prb_endTempMemory(temp);
+}
+
+function void
+eventWaitJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    SyncJobData* job = (SyncJobData*)data;
+    prb_eventWait(job->event);
+    prb_atomicFetchAddI32(job->counter, 1, prb_MemoryOrder_Relaxed);
+}
+
+function void
+test_event(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    prb_Event   event = {};
+    i32         counter = 0;
+    SyncJobData data = {0, 0, &event, 0, &counter, 0};
+    prb_Job     jobs[3] = {};
+    for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+        jobs[jobIndex] = prb_createJob(eventWaitJob, &data, arena, 0);
+    }
+    prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+
+    while (prb_atomicLoadI32(&event.state, prb_MemoryOrder_Acquire) != 2) {
+        prb_sleep(1);
+    }
+    prb_sleep(20);
+    prb_assert(!prb_eventIsSet(&event));
+    prb_assert(prb_atomicLoadI32(&counter, prb_MemoryOrder_Relaxed) == 0);
+
+    prb_eventSet(&event);
+    prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+    prb_assert(counter == prb_arrayCount(jobs));
+
+    // NOTE(khvorov) Stays set until reset
+    prb_assert(prb_eventIsSet(&event));
+    prb_eventWait(&event);
+    prb_eventReset(&event);
+    prb_assert(!prb_eventIsSet(&event) && event.state == 0);
+    prb_eventSet(&event);
+    prb_eventWait(&event);
+
+    prb_endTempMemory(temp);
+}
+
+function void
+latchJob(prb_Arena* arena, void* data) {
+    prb_unused(arena);
+    SyncJobData* job = (SyncJobData*)data;
+    prb_atomicFetchAddI32(job->counter, 1, prb_MemoryOrder_Relaxed);
+    prb_latchCountDown(job->latch, 1);
+    prb_latchWait(job->latch);
+}
+
+function void
+test_latch(prb_Arena* arena) {
+    prb_TempMemory temp = prb_beginTempMemory(arena);
+
+    {
+        prb_Latch latch = prb_createLatch(0);
+        prb_latchWait(&latch);
+        latch = prb_createLatch(3);
+        prb_latchCountDown(&latch, 2);
+        prb_assert(latch.count == 1);
+        prb_latchCountDown(&latch, 1);
+        prb_latchWait(&latch);
+    }
+
+    // NOTE(khvorov) Everyone is past their increment by the time anyone gets out
+    {
+        prb_Latch   latch = prb_createLatch(5);
+        i32         counter = 0;
+        SyncJobData data = {0, 0, 0, &latch, &counter, 0};
+        prb_Job     jobs[4] = {};
+        for (i32 jobIndex = 0; jobIndex < prb_arrayCount(jobs); jobIndex++) {
+            jobs[jobIndex] = prb_createJob(latchJob, &data, arena, 0);
+        }
+        prb_assert(prb_launchJobs(jobs, prb_arrayCount(jobs), prb_Background_Yes));
+        while (prb_atomicLoadI32(&latch.count, prb_MemoryOrder_Acquire) != 1) {
+            prb_sleep(1);
+        }
+        prb_assert(prb_atomicLoadI32(&counter, prb_MemoryOrder_Relaxed) == prb_arrayCount(jobs));
+        prb_latchCountDown(&latch, 1);
+        prb_latchWait(&latch);
+        prb_assert(prb_waitForJobs(jobs, prb_arrayCount(jobs)));
+        prb_assert(latch.count == 0);
+    }
+
+    prb_endTempMemory(temp);
+}
+
 // SECTION Random numbers
 
 function void
@@ -3156,6 +5820,7 @@ main(void) {
     test_readEntireFile(arena);
     test_writeEntireFile(arena);
     test_getFileHash(arena);
+    test_hashStream(arena);
 
     // SECTION Strings
     test_streq(arena);
@@ -3182,17 +5847,44 @@ main(void) {
     test_getCmdline(arena);
     test_getCmdArgs(arena);
     test_getArgArrayFromStr(arena);
+    test_createArgv(arena);
+    test_argvConcat(arena);
+    test_argvToStr(arena);
+    test_findExecutable(arena);
     test_executionOnCores(arena);
     test_process(arena);
+    test_createProcessArgv(arena);
+    test_getProcessUsage(arena);
+    test_getMemoryInfo(arena);
+    test_getProcessMemory(arena);
+    test_getSystemLoad(arena);
+    test_launchProcessPool(arena);
+    test_launchPipeline(arena);
+    test_launchProcessesOnThreads(arena);
+    test_processCompletionIter(arena);
+    test_waitForAnyProcess(arena);
+    test_writeBufferedOutput(arena);
+    test_workerPool(arena);
+    test_jobserver(arena);
     test_sleep(arena);
     test_debuggerPresent(arena);
     test_env(arena);
+    test_createEnv(arena);
 
     // SECTION Timing
     test_timer(arena);
 
     // SECTION Multithreading
+    test_atomics(arena);
     test_jobs(arena);
+    test_threadPool(arena);
+    test_jobGraph(arena);
+    test_parallelFor(arena);
+    test_mpmcQueue(arena);
+    test_mutex(arena);
+    test_semaphore(arena);
+    test_event(arena);
+    test_latch(arena);
 
     // SECTION Random numbers
     test_createRng(arena);